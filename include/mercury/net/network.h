@@ -11,6 +11,7 @@
 
 #include <sys/types.h>          /* See NOTES */
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 
 namespace mercury  {
@@ -181,6 +182,9 @@ namespace net {
         const InetAddress * address() const;
         InetAddress * address();
 
+        /// 以C地址结构重新赋值，地址族不变时原地修改，用于批量接收时填写来源地址。
+        void assign(const struct sockaddr *paddr, socklen_t addrlen);
+
     public:
         virtual int domain() const ;
         virtual struct sockaddr * caddr() ;
@@ -237,6 +241,12 @@ namespace net {
         int  get_reuse_addr(RuntimeError &e) const;
         int  get_reuse_addr() const;
 
+        /*
+         * 设置和获取SO_REUSEPORT参数，须在bind之前设置。
+         */
+        bool set_reuse_port(int on, RuntimeError &e);
+        int  get_reuse_port(RuntimeError &e) const;
+
         /*
          * 设置和获取Socket阻塞模式。get_block_mode返回0表示非阻塞，返回1表示阻塞，-1表示操作失败。
          */
@@ -256,6 +266,17 @@ namespace net {
         StreamSocket * accept(RuntimeError &e);
         bool  accept(StreamSocket &sock, RuntimeError &e);
 
+        /**
+         * @brief 以accept4批量接受连接，直到填满socks或者没有等待的连接(EAGAIN)。
+         * @param socks 调用者提供的n个未打开的StreamSocket，接受的连接依次填入前面的元素。
+         * @param flags accept4的标志，SOCK_NONBLOCK和SOCK_CLOEXEC的组合，省去单独的fcntl调用。
+         * @return 接受的连接数，0表示没有等待的连接；首个连接即失败时返回-1。
+         */
+        ssize_t accept_batch(StreamSocket **socks, size_t n, int flags, RuntimeError &e);
+
+        /// 接管以其它方式接受的连接fd(如io_uring的accept请求)，sock须未打开。
+        bool    adopt(int fd, StreamSocket &sock, RuntimeError &e);
+
         bool  create(int domain, RuntimeError &e);
         bool  listen(int backlog, RuntimeError &errinfo);
         
@@ -273,9 +294,51 @@ namespace net {
         virtual ~StreamSocket();
 
         bool    create(int domain, RuntimeError &e);
+        /**
+         * @brief 连接远端地址。非阻塞模式下连接未能立即完成时同样返回true，
+         * 此时is_connecting()为真，须在可写后调用finish_connect完成连接。
+         */
         bool    connect(const char *ip, int port, RuntimeError &e);
+
+        /// 完成非阻塞连接，返回1表示已连接，0表示仍在连接中，-1表示连接失败。
+        int     finish_connect(RuntimeError &e);
+
+        /// 发送均带MSG_NOSIGNAL，对端已关闭时返回-1(EPIPE)，不产生SIGPIPE。
         ssize_t send(const char *buf, size_t len, RuntimeError &e);
         ssize_t receive(char * buf, size_t len, RuntimeError &e);
+
+        /*
+         * 非阻塞模式下循环收发直到EAGAIN或缓存用尽，配合边沿触发的SelectionKey使用。
+         * receive_all返回-1(对端关闭或异常)时，已读取的数据仍在buf中，其长度由received输出。
+         */
+        ssize_t send_all(const char *buf, size_t len, RuntimeError &e);
+        ssize_t receive_all(char * buf, size_t len, size_t *received, RuntimeError &e);
+
+        /*
+         * 集中写入和分散读取，一次sendmsg/readv调用收发多段缓存，返回值含义与send/receive相同。
+         */
+        ssize_t sendv(const struct iovec *iov, int iovcnt, RuntimeError &e);
+        ssize_t receivev(const struct iovec *iov, int iovcnt, RuntimeError &e);
+
+        /*
+         * 零拷贝发送。须先以set_zerocopy开启SO_ZEROCOPY；发送返回后buf仍被内核引用，
+         * 直到read_zerocopy_completion读到覆盖本次发送序号的通知才可修改或释放。
+         * read_zerocopy_completion返回1表示读到序号区间[lo, hi]，0表示暂无通知，-1表示失败。
+         */
+        bool    set_zerocopy(int on, RuntimeError &e);
+        int     get_zerocopy(RuntimeError &e) const;
+        ssize_t send_zerocopy(const char *buf, size_t len, RuntimeError &e);
+        int     read_zerocopy_completion(uint32_t *lo, uint32_t *hi, bool *copied, RuntimeError &e);
+
+        /**
+         * @brief 把文件fd从offset起的len字节直接发送到socket，数据不经过用户空间。
+         * 普通文件使用sendfile，管道等不支持sendfile的fd经由内部管道splice(忽略offset)。
+         * 非阻塞socket写满时返回已发送的字节数，调用方前移offset、减少len后在可写时继续调用。
+         * sendfile和splice没有MSG_NOSIGNAL，对端已关闭时仍会产生SIGPIPE，使用前应忽略该信号。
+         * @return 本次发送的字节数，0表示发送缓冲已满或fd暂无数据，-1表示失败(含文件提前结束)。
+         */
+        ssize_t transfer_from(int fd, int64_t offset, size_t len, RuntimeError &e);
+
         bool    shutdown_input(RuntimeError &e);
         bool    shutdown_input();
         bool    shutdown_Output(RuntimeError &e);
@@ -310,37 +373,38 @@ namespace net {
         char *       m_buf;
         size_t       m_len;
         size_t       m_cap;
+        size_t       m_segsize;   // 分段长度，0表示不分段
         InetSocketAddress * m_endp;
 
     public:
-        DatagramPacket() : m_buf(nullptr), m_len(0), m_cap(0), m_endp(nullptr) {}
+        DatagramPacket() : m_buf(nullptr), m_len(0), m_cap(0), m_segsize(0), m_endp(nullptr) {}
 
-        DatagramPacket(char * buf, size_t len) : m_buf(buf), m_len(len), m_cap(len), m_endp(nullptr) {}
+        DatagramPacket(char * buf, size_t len) : m_buf(buf), m_len(len), m_cap(len), m_segsize(0), m_endp(nullptr) {}
         
         DatagramPacket(char * buf, size_t len, InetSocketAddress *endp)
-            : m_buf(buf), m_len(len), m_cap(len), m_endp(endp) {}
+            : m_buf(buf), m_len(len), m_cap(len), m_segsize(0), m_endp(endp) {}
         
         DatagramPacket(char * buf, size_t len, size_t cap)
-            : m_buf(buf), m_len(len), m_cap(cap), m_endp(nullptr) {}
+            : m_buf(buf), m_len(len), m_cap(cap), m_segsize(0), m_endp(nullptr) {}
 
         DatagramPacket(char * buf, size_t len, size_t cap, InetSocketAddress *endp)
-            : m_buf(buf), m_len(len), m_cap(cap), m_endp(nullptr) {}
+            : m_buf(buf), m_len(len), m_cap(cap), m_segsize(0), m_endp(endp) {}
 
         DatagramPacket(const DatagramPacket &other) 
-            : m_buf(other.m_buf), m_len(other.m_len), m_cap(other.m_cap), m_endp(other.m_endp) {}
+            : m_buf(other.m_buf), m_len(other.m_len), m_cap(other.m_cap), m_segsize(other.m_segsize), m_endp(other.m_endp) {}
 
         DatagramPacket(DatagramPacket &&other)
-            : m_buf(other.m_buf), m_len(other.m_len), m_cap(other.m_cap), m_endp(other.m_endp) 
+            : m_buf(other.m_buf), m_len(other.m_len), m_cap(other.m_cap), m_segsize(other.m_segsize), m_endp(other.m_endp) 
         {
             other.m_buf = nullptr;
             other.m_endp = nullptr;
-            other.m_len = other.m_cap  = 0;
+            other.m_len = other.m_cap = other.m_segsize = 0;
         }
 
         ~DatagramPacket() {
             m_buf = nullptr;
             m_endp = nullptr;
-            m_len = m_cap  = 0;
+            m_len = m_cap = m_segsize = 0;
         }
 
         DatagramPacket & operator=(const DatagramPacket &other) {
@@ -348,6 +412,7 @@ namespace net {
                 m_buf = other.m_buf;
                 m_len = other.m_len;
                 m_cap = other.m_cap;
+                m_segsize = other.m_segsize;
                 m_endp = other.m_endp;
             }
             return *this;
@@ -358,11 +423,12 @@ namespace net {
                 m_buf = other.m_buf;
                 m_len = other.m_len;
                 m_cap = other.m_cap;
+                m_segsize = other.m_segsize;
                 m_endp = other.m_endp;
 
                 other.m_buf = nullptr;
                 other.m_endp = nullptr;
-                other.m_len = other.m_cap  = 0;
+                other.m_len = other.m_cap = other.m_segsize = 0;
             }
             return *this;
         }
@@ -382,6 +448,13 @@ namespace net {
 
         void setbuflen(size_t len) { assert(len <= m_cap);  m_len = len; }
 
+        /**
+         * 分段长度(UDP GSO/GRO)。发送时非0表示由内核把缓存按此长度切分为多个报文，
+         * 接收时非0表示本报文是内核合并的多个报文，除最后一段外每段都是此长度，调用者可按此直接切分。
+         */
+        size_t segmentSize() const { return m_segsize; }
+        void   setSegmentSize(size_t size) { m_segsize = size; }
+
     }; // end class DatagramPacket
 
     /**
@@ -395,6 +468,39 @@ namespace net {
         bool    create(int domain, RuntimeError &e);
         ssize_t send(const DatagramPacket &data, RuntimeError &e);
         ssize_t receive(DatagramPacket *data, RuntimeError &e);
+
+        /**
+         * @brief 固定对端地址，之后发送的报文可不指定地址，且只接收来自该地址的报文。
+         */
+        bool    connect(const char *host, int port, RuntimeError &e);
+        bool    is_connected() const;
+
+        /**
+         * @brief 以sendmmsg批量发送packets[0, n)，报文有endpoint时发往该地址，否则发往已连接地址。
+         * @return 已发送的报文数，0表示非阻塞时发送缓冲已满，首个报文即失败时返回-1。
+         */
+        ssize_t send_batch(const DatagramPacket *packets, size_t n, RuntimeError &e);
+
+        /**
+         * @brief 以recvmmsg批量接收，与receive相同，数据追加在各报文已有数据之后。
+         * 来源地址原地写入各报文的endpoint，预先分配好endpoint时接收过程不分配堆内存。
+         * 阻塞模式下收到第一个报文后即返回，不等待填满n个报文。
+         * @return 接收的报文数，0表示非阻塞时没有报文，-1表示接收异常。
+         */
+        ssize_t receive_batch(DatagramPacket *packets, size_t n, RuntimeError &e);
+
+        /*
+         * 设置和获取UDP_SEGMENT，作为未指定segmentSize的报文的默认分段长度，0表示不分段。
+         */
+        bool    set_udp_segment(int size, RuntimeError &e);
+        int     get_udp_segment(RuntimeError &e) const;
+
+        /*
+         * 设置和获取UDP_GRO，开启后接收到的报文可能是合并后的大报文，分段长度见DatagramPacket::segmentSize。
+         */
+        bool    set_udp_gro(int on, RuntimeError &e);
+        int     get_udp_gro(RuntimeError &e) const;
+
         bool    is_closed();
     }; // end class DatagramSocket
 
@@ -1,11 +1,18 @@
 #pragma once
+#include <mercury/nio/buffer_pool.h>
 #include <cassert>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 
 namespace mercury {
 namespace nio {
 
+/**
+ * @brief 运行时确定的字节序，构造时算出是否需要交换，交换由编译器内建函数完成，
+ * 在x86上生成bswap指令，开启-mmovbe时可与读写合并为movbe。
+ * 字节序在编译期已知时使用StaticByteOrder，不需要交换的路径没有任何开销。
+ */
 class ByteOrder {
 public:
     enum {
@@ -13,90 +20,81 @@ public:
         BigEndian
     };
 
-private:
-    int m_endian;
-    int m_native;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    static const int NativeEndian = BigEndian;
+#else
+    static const int NativeEndian = LittleEndian;
+#endif
 
-public:
-    static ByteOrder native_order();
-    static int       native();
+private:
+    int  m_endian;
+    bool m_swap;
 
 public:
-    ByteOrder() : m_endian(native()), m_native(m_endian) {}
-    ByteOrder(int order) : m_endian(order), m_native(native()) {}
-    ~ByteOrder();
-
-    int16_t operator() (int16_t value) const { 
-        int16_t result = value;;
-        if ( m_endian != m_native ) {
-            char *p0 = (char*)&value;
-            char *p1 = (char*)&result;
-            p1[0] = p0[1];
-            p1[1] = p0[0];
-        }
-        return result;
-    }
+    static ByteOrder native_order() { return ByteOrder(NativeEndian); }
+    static int       native() { return NativeEndian; }
 
-    int32_t operator()(int32_t value) const {
-        int32_t result = value;;
-        if ( m_endian != m_native ) {
-            char *p0 = (char*)&value;
-            char *p1 = (char*)&result;
-            p1[0] = p0[3];
-            p1[1] = p0[2];
-            p1[2] = p0[1];
-            p1[3] = p0[0];
-        }
-        return result;
-    }
-    
-    int64_t operator()(int64_t value) const {
-        int64_t result = value;;
-        if ( m_endian != m_native ) {
-            char *p0 = (char*)&value;
-            char *p1 = (char*)&result;
-            p1[0] = p0[7];
-            p1[1] = p0[6];
-            p1[2] = p0[5];
-            p1[3] = p0[4];
-            p1[4] = p0[3];
-            p1[5] = p0[2];
-            p1[6] = p0[1];
-            p1[7] = p0[0];
-        }
-        return result;
+    static int16_t   swap(int16_t value) { return (int16_t)__builtin_bswap16((uint16_t)value); }
+    static int32_t   swap(int32_t value) { return (int32_t)__builtin_bswap32((uint32_t)value); }
+    static int64_t   swap(int64_t value) { return (int64_t)__builtin_bswap64((uint64_t)value); }
+    static float     swap(float value) {
+        uint32_t u;
+        memcpy(&u, &value, sizeof(u));
+        u = __builtin_bswap32(u);
+        memcpy(&value, &u, sizeof(u));
+        return value;
     }
-    
-    float   operator()(float value) const {
-        float result = value;;
-        if ( m_endian != m_native ) {
-            char *p0 = (char*)&value;
-            char *p1 = (char*)&result;
-            p1[0] = p0[3];
-            p1[1] = p0[2];
-            p1[2] = p0[1];
-            p1[3] = p0[0];
-        }
-        return result;
-    }
-    double  operator()(double value) const {
-        double result = value;;
-        if ( m_endian != m_native ) {
-            char *p0 = (char*)&value;
-            char *p1 = (char*)&result;
-            p1[0] = p0[7];
-            p1[1] = p0[6];
-            p1[2] = p0[5];
-            p1[3] = p0[4];
-            p1[4] = p0[3];
-            p1[5] = p0[2];
-            p1[6] = p0[1];
-            p1[7] = p0[0];
-        }
-        return result;
+    static double    swap(double value) {
+        uint64_t u;
+        memcpy(&u, &value, sizeof(u));
+        u = __builtin_bswap64(u);
+        memcpy(&value, &u, sizeof(u));
+        return value;
     }
+
+public:
+    ByteOrder() : m_endian(NativeEndian), m_swap(false) {}
+    ByteOrder(int order) : m_endian(order), m_swap(order != NativeEndian) {}
+
+    int     endian() const { return m_endian; }
+    bool    need_swap() const { return m_swap; }
+
+    int16_t operator()(int16_t value) const { return m_swap ? swap(value) : value; }
+    int32_t operator()(int32_t value) const { return m_swap ? swap(value) : value; }
+    int64_t operator()(int64_t value) const { return m_swap ? swap(value) : value; }
+    float   operator()(float value) const { return m_swap ? swap(value) : value; }
+    double  operator()(double value) const { return m_swap ? swap(value) : value; }
+
+    /// 批量读写数组时交换字节序使用的SIMD内核，"avx2"、"ssse3"或"scalar"。
+    static const char * swap_kernel();
 }; // end class ByteOrder
 
+/**
+ * @brief 编译期确定的字节序，作为ByteBuffer类型化读写模板的参数，
+ * 例如buf.get_int32<BigEndianOrder>()。与本机字节序相同时转换为空操作。
+ */
+template<int Endian>
+struct StaticByteOrder {
+    static const int  Order = Endian;
+    static const bool Swap  = Endian != ByteOrder::NativeEndian;
+
+    template<class T>
+    static T apply(T value) { return Swap ? ByteOrder::swap(value) : value; }
+}; // end struct StaticByteOrder
+
+typedef StaticByteOrder<ByteOrder::BigEndian>    BigEndianOrder;
+typedef StaticByteOrder<ByteOrder::LittleEndian> LittleEndianOrder;
+typedef StaticByteOrder<ByteOrder::NativeEndian> NativeOrder;
+
+/**
+ * @brief 非对齐的类型化读写，供内联的读写模板使用。
+ * 以memcpy按字符访问，可与缓存上其它类型的读写重叠，-O2下编译为一次非对齐的mov。
+ */
+template<class T>
+struct Unaligned {
+    static T    load(const void *p) { T value; memcpy(&value, p, sizeof(T)); return value; }
+    static void store(void *p, T value) { memcpy(p, &value, sizeof(T)); }
+}; // end struct Unaligned
 
 class Buffer {
 protected:
@@ -107,11 +105,12 @@ protected:
     size_t m_mark;
 
 protected:
+    /// index为字节偏移。
     template<class T>
-    const T * get(size_t index) const { assert(index < m_cap); return (const T*)m_buf + index; }
+    const T * get(size_t index) const { assert(index < m_cap); return (const T*)((const char*)m_buf + index); }
 
     template<class T>
-    T * get(size_t index) { assert(index < m_cap); return (T*)m_buf + index; }
+    T * get(size_t index) { assert(index < m_cap); return (T*)((char*)m_buf + index); }
 
 protected:
     Buffer() : m_buf(nullptr), m_cap(0), m_pos(0), m_lim(0), m_mark(0) {}
@@ -137,7 +136,7 @@ public:
     void   mark() { m_mark = m_pos; }
 
     size_t position() const { return m_pos; }
-    void   position(size_t newpos ) { assert(newpos < m_lim); m_pos = newpos; }
+    void   position(size_t newpos ) { assert(newpos <= m_lim); m_pos = newpos; }
 
     size_t remaining() const { return m_lim - m_pos; }
     
@@ -145,23 +144,69 @@ public:
     void   rewind() { m_pos = m_mark = 0; }
 }; // end class Buffer
 
+template<class Policy, class Order> class ByteBufferCursor;
+
+/**
+ * @brief 字节缓存。可以包装调用方提供的内存，也可以由allocate从BufferPool分配，
+ * 分配的内存由引用计数管理，复制ByteBuffer共享同一块内存，最后一个引用析构时归还缓存池。
+ * slice、duplicate和as_read_only得到共享内存的视图，各视图有独立的position、limit和mark，
+ * 视图可以交给其它线程，原缓存析构后视图仍然有效。
+ */
 class ByteBuffer : public Buffer {
+    template<class Policy, class Order> friend class ByteBufferCursor;
+
 public:
+    /**
+     * @brief 从BufferPool分配容量为cap的缓存，实际内存按2的幂尺寸类向上取整。
+     * 返回的对象析构时内存自动归还缓存池，可在任意线程析构。
+     */
     static ByteBuffer allocate(size_t cap);
 
 protected:
-    ByteOrder  m_ord;
+    ByteOrder     m_ord;
+    BufferBlock * m_block;   // 池化内存，nullptr表示内存由调用方管理
+    bool          m_readonly;
 
 public:
-    ByteBuffer() {}
-    ByteBuffer(const ByteOrder &order) : m_ord(order) {}
-    ByteBuffer(char *buf, size_t cap) : Buffer(buf,cap) {}
-    ByteBuffer(char *buf, size_t cap, const ByteOrder &order) : Buffer(buf, cap), m_ord(order) {}
-    virtual ~ByteBuffer() {}
+    ByteBuffer() : m_block(nullptr), m_readonly(false) {}
+    ByteBuffer(const ByteOrder &order) : m_ord(order), m_block(nullptr), m_readonly(false) {}
+    ByteBuffer(char *buf, size_t cap) : Buffer(buf,cap), m_block(nullptr), m_readonly(false) {}
+    ByteBuffer(char *buf, size_t cap, const ByteOrder &order)
+        : Buffer(buf, cap), m_ord(order), m_block(nullptr), m_readonly(false) {}
+    ByteBuffer(const ByteBuffer &other);
+    ByteBuffer(ByteBuffer &&other);
+    virtual ~ByteBuffer();
+
+    ByteBuffer & operator=(const ByteBuffer &other);
+    ByteBuffer & operator=(ByteBuffer &&other);
+
+    /// 是否由allocate分配。
+    bool         is_pooled() const { return m_block != nullptr; }
+    /// 池化内存是否还被其它ByteBuffer（如slice得到的视图）引用。
+    bool         is_shared() const { return m_block && m_block->refs.load(std::memory_order_acquire) > 1; }
+
+    /**
+     * @brief 以[position, limit)区间创建视图，视图的position为0，limit和capacity为remaining()。
+     * 视图与本缓存共享内存和字节序，只读属性随之继承。
+     */
+    ByteBuffer   slice() const;
+    /// 以[idx, idx + len)区间创建视图，不改变本缓存的position。
+    ByteBuffer   slice(size_t idx, size_t len) const;
+    /// 共享全部内存的视图，position、limit和mark与本缓存相同。
+    ByteBuffer   duplicate() const { return ByteBuffer(*this); }
+    /// 只读视图，在其上调用put系列方法将触发断言。
+    ByteBuffer   as_read_only() const;
+    bool         is_read_only() const { return m_readonly; }
 
     ByteOrder    order() const { return m_ord; }
     void         order(const ByteOrder &order) { m_ord = order; }
 
+    /**
+     * @brief 把[position, limit)区间的数据移到缓存开头，position置为移动的字节数，
+     * limit置为容量，mark失效。读取到不完整的帧后调用，保留尾部继续接收。
+     */
+    void         compact();
+
     const char * ptr() const { return Buffer::get<char>(Buffer::position()); }
     char *       ptr() { return Buffer::get<char>(Buffer::position()); }
 
@@ -200,6 +245,138 @@ public:
     void         put_double(double value);
     void         put_double(size_t idx, double value);
 
+    /**
+     * @brief 批量读写n个元素，字节序与order()相同时为一次memcpy，
+     * 否则由SIMD内核在复制的同时交换字节序。剩余空间必须容纳n个元素。
+     */
+    void         get_int16s(int16_t *array, size_t n);
+    void         get_int16s(size_t idx, int16_t *array, size_t n) const;
+    void         get_int32s(int32_t *array, size_t n);
+    void         get_int32s(size_t idx, int32_t *array, size_t n) const;
+    void         get_int64s(int64_t *array, size_t n);
+    void         get_int64s(size_t idx, int64_t *array, size_t n) const;
+    void         get_floats(float *array, size_t n);
+    void         get_floats(size_t idx, float *array, size_t n) const;
+    void         get_doubles(double *array, size_t n);
+    void         get_doubles(size_t idx, double *array, size_t n) const;
+
+    void         put_int16s(const int16_t *array, size_t n);
+    void         put_int16s(size_t idx, const int16_t *array, size_t n);
+    void         put_int32s(const int32_t *array, size_t n);
+    void         put_int32s(size_t idx, const int32_t *array, size_t n);
+    void         put_int64s(const int64_t *array, size_t n);
+    void         put_int64s(size_t idx, const int64_t *array, size_t n);
+    void         put_floats(const float *array, size_t n);
+    void         put_floats(size_t idx, const float *array, size_t n);
+    void         put_doubles(const double *array, size_t n);
+    void         put_doubles(size_t idx, const double *array, size_t n);
+
+    /**
+     * @brief 以无符号LEB128变长编码读写整数，每字节7位，小于128的值只占1字节。
+     * 有符号整数先做zigzag编码，绝对值小的负数同样只占少量字节。
+     * 写入时剩余空间必须容纳编码，可用varint_size预先计算。
+     */
+    static size_t varint_size(uint64_t value);
+    void         put_varint(uint64_t value);
+    void         put_svarint(int64_t value);
+    /// 剩余数据不足一个完整编码，或编码超过10字节时返回false，position不变。
+    bool         get_varint(uint64_t &value);
+    bool         get_svarint(int64_t &value);
+
+    /// 批量编码，直到全部写入或剩余空间不足，返回写入的元素数。
+    size_t       put_varints(const uint64_t *array, size_t n);
+    size_t       put_svarints(const int64_t *array, size_t n);
+    /// 批量解码，直到解出n个或剩余数据不能构成完整编码，返回解出的元素数。
+    size_t       get_varints(uint64_t *array, size_t n);
+    size_t       get_svarints(int64_t *array, size_t n);
+
+    /**
+     * @brief 以编译期字节序Order读写，忽略order()的设置。函数在头文件中实现，
+     * 可以内联到调用处，读写编译为一次非对齐访问加上可能的bswap。
+     */
+    template<class Order> int16_t get_int16() { return this->load_next<int16_t, Order>(); }
+    template<class Order> int16_t get_int16(size_t idx) const { return this->load<int16_t, Order>(idx); }
+    template<class Order> int32_t get_int32() { return this->load_next<int32_t, Order>(); }
+    template<class Order> int32_t get_int32(size_t idx) const { return this->load<int32_t, Order>(idx); }
+    template<class Order> int64_t get_int64() { return this->load_next<int64_t, Order>(); }
+    template<class Order> int64_t get_int64(size_t idx) const { return this->load<int64_t, Order>(idx); }
+    template<class Order> float   get_float() { return this->load_next<float, Order>(); }
+    template<class Order> float   get_float(size_t idx) const { return this->load<float, Order>(idx); }
+    template<class Order> double  get_double() { return this->load_next<double, Order>(); }
+    template<class Order> double  get_double(size_t idx) const { return this->load<double, Order>(idx); }
+
+    template<class Order> void    put_int16(int16_t value) { this->store_next<int16_t, Order>(value); }
+    template<class Order> void    put_int16(size_t idx, int16_t value) { this->store<int16_t, Order>(idx, value); }
+    template<class Order> void    put_int32(int32_t value) { this->store_next<int32_t, Order>(value); }
+    template<class Order> void    put_int32(size_t idx, int32_t value) { this->store<int32_t, Order>(idx, value); }
+    template<class Order> void    put_int64(int64_t value) { this->store_next<int64_t, Order>(value); }
+    template<class Order> void    put_int64(size_t idx, int64_t value) { this->store<int64_t, Order>(idx, value); }
+    template<class Order> void    put_float(float value) { this->store_next<float, Order>(value); }
+    template<class Order> void    put_float(size_t idx, float value) { this->store<float, Order>(idx, value); }
+    template<class Order> void    put_double(double value) { this->store_next<double, Order>(value); }
+    template<class Order> void    put_double(size_t idx, double value) { this->store<double, Order>(idx, value); }
+
+private:
+    /// 当前position后移len字节，返回移动前的position。
+    size_t advance(size_t len) {
+        assert( Buffer::remaining() >= len );
+        size_t idx = m_pos;
+        m_pos += len;
+        return idx;
+    }
+
+    /**
+     * @brief 读写position处的值并后移position。基址和位置先取到局部变量，position在写入数据之后才更新：
+     * 数据按字符写入，编译器须假定它可能改写m_buf/m_pos，先写数据后写m_pos，
+     * 连续调用时下一次的m_pos可直接沿用寄存器中的值，只需重新加载m_buf。
+     */
+    template<class T, class Order>
+    T load_next() {
+        assert( Buffer::remaining() >= sizeof(T) );
+        size_t pos = m_pos;
+        T value = Order::apply(Unaligned<T>::load((const char *)m_buf + pos));
+        m_pos = pos + sizeof(T);
+        return value;
+    }
+
+    template<class T, class Order>
+    void store_next(T value) {
+        assert( !m_readonly );
+        assert( Buffer::remaining() >= sizeof(T) );
+        char * base = (char *)m_buf;
+        size_t pos = m_pos;
+        Unaligned<T>::store(base + pos, Order::apply(value));
+        m_pos = pos + sizeof(T);
+    }
+
+    template<class T, class Order>
+    T load(size_t idx) const {
+        assert( Buffer::limit() - idx >= sizeof(T) );
+        return Order::apply(Unaligned<T>::load((const char *)m_buf + idx));
+    }
+
+    template<class T, class Order>
+    void store(size_t idx, T value) {
+        assert( !m_readonly );
+        assert( Buffer::limit() - idx >= sizeof(T) );
+        Unaligned<T>::store((char *)m_buf + idx, Order::apply(value));
+    }
+
+    void load_array(size_t idx, void *array, size_t n, size_t width) const;
+    void store_array(size_t idx, const void *array, size_t n, size_t width);
+
+    template<class T>
+    T load(size_t idx) const {
+        assert( Buffer::limit() - idx >= sizeof(T) );
+        return m_ord(Unaligned<T>::load((const char *)m_buf + idx));
+    }
+
+    template<class T>
+    void store(size_t idx, T value) {
+        assert( !m_readonly );
+        assert( Buffer::limit() - idx >= sizeof(T) );
+        Unaligned<T>::store((char *)m_buf + idx, m_ord(value));
+    }
 }; // end class ByteBuffer
 
 }} // end namespace mercury::nio
\ No newline at end of file
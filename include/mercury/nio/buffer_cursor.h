@@ -0,0 +1,163 @@
+#pragma once
+#include <mercury/error.h>
+#include <mercury/nio/buffer.h>
+
+namespace mercury {
+namespace nio {
+
+/// 不检查的访问策略：批量读写前以ensure检查一次，之后每次访问只移动指针，越界只由assert发现。
+struct UncheckedAccess { static const bool Checked = false; };
+
+/// 检查的访问策略：每次访问都检查边界，越界或写只读缓存时记录RuntimeError，之后的访问全部失败。
+struct CheckedAccess { static const bool Checked = true; };
+
+/// 游标越界时设置错误，位于冷路径，不内联。
+void cursor_overflow(RuntimeError &e, const char *where, size_t need, size_t remain);
+/// 游标写只读缓存时设置错误，位于冷路径，不内联。
+void cursor_readonly(RuntimeError &e, const char *where);
+
+/**
+ * @brief ByteBuffer的游标，以本地指针读写[position, limit)区间，全部访问在头文件中内联。
+ * 读写过程中不更新缓存的position，commit或析构时写回。游标存在期间不应通过其它方式修改缓存。
+ *
+ * UncheckedAccess用于热循环：先以ensure(n)一次确认后续n字节的读写不会越界，再连续读写。
+ * CheckedAccess用于解析不可信的数据：每次访问都检查，越界时返回0并记录错误，写只读缓存同样记录错误，
+ * 错误是粘滞的，一批读取完成后调用ok()检查一次即可。
+ * 字节序Order在编译期确定，默认为本机字节序。
+ */
+template<class Policy, class Order = NativeOrder>
+class ByteBufferCursor {
+private:
+    ByteBuffer   & m_buf;
+    char         * m_base;
+    char         * m_ptr;
+    char         * m_end;
+    RuntimeError * m_err;
+    bool           m_failed;
+
+public:
+    /// 创建不检查的游标。
+    explicit ByteBufferCursor(ByteBuffer &buf)
+        : m_buf(buf), m_base((char *)buf.m_buf), m_ptr(m_base + buf.m_pos), m_end(m_base + buf.m_lim)
+        , m_err(nullptr), m_failed(false)
+    {
+        static_assert( !Policy::Checked, "checked cursor requires a RuntimeError" );
+    }
+
+    /// 创建检查的游标，越界错误记录到e。
+    ByteBufferCursor(ByteBuffer &buf, RuntimeError &e)
+        : m_buf(buf), m_base((char *)buf.m_buf), m_ptr(m_base + buf.m_pos), m_end(m_base + buf.m_lim)
+        , m_err(&e), m_failed(false)
+    {}
+
+    ByteBufferCursor(const ByteBufferCursor &) = delete;
+    ByteBufferCursor & operator=(const ByteBufferCursor &) = delete;
+
+    ~ByteBufferCursor() { this->commit(); }
+
+    /// 把游标位置写回缓存的position。
+    void     commit() { m_buf.m_pos = (size_t)(m_ptr - m_base); }
+
+    size_t   position() const { return (size_t)(m_ptr - m_base); }
+    size_t   remaining() const { return (size_t)(m_end - m_ptr); }
+
+    /// 是否未发生越界。不检查的游标始终返回true。
+    bool     ok() const { return !m_failed; }
+
+    /**
+     * @brief 确认剩余空间不少于n字节。不检查的游标在此之后的n字节访问不再检查。
+     * 检查的游标不足时记录错误。
+     */
+    bool     ensure(size_t n) {
+        if ( this->remaining() >= n ) return true;
+        if ( Policy::Checked ) this->fail("ByteBufferCursor::ensure", n);
+        return false;
+    }
+
+    void     skip(size_t n) { if ( this->check(n, "ByteBufferCursor::skip") ) m_ptr += n; }
+
+    int16_t  get_int16() { return this->load<int16_t>("ByteBufferCursor::get_int16"); }
+    int32_t  get_int32() { return this->load<int32_t>("ByteBufferCursor::get_int32"); }
+    int64_t  get_int64() { return this->load<int64_t>("ByteBufferCursor::get_int64"); }
+    float    get_float() { return this->load<float>("ByteBufferCursor::get_float"); }
+    double   get_double() { return this->load<double>("ByteBufferCursor::get_double"); }
+
+    char     get() {
+        if ( !this->check(1, "ByteBufferCursor::get") ) return 0;
+        return *m_ptr++;
+    }
+
+    /// 读取len字节，越界时不读取任何数据并返回false。
+    bool     get(char *array, size_t len) {
+        if ( !this->check(len, "ByteBufferCursor::get") ) return false;
+        memcpy(array, m_ptr, len);
+        m_ptr += len;
+        return true;
+    }
+
+    void     put_int16(int16_t value) { this->store<int16_t>(value, "ByteBufferCursor::put_int16"); }
+    void     put_int32(int32_t value) { this->store<int32_t>(value, "ByteBufferCursor::put_int32"); }
+    void     put_int64(int64_t value) { this->store<int64_t>(value, "ByteBufferCursor::put_int64"); }
+    void     put_float(float value) { this->store<float>(value, "ByteBufferCursor::put_float"); }
+    void     put_double(double value) { this->store<double>(value, "ByteBufferCursor::put_double"); }
+
+    void     put(char ch) {
+        if ( !this->check_write(1, "ByteBufferCursor::put") ) return;
+        *m_ptr++ = ch;
+    }
+
+    bool     put(const char *array, size_t len) {
+        if ( !this->check_write(len, "ByteBufferCursor::put") ) return false;
+        memcpy(m_ptr, array, len);
+        m_ptr += len;
+        return true;
+    }
+
+private:
+    bool     check(size_t n, const char *where) {
+        if ( !Policy::Checked ) {
+            assert( this->remaining() >= n );
+            return true;
+        }
+        if ( __builtin_expect(!m_failed && this->remaining() >= n, 1) ) return true;
+        this->fail(where, n);
+        return false;
+    }
+
+    /// 写入前的检查，检查的游标对只读缓存记录错误，不检查的游标只断言。
+    bool     check_write(size_t n, const char *where) {
+        if ( !Policy::Checked ) assert( !m_buf.m_readonly );
+        if ( Policy::Checked && __builtin_expect(m_buf.m_readonly, 0) ) {
+            if ( !m_failed && m_err ) cursor_readonly(*m_err, where);
+            m_failed = true;
+            return false;
+        }
+        return this->check(n, where);
+    }
+
+    void     fail(const char *where, size_t n) {
+        if ( m_failed ) return;
+        m_failed = true;
+        if ( m_err ) cursor_overflow(*m_err, where, n, this->remaining());
+    }
+
+    template<class T>
+    T        load(const char *where) {
+        if ( !this->check(sizeof(T), where) ) return T();
+        T value = Unaligned<T>::load(m_ptr);
+        m_ptr += sizeof(T);
+        return Order::apply(value);
+    }
+
+    template<class T>
+    void     store(T value, const char *where) {
+        if ( !this->check_write(sizeof(T), where) ) return;
+        Unaligned<T>::store(m_ptr, Order::apply(value));
+        m_ptr += sizeof(T);
+    }
+}; // end class ByteBufferCursor
+
+typedef ByteBufferCursor<UncheckedAccess> UncheckedCursor;
+typedef ByteBufferCursor<CheckedAccess>   CheckedCursor;
+
+}} // end namespace mercury::nio
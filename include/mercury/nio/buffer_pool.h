@@ -0,0 +1,65 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 池化内存块的头部，数据区紧随其后。
+ * 由BufferPool分配，引用计数降为0时归还BufferPool。
+ */
+struct BufferBlock {
+    std::atomic<uint32_t> refs;
+    uint32_t              cls;    // 尺寸类，BufferPool::LargeClass表示直接由malloc分配
+    size_t                size;   // 数据区大小
+    BufferBlock         * next;   // 空闲链表
+    uint64_t              pad;    // 使数据区按16字节对齐
+
+    char * data() { return (char *)(this + 1); }
+};
+
+/**
+ * @brief 按2的幂尺寸类管理的缓存池，ByteBuffer::allocate的内存来源。
+ * 每个线程为各尺寸类保留一个空闲链表，分配和释放通常不加锁。线程缓存超出上限时把一批块
+ * 交给全局仓库，线程缓存为空时从全局仓库取回一批，在一个线程分配、另一个线程释放的块
+ * 由此回到分配方。线程退出时其缓存全部交给全局仓库。
+ * 超过最大尺寸类的请求直接由malloc分配，释放时free。
+ */
+class BufferPool {
+public:
+    const static size_t MinClassBits = 6;    // 最小尺寸类64字节
+    const static size_t MaxClassBits = 20;   // 最大尺寸类1M字节
+    const static size_t Classes      = MaxClassBits - MinClassBits + 1;
+    const static uint32_t LargeClass = (uint32_t)Classes;
+    const static size_t CacheBytes   = 1 << 20;   // 每个尺寸类线程缓存的字节数上限
+    const static size_t DepotBytes   = 32 << 20;  // 每个尺寸类全局仓库的字节数上限
+    const static size_t MaxBatch     = 32;        // 线程缓存与全局仓库之间一次转移的块数上限
+
+    struct Stats {
+        uint64_t system_allocs;   // 向系统分配的块数
+        uint64_t system_frees;    // 归还系统的块数
+    };
+
+public:
+    /// 分配数据区不小于size的块，引用计数为1。
+    static BufferBlock * allocate(size_t size);
+
+    /// 引用计数加1。
+    static void          retain(BufferBlock *block) { block->refs.fetch_add(1, std::memory_order_relaxed); }
+
+    /// 引用计数减1，降为0时归还缓存池，可在任意线程调用。
+    static void          release(BufferBlock *block);
+
+    /// size所属的尺寸类，超过最大尺寸类时返回LargeClass。
+    static uint32_t      size_class(size_t size);
+    static size_t        class_size(uint32_t cls) { return (size_t)1 << (cls + MinClassBits); }
+
+    static Stats         stats();
+
+    /// 把当前线程缓存的块全部交给全局仓库，线程退出时自动执行。
+    static void          flush_thread_cache();
+}; // end class BufferPool
+
+}} // end namespace mercury::nio
@@ -0,0 +1,226 @@
+#pragma once
+#include <mercury/nio/selector.h>
+#include <mercury/nio/buffer.h>
+#include <mercury/nio/composite_buffer.h>
+#include <mercury/nio/ring_buffer.h>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 服务端监听通道。创建后即为非阻塞模式，可注册到Selector上关注OpAccept事件。
+ */
+class ServerSocketChannel : public SelectableChannel {
+private:
+    class ServerSocketChannelImpl;
+    ServerSocketChannelImpl * m_pSockImpl;
+
+public:
+    ServerSocketChannel();
+    virtual ~ServerSocketChannel();
+
+    bool create(int domain, RuntimeError &e);
+    bool close(RuntimeError &e);
+    bool bind(const char *addr, int port, RuntimeError &e);
+    bool listen(int backlog, RuntimeError &e);
+
+    /// 接受一个连接，新连接同样设置为非阻塞模式。
+    bool accept(net::StreamSocket &sock, RuntimeError &e);
+    bool accept(StreamSocketChannel &ch, RuntimeError &e);
+
+    /**
+     * @brief 一次就绪事件中批量接受连接，直到填满chs或者没有等待的连接。
+     * 新连接由accept4直接以非阻塞、close-on-exec方式创建。
+     * @param chs 调用者提供的n个未打开的通道，接受的连接依次填入前面的元素。
+     * @return 接受的连接数，0表示没有等待的连接，首个连接即失败时返回-1。
+     */
+    ssize_t accept_batch(StreamSocketChannel **chs, size_t n, RuntimeError &e);
+
+    /**
+     * @brief 完成模式接受连接，selector须为EngineUring。一次提交持续接受，每个新连接回调一次，
+     * res为非阻塞的连接fd，以adopt交给通道。通道未注册到selector时以空关注事件注册。
+     */
+    bool accept_async(Selector *selector, Completion *c, RuntimeError &e);
+
+    /// 接管accept_async得到的连接fd，ch须未打开。
+    bool adopt(int fd, StreamSocketChannel &ch, RuntimeError &e);
+
+    net::ServerSocket * socket();
+
+public:
+    virtual int fd() const;
+    virtual int valid_ops() const;
+}; // end class ServerSocketChannel
+
+/**
+ * @brief 面向数据流的通道，由ServerSocketChannel接受得到，可注册到Selector。
+ */
+class StreamSocketChannel : public SelectableChannel {
+public:
+    static const size_t MaxIov = 64;   // 一次readv/writev最多使用的缓存数
+    static const size_t ZeroCopyThreshold = 16384;   // 默认的零拷贝发送最小长度
+
+private:
+    class StreamSocketChannelImpl;
+    StreamSocketChannelImpl * m_pSockImpl;
+
+public:
+    StreamSocketChannel();
+    virtual ~StreamSocketChannel();
+
+    bool close(RuntimeError &e);
+    bool is_closed() const;
+
+    /// 创建非阻塞的socket，用于主动连接。
+    bool create(int domain, RuntimeError &e);
+
+    /**
+     * @brief 发起非阻塞连接，通道未创建时按地址格式创建IPv4或IPv6 socket。
+     * 连接未能立即完成时返回true且is_connection_pending()为真，之后关注OpConnect，
+     * 就绪后调用finish_connect。需要超时时对注册键设置SelectionKey::deadline，
+     * 以OpTimeout就绪时连接仍未完成即视为超时，关闭通道即可。
+     */
+    bool connect(const char *host, int port, RuntimeError &e);
+    int  finish_connect(RuntimeError &e);   // 1已连接，0仍在连接中，-1失败
+    bool is_connection_pending() const;
+    bool is_connected() const;
+
+    /**
+     * @brief 读取数据到buf的[position, limit)区间，position按读取的字节数前移。
+     * @return >0表示读取的字节数，0表示暂无数据或buf没有剩余空间，-1表示对端关闭或读取异常。
+     */
+    ssize_t read(ByteBuffer &buf, RuntimeError &e);
+
+    /**
+     * @brief 读取数据到环形缓存的可写空间，读取的字节数计入可读数据。
+     * @return 含义同read(ByteBuffer&)。
+     */
+    ssize_t read(RingByteBuffer &buf, RuntimeError &e);
+
+    /**
+     * @brief 写出buf的[position, limit)区间，position按写入的字节数前移。
+     * @return >=0表示写入的字节数，0表示发送缓冲已满，-1表示写入异常。
+     */
+    ssize_t write(ByteBuffer &buf, RuntimeError &e);
+
+    /**
+     * @brief 以一次writev写出组合缓存[position, limit)区间的各分段，position按写入的字节数前移。
+     * @return 含义同write(ByteBuffer&)。
+     */
+    ssize_t write(CompositeByteBuffer &buf, RuntimeError &e);
+
+    /**
+     * @brief 分散读取，一次readv把数据依次读入各缓存的[position, limit)区间。
+     * 各缓存的position按实际读取的字节数前移，一次最多使用MaxIov个非空缓存。
+     * @return >0表示读取的字节数，0表示暂无数据，-1表示对端关闭或读取异常。
+     */
+    ssize_t read(ByteBuffer **bufs, size_t n, RuntimeError &e);
+
+    /**
+     * @brief 集中写入，一次writev写出各缓存[position, limit)区间的数据，如消息头和消息体。
+     * 各缓存的position按实际写入的字节数前移，未写完的部分留待下一次可写时继续写。
+     * @return >=0表示写入的字节数，0表示发送缓冲已满，-1表示写入异常。
+     */
+    ssize_t write(ByteBuffer **bufs, size_t n, RuntimeError &e);
+
+    /**
+     * @brief 把文件fd从offset起的len字节直接发送到通道，见net::StreamSocket::transfer_from。
+     * 返回0时关注OpWrite，可写后以前移后的offset和剩余长度继续调用。
+     */
+    ssize_t transfer_from(int fd, int64_t offset, size_t len, RuntimeError &e);
+
+    /**
+     * @brief 开启零拷贝发送(SO_ZEROCOPY)。
+     * @param threshold 剩余长度不小于此值的write_zerocopy以MSG_ZEROCOPY发送，更小的直接复制发送，
+     *                  因为页面锁定和完成通知的开销在小报文上大于复制。
+     */
+    bool    zerocopy(size_t threshold, RuntimeError &e);
+    bool    is_zerocopy() const;
+    bool    is_zerocopy(size_t len) const;   // 长度为len的发送是否会走零拷贝路径
+
+    /**
+     * @brief 发送buf的[position, limit)区间，position按发送的字节数前移。
+     * 走零拷贝路径时buf的内存在tag由reap_zerocopy返回之前不能修改或释放，
+     * 注册键须关注SelectionKey::OpError以获知完成通知；复制路径返回后即可重用。
+     * @param tag 标识本次发送的缓存，同一缓存分多次发送时使用同一tag，不同缓存的tag应不同。
+     * @return 含义同write。
+     */
+    ssize_t write_zerocopy(ByteBuffer &buf, void *tag, RuntimeError &e);
+
+    /**
+     * @brief 读取错误队列中的完成通知，按发送顺序输出内存已可重用的缓存tag。
+     * @return 输出的tag数，-1表示失败(如连接异常)。
+     */
+    ssize_t reap_zerocopy(void **tags, size_t n, RuntimeError &e);
+
+    size_t   zerocopy_pending() const;   // 尚未完成的零拷贝发送次数
+    uint64_t zerocopy_copied() const;    // 被内核退回为复制发送的次数，持续增长时应提高阈值或关闭零拷贝
+
+    /**
+     * @brief 完成模式读取，selector须为EngineUring。一次提交持续读取，每次数据到达回调一次，
+     * 数据位于selector的接收缓存环中，见Completion::data和Selector::recv_buffers。
+     * 读到0(对端关闭)或出错时请求结束。通道未注册到selector时以空关注事件注册。
+     */
+    bool    read_async(Selector *selector, Completion *c, RuntimeError &e);
+
+    /**
+     * @brief 完成模式写出buf的[position, limit)区间，position不变，完成时res为写入的字节数，
+     * 调用方据此前移position，未写完时继续提交。完成之前buf的内容不能修改或释放。
+     */
+    bool    write_async(Selector *selector, const ByteBuffer &buf, Completion *c, RuntimeError &e);
+
+    net::StreamSocket * socket();
+
+public:
+    virtual int fd() const;
+    virtual int valid_ops() const;
+}; // end class StreamSocketChannel
+
+/**
+ * @brief 数据报通道，创建后即为非阻塞模式，可注册到Selector关注OpRead和OpWrite事件。
+ * 一次读写对应一个完整的报文。
+ */
+class DatagramSocketChannel : public SelectableChannel {
+private:
+    class DatagramSocketChannelImpl;
+    DatagramSocketChannelImpl * m_pSockImpl;
+
+public:
+    DatagramSocketChannel();
+    virtual ~DatagramSocketChannel();
+
+    bool create(int domain, RuntimeError &e);
+    bool close(RuntimeError &e);
+    bool is_closed() const;
+    bool bind(const char *addr, int port, RuntimeError &e);
+
+    /// 固定对端地址，之后可以使用read和write，通道未创建时按地址格式创建。
+    bool connect(const char *host, int port, RuntimeError &e);
+    bool is_connected() const;
+
+    /**
+     * @brief 接收一个报文到buf的[position, limit)区间，position按报文长度前移，
+     * 超出剩余空间的部分被丢弃。
+     * @param from 非空时输出报文来源地址。
+     * @return 报文长度，0表示暂无报文，-1表示接收异常。
+     */
+    ssize_t receive(ByteBuffer &buf, net::InetSocketAddress *from, RuntimeError &e);
+
+    /**
+     * @brief 把buf的[position, limit)区间作为一个报文发往to，成功后position移到limit。
+     * @return 发送的字节数，0表示发送缓冲已满，-1表示发送异常。
+     */
+    ssize_t send(ByteBuffer &buf, const net::InetSocketAddress &to, RuntimeError &e);
+
+    /// 已连接的通道上接收和发送报文，含义同receive和send。
+    ssize_t read(ByteBuffer &buf, RuntimeError &e);
+    ssize_t write(ByteBuffer &buf, RuntimeError &e);
+
+    net::DatagramSocket * socket();
+
+public:
+    virtual int fd() const;
+    virtual int valid_ops() const;
+}; // end class DatagramSocketChannel
+
+}} // end namespace mercury::nio
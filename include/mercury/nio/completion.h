@@ -0,0 +1,50 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mercury {
+namespace nio {
+
+class UringPoller;
+
+/**
+ * @brief 完成模式的异步操作，由通道的*_async方法提交到EngineUring的Selector，
+ * 内核完成后在select中回调on_complete。与就绪模式不同，读写由内核完成，
+ * 一个请求可以产生多次结果，select之外不需要任何accept/recv/send系统调用。
+ *
+ * 要求linux 6.0+：固定文件表与缓存环需要5.19，多发recv和按固定文件取消需要6.0，
+ * 5.19上read_async以-EINVAL结束。
+ *
+ * 对象由调用方持有，请求结束(is_pending()为false)之前不能释放或用于其它请求。
+ * 通道关闭时未结束的请求被取消，在之后的select中以-ECANCELED结束；
+ * Selector关闭时未结束的请求在close中立即以-ECANCELED结束，此时不能再提交新请求。
+ */
+class Completion {
+private:
+    int          m_pending;   // 内核中尚未结束的请求数
+    const char * m_data;      // 本次结果的接收缓存，只在on_complete中有效
+
+    friend class UringPoller;
+
+public:
+    Completion() : m_pending(0), m_data(nullptr) {}
+    Completion(const Completion &other) = delete;
+    virtual ~Completion() {}
+
+    Completion & operator=(const Completion &other) = delete;
+
+    bool is_pending() const { return m_pending > 0; }
+
+    /// read_async的结果数据，长度为on_complete的res，回调返回后缓存即归还缓存环。
+    const char * data() const { return m_data; }
+
+    /**
+     * @brief 完成回调，调用前结束的请求已不再计入is_pending，可在回调中重新提交或释放本对象。
+     * @param res  >=0表示成功：accept_async为新连接的fd，read_async为读取的字节数(0表示对端关闭)，
+     *             write_async为写入的字节数。<0为-errno。
+     * @param more 多次触发的请求仍然有效，之后还有结果；为false时请求已结束，需要时重新提交。
+     */
+    virtual void on_complete(int res, bool more) = 0;
+}; // end class Completion
+
+}} // end namespace mercury::nio
@@ -0,0 +1,94 @@
+#pragma once
+#include <mercury/nio/buffer.h>
+#include <sys/uio.h>
+#include <vector>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 组合缓存，把多个ByteBuffer分段串联为一个逻辑缓存。
+ * 加入的分段是原缓存[position, limit)区间的视图，不复制数据，池化内存由引用计数保持有效。
+ * 逻辑缓存的position、limit和mark与Buffer相同，类型化读写可以跨越分段边界。
+ * 编码时可以在消息体前后加入消息头和尾，再以iovecs导出交给writev，无需重新分配和移动消息体。
+ */
+class CompositeByteBuffer : public Buffer {
+private:
+    struct Segment {
+        ByteBuffer buf;
+        size_t     offset;   // 分段在逻辑缓存中的起始位置
+    };
+
+    std::vector<Segment> m_segs;
+    ByteOrder            m_ord;
+    mutable size_t       m_last;   // 最近访问的分段，顺序读写时免去查找
+
+public:
+    CompositeByteBuffer() : m_last(0) {}
+    CompositeByteBuffer(const ByteOrder &order) : m_ord(order), m_last(0) {}
+    virtual ~CompositeByteBuffer() {}
+
+    ByteOrder    order() const { return m_ord; }
+    void         order(const ByteOrder &order) { m_ord = order; }
+
+    /**
+     * @brief 在末尾或开头加入seg的[position, limit)区间，容量和limit随之增加。
+     * prepend不改变position，position为0时新加入的分段即为下一次读取的内容。没有剩余数据的seg被忽略。
+     */
+    void         append(const ByteBuffer &seg);
+    void         prepend(const ByteBuffer &seg);
+
+    /// 移除全部分段，position、limit和容量归0。
+    void         remove_all();
+
+    size_t       segments() const { return m_segs.size(); }
+    const ByteBuffer & segment(size_t i) const { return m_segs[i].buf; }
+
+    /**
+     * @brief 以[position, limit)区间生成iovec，最多n个，跳过空的分段。
+     * @return 生成的iovec数。
+     */
+    size_t       iovecs(struct iovec *iov, size_t n) const;
+
+    char         get();
+    char         get(size_t idx) const;
+    size_t       get(char *array, size_t len);
+    size_t       get(size_t idx, char *array, size_t len) const;
+
+    int16_t      get_int16();
+    int16_t      get_int16(size_t idx) const;
+    int32_t      get_int32();
+    int32_t      get_int32(size_t idx) const;
+    int64_t      get_int64();
+    int64_t      get_int64(size_t idx) const;
+    float        get_float();
+    float        get_float(size_t idx) const;
+    double       get_double();
+    double       get_double(size_t idx) const;
+
+    void         put(char ch);
+    void         put(size_t idx, char ch);
+    void         put(const char *array, size_t len);
+    void         put(size_t idx, const char *array, size_t len);
+
+    void         put_int16(int16_t value);
+    void         put_int16(size_t idx, int16_t value);
+    void         put_int32(int32_t value);
+    void         put_int32(size_t idx, int32_t value);
+    void         put_int64(int64_t value);
+    void         put_int64(size_t idx, int64_t value);
+    void         put_float(float value);
+    void         put_float(size_t idx, float value);
+    void         put_double(double value);
+    void         put_double(size_t idx, double value);
+
+private:
+    size_t       locate(size_t idx) const;
+    void         read(size_t idx, void *dst, size_t len) const;
+    void         write(size_t idx, const void *src, size_t len);
+
+    template<class T> T    read_value(size_t idx) const;
+    template<class T> void write_value(size_t idx, T value);
+}; // end class CompositeByteBuffer
+
+}} // end namespace mercury::nio
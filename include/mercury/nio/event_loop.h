@@ -0,0 +1,127 @@
+#pragma once
+#include <mercury/nio/channel.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace mercury {
+namespace nio {
+
+class EventLoop;
+
+/**
+ * @brief 事件处理接口，所有回调都在所属EventLoop的线程中执行。
+ */
+class EventHandler {
+public:
+    virtual ~EventHandler() {}
+
+    /// 接受到新连接，通道的所有权转移给处理者，通常注册到loop.selector()上。
+    virtual void on_accept(EventLoop &loop, StreamSocketChannel *ch) = 0;
+
+    /// 监听通道以外的注册键就绪。
+    virtual void on_select(EventLoop &loop, SelectionKey *key) = 0;
+
+    /**
+     * @brief 接受连接出错，通常是EMFILE/ENFILE/ENOBUFS等资源耗尽。
+     * 出错后EventLoop暂停接受AcceptBackoff毫秒再恢复，默认实现忽略错误。
+     */
+    virtual void on_accept_error(EventLoop &, const RuntimeError &) {}
+}; // end class EventHandler
+
+/**
+ * @brief 单线程反应器，拥有一个Selector和一个SO_REUSEPORT监听通道。
+ * 接受的连接由on_accept交给处理者，之后的事件也只在本线程中处理。
+ */
+class EventLoop final {
+public:
+    static const size_t AcceptBatch = 32;   // 每次accept_batch最多接受的连接数
+    static const long   AcceptBackoff = 100; // 接受出错后暂停接受的毫秒数
+
+private:
+    /// 暂停接受结束时恢复监听通道的OpAccept。
+    class AcceptResume : public Timer {
+    public:
+        EventLoop * m_loop;
+        AcceptResume() : m_loop(nullptr) {}
+        void on_timeout() override;
+    };
+
+    size_t                     m_index;
+    EventHandler             * m_handler;
+    Selector                   m_selector;
+    ServerSocketChannel        m_server;
+    SelectionKey             * m_acceptKey;
+    std::vector<SelectionKey*> m_selected;
+    StreamSocketChannel      * m_accepted[AcceptBatch];  // 预先分配的待接受通道
+    std::thread                m_thread;
+    std::atomic<bool>          m_running;
+    RuntimeError               m_error;    // 线程异常退出时的错误信息
+    AcceptResume               m_acceptResume;
+
+public:
+    EventLoop(size_t index, EventHandler *handler);
+    EventLoop(const EventLoop &other) = delete;
+    ~EventLoop();
+
+    EventLoop & operator=(const EventLoop &other) = delete;
+
+    /**
+     * @brief 以指定引擎打开Selector，创建监听通道并以SO_REUSEPORT绑定监听。
+     * @param engine Selector::EngineEpoll或Selector::EngineUring。
+     */
+    bool open(int engine, int domain, const char *addr, int port, int backlog, RuntimeError &e);
+    bool close(RuntimeError &e);
+
+    bool start(RuntimeError &e);   // 启动反应器线程并绑定到进程允许的CPU之一，绑定失败时线程退出
+    void stop();                   // 通知线程退出，可在任意线程调用
+    void join();
+
+    size_t     index() const { return m_index; }
+    int        listen_port();          // 实际监听端口
+    Selector & selector() { return m_selector; }
+    bool       in_loop() const { return std::this_thread::get_id() == m_thread.get_id(); }
+    const RuntimeError & error() const { return m_error; }
+
+private:
+    void run();
+    void accept_all();
+    void accept_backoff(const RuntimeError &e);
+}; // end class EventLoop
+
+/**
+ * @brief 多反应器组，每个线程一个EventLoop，各自监听同一端口，由内核在各线程间分发连接。
+ */
+class EventLoopGroup final {
+private:
+    std::vector<EventLoop*> m_loops;
+    int                     m_engine;
+
+public:
+    EventLoopGroup();
+    EventLoopGroup(const EventLoopGroup &other) = delete;
+    ~EventLoopGroup();
+
+    EventLoopGroup & operator=(const EventLoopGroup &other) = delete;
+
+    /**
+     * @brief 创建n个EventLoop并监听addr:port。
+     * @param n 线程数，0表示按CPU核数创建。
+     */
+    bool open(size_t n, int domain, const char *addr, int port, EventHandler *handler, RuntimeError &e);
+    bool close(RuntimeError &e);
+
+    bool start(RuntimeError &e);
+    void stop();
+    void join();
+
+    /// 各EventLoop的Selector引擎，须在open之前设置，默认Selector::EngineEpoll。
+    int         engine() const { return m_engine; }
+    void        engine(int eng) { m_engine = eng; }
+
+    size_t      size() const { return m_loops.size(); }
+    EventLoop * loop(size_t idx) { return m_loops[idx]; }
+}; // end class EventLoopGroup
+
+}} // end namespace mercury::nio
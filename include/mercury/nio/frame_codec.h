@@ -0,0 +1,103 @@
+#pragma once
+#include <mercury/nio/channel.h>
+#include <vector>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 长度前缀帧的解码器，把字节流切分为帧。
+ * 每帧由长度字段和负载组成，长度字段宽1、2、4或8字节，按构造时的字节序编码，值为负载的字节数。
+ * 读取的数据存放在池化缓存中，解出的帧是该缓存的slice，不复制负载。
+ * 帧被使用方持有时缓存不会被覆盖，解码器改为分配新缓存并只复制未解析的尾部。
+ */
+class FrameDecoder {
+public:
+    const static size_t DefaultMaxFrame  = 16 << 20;
+    const static size_t DefaultBufferSize = 16 << 10;
+
+private:
+    size_t     m_width;
+    ByteOrder  m_ord;
+    size_t     m_max;
+    size_t     m_bufsize;
+    ByteBuffer m_buf;    // [m_read, position)为未解析的数据，[position, capacity)为可写空间
+    size_t     m_read;
+
+public:
+    FrameDecoder(size_t width = 4, const ByteOrder &order = ByteOrder(ByteOrder::BigEndian),
+                 size_t max_frame = DefaultMaxFrame, size_t bufsize = DefaultBufferSize);
+
+    /**
+     * @brief 从通道读取一次数据，空间按当前帧的长度预留，保证一帧的负载在缓存中连续。
+     * @return 含义同StreamSocketChannel::read。
+     */
+    ssize_t read(StreamSocketChannel &ch, RuntimeError &e);
+
+    /// 追加来自其它来源的数据，复制到内部缓存。
+    void    append(const char *data, size_t len);
+
+    /**
+     * @brief 解出下一帧，frame为负载的只读视图，position为0，limit为负载长度，字节序与长度字段相同。
+     * @return 有完整的帧时返回true。数据不足时返回false，e不变；帧长超出上限时返回false并设置e，
+     * 此时流已无法继续解析，应关闭连接。
+     */
+    bool    next(ByteBuffer &frame, RuntimeError &e);
+
+    /// 解出全部完整的帧追加到frames，返回解出的帧数。出错时e被设置。
+    size_t  next_all(std::vector<ByteBuffer> &frames, RuntimeError &e);
+
+    /// 已读取尚未解析的字节数。
+    size_t  buffered() const { return m_buf.position() - m_read; }
+
+private:
+    /// 当前帧尚需读取的字节数，长度字段不完整时按长度字段计算。
+    size_t  frame_need() const;
+    void    reserve(size_t n);
+}; // end class FrameDecoder
+
+/**
+ * @brief 长度前缀帧的编码器，与FrameDecoder的格式相同。
+ * 长度字段写入池化的暂存缓存，不超过CopyThreshold的小负载紧随其后复制进去，
+ * 连续的小帧因此合并为一段连续内存；较大的负载以slice加入组合缓存，不复制。
+ * flush时以writev一次写出多帧，写不完的部分留待下一次flush。
+ */
+class FrameEncoder {
+public:
+    const static size_t StageBlockSize = 4096;
+    const static size_t CopyThreshold  = 256;
+
+private:
+    size_t              m_width;
+    ByteOrder           m_ord;
+    ByteBuffer          m_stage;     // 长度字段和小负载的暂存区，写满后另行分配
+    size_t              m_sealed;    // 暂存区中已加入m_out的位置
+    CompositeByteBuffer m_out;
+
+public:
+    FrameEncoder(size_t width = 4, const ByteOrder &order = ByteOrder(ByteOrder::BigEndian));
+
+    /**
+     * @brief 把payload的[position, limit)区间编码为一帧，负载长度超出长度字段的范围时返回false。
+     * 较大的负载不复制，payload包装调用方内存时，该内存在写出之前必须保持有效。
+     */
+    bool    encode(const ByteBuffer &payload, RuntimeError &e);
+
+    /**
+     * @brief 写出已编码的帧，直到全部写出或发送缓冲已满。
+     * @return >=0表示本次写出的字节数，-1表示写入异常。
+     */
+    ssize_t flush(StreamSocketChannel &ch, RuntimeError &e);
+
+    /// 尚未写出的字节数。
+    size_t  pending() const { return m_out.remaining() + m_stage.position() - m_sealed; }
+
+    /// 已编码尚未写出的数据，可交给其它方式发送。
+    CompositeByteBuffer & output() { this->seal(); return m_out; }
+
+private:
+    /// 把暂存区中尚未加入的部分作为一个分段加入m_out。
+    void    seal();
+}; // end class FrameEncoder
+
+}} // end namespace mercury::nio
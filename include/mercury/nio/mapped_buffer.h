@@ -0,0 +1,92 @@
+#pragma once
+#include <mercury/error.h>
+#include <mercury/nio/buffer.h>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 以mmap映射文件的字节缓存，读写直接作用于页缓存，不经过read/write复制。
+ * 每次映射文件的一个窗口，缓存的下标0对应窗口在文件中的起始位置offset()，
+ * 超过地址空间预算的大文件可以用map或slide移动窗口分段处理。
+ * 以ReadOnly打开时缓存为只读，put系列方法触发断言。
+ * slice和duplicate得到的视图不持有映射，只在下一次map、slide或close之前有效。
+ */
+class MappedByteBuffer : public ByteBuffer {
+public:
+    /// 打开方式
+    enum {
+        ReadOnly,
+        ReadWrite     // 共享映射，写入的内容由内核回写到文件
+    };
+
+    /// 访问模式提示，对应madvise
+    enum {
+        AccessNormal,
+        AccessSequential,   // 顺序访问，内核加大预读并尽早回收已读过的页
+        AccessRandom,       // 随机访问，关闭预读
+        AccessWillNeed      // 立即对当前窗口发起预读
+    };
+
+    /// 映射选项
+    enum {
+        MapPopulate  = 0x1,   // 映射时预先建立页表，之后的访问不再缺页
+        MapHugePages = 0x2    // 请求透明大页，减少TLB缺失，系统不支持时忽略，见map
+    };
+
+    static const size_t HugePageSize = 2 << 20;   // MapHugePages按此对齐映射地址
+
+private:
+    int    m_fd;
+    int    m_mode;
+    int    m_advice;      // 对之后映射的窗口同样生效
+    int    m_flags;
+    size_t m_file_size;
+    size_t m_offset;      // 窗口在文件中的起始位置
+    size_t m_window;      // map请求的窗口长度，0表示到文件末尾
+    char * m_map;         // mmap返回的地址，按页对齐，可能在窗口起始位置之前
+    size_t m_map_len;
+
+public:
+    MappedByteBuffer();
+    MappedByteBuffer(const MappedByteBuffer &) = delete;
+    MappedByteBuffer & operator=(const MappedByteBuffer &) = delete;
+    virtual ~MappedByteBuffer();
+
+    /// 打开文件，尚未映射，容量为0。
+    bool   open(const char *path, int mode, RuntimeError &e);
+    bool   close(RuntimeError &e);
+    bool   is_open() const { return m_fd >= 0; }
+
+    size_t file_size() const { return m_file_size; }
+    size_t offset() const { return m_offset; }
+
+    /**
+     * @brief 映射文件的[offset, offset + length)窗口，替换之前的窗口。
+     * length为0或超出文件末尾时映射到文件末尾。映射后position为0，limit为窗口长度。
+     * @param flags MapPopulate和MapHugePages的组合。MapHugePages使映射地址与文件偏移模2MiB同余，
+     *        并以MADV_HUGEPAGE提示内核。文件映射能否用上大页取决于文件系统：tmpfs需以huge=advise或
+     *        huge=within_size挂载，普通文件系统需内核启用CONFIG_READ_ONLY_THP_FOR_FS且只对只读映射
+     *        由khugepaged合并，其它情况下只是普通页映射。
+     */
+    bool   map(size_t offset, size_t length, int flags, RuntimeError &e);
+
+    /**
+     * @brief 以当前position对应的文件位置为起点，按map请求的窗口长度重新映射，
+     * 未处理的数据移到新窗口开头。解析到窗口末尾、剩余数据不足一条记录时调用。
+     */
+    bool   slide(RuntimeError &e);
+
+    /// 设置访问模式提示，作用于当前窗口和之后映射的窗口。
+    bool   advise(int advice, RuntimeError &e);
+
+    /// 把当前窗口的修改同步写回文件。
+    bool   sync(RuntimeError &e);
+
+private:
+    bool   unmap(RuntimeError &e);
+    void * map_aligned(size_t len, size_t file_off, int prot, int mflags);
+    bool   apply_advice(int advice, RuntimeError &e);
+}; // end class MappedByteBuffer
+
+}} // end namespace mercury::nio
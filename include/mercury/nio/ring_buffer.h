@@ -0,0 +1,64 @@
+#pragma once
+#include <mercury/error.h>
+#include <mercury/nio/buffer.h>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 环形字节缓存，用于流式接收。同一段物理内存在虚拟地址上连续映射两次，
+ * 可读数据即使跨越环的末尾也是一段连续内存，解析器不需要处理回绕，也不需要复制。
+ * 容量向上取整到页大小的整数倍。非线程安全，通常只在通道所属的Selector线程使用。
+ */
+class RingByteBuffer {
+private:
+    char * m_base;   // 第一次映射的起始地址，第二次映射紧随其后
+    size_t m_cap;
+    size_t m_head;   // 可读数据的起始偏移，[0, m_cap)
+    size_t m_size;   // 可读数据的字节数
+
+public:
+    RingByteBuffer() : m_base(nullptr), m_cap(0), m_head(0), m_size(0) {}
+    RingByteBuffer(const RingByteBuffer &) = delete;
+    RingByteBuffer & operator=(const RingByteBuffer &) = delete;
+    ~RingByteBuffer();
+
+    /// 分配容量不小于cap的环，实际容量为页大小的整数倍。
+    bool   open(size_t cap, RuntimeError &e);
+    bool   close(RuntimeError &e);
+    bool   is_open() const { return m_base != nullptr; }
+
+    size_t capacity() const { return m_cap; }
+    size_t readable() const { return m_size; }
+    size_t writable() const { return m_cap - m_size; }
+    void   clear() { m_head = m_size = 0; }
+
+    /// 可读数据的起始地址，其后readable()字节连续。
+    const char * read_ptr() const { return m_base + m_head; }
+    /// 读取方处理完n字节后调用。
+    void   consume(size_t n) {
+        assert( n <= m_size );
+        m_head += n;
+        if ( m_head >= m_cap ) m_head -= m_cap;
+        m_size -= n;
+    }
+
+    /// 可写空间的起始地址，其后writable()字节连续。
+    char * write_ptr() {
+        size_t tail = m_head + m_size;
+        return m_base + (tail >= m_cap ? tail - m_cap : tail);
+    }
+    /// 写入方写入n字节后调用。
+    void   commit(size_t n) { assert( n <= writable() ); m_size += n; }
+
+    /**
+     * @brief 可读数据的只读视图，以ByteBuffer的类型化读取解析，
+     * 解析完成后以视图的position调用consume。视图在下一次consume或close之前有效。
+     */
+    ByteBuffer read_buffer(const ByteOrder &order = ByteOrder()) const;
+
+    /// 可写空间的视图，写入后以视图的position调用commit。
+    ByteBuffer write_buffer(const ByteOrder &order = ByteOrder());
+}; // end class RingByteBuffer
+
+}} // end namespace mercury::nio
@@ -1,22 +1,51 @@
 #pragma once
 #include <mercury/error.h>
 #include <mercury/net/network.h>
+#include <mercury/nio/completion.h>
+#include <mercury/nio/task.h>
+#include <mercury/nio/timer.h>
+#include <atomic>
+#include <functional>
 #include <vector>
 
 namespace mercury {
 namespace nio {
 
 class Selector;
+class SelectableChannel;
 class ServerSocketChannel;
 class StreamSocketChannel;
 class DatagramSocketChannel;
 
-class SelectionKey {
+/**
+ * @brief 选择键，表示一个通道在某个Selector上的注册关系。
+ * 由Selector::reg创建，Selector::unreg注销后在下一次select时释放。
+ * 键本身是一个任务节点，其它线程修改关注事件时把键提交到Selector线程执行。
+ */
+class SelectionKey : private Task {
 public:
     const static int OpAccept  = 1;
     const static int OpConnect = 2;
     const static int OpRead    = 4;
     const static int OpWrite   = 8;
+    const static int OpError   = 16;   // socket错误队列可读，如零拷贝发送的完成通知
+    const static int OpTimeout = 32;   // 只作为就绪事件，表示键的期限已到，见deadline
+
+private:
+    Selector          * m_selector;
+    SelectableChannel * m_channel;
+    void              * m_att;
+    mutable int         m_interest;   // 关注的事件集合
+    mutable bool        m_edge;       // 是否边沿触发
+    int                 m_ready;      // 最近一次select就绪的事件集合
+    size_t              m_index;      // 在Selector注册表中的位置，用于O(1)注销
+    mutable Timer     * m_deadline;   // 期限定时器，首次设置期限时创建
+    std::atomic<int>    m_pending;    // 其它线程设置、尚未生效的关注事件，-1表示没有
+    bool                m_released;   // 已释放但仍在任务队列中，执行时删除
+    bool                m_valid;
+
+    friend class Selector;
+    friend class SelectableChannel;
 
 public:
     SelectionKey();
@@ -25,18 +54,51 @@ public:
     void * attach(void *obj);
     void * attachment() const;
 
+    Selector          * selector() const { return m_selector; }
+    SelectableChannel * channel() const { return m_channel; }
+
+    /**
+     * @brief 关注的事件集合。设置可在任意线程调用：在Selector线程中立即生效，
+     * 其它线程中提交到Selector线程，在下一次select返回前生效，连续多次设置只提交一次。
+     * 其它线程调用时须保证键尚未被释放。
+     */
     int    interest_ops() const;
     void   interest_ops(int ops) const;
     int    ready_ops() const;
 
+    /**
+     * @brief 边沿触发模式，默认关闭(水平触发)。
+     * 开启后通道只在状态变化时被选中一次，调用方须读写至EAGAIN，
+     * 参见StreamSocket::receive_all/send_all。
+     */
+    bool   edge_triggered() const;
+    void   edge_triggered(bool on) const;
+
+    /**
+     * @brief 设置期限，timeout毫秒后仍未清除时，本键在select中以OpTimeout就绪一次，期限随之清除。
+     * 用于限定非阻塞连接等操作的完成时间，timeout<0表示清除期限。只能在Selector所在线程调用。
+     */
+    void   deadline(long timeout) const;
+    bool   has_deadline() const { return m_deadline != nullptr && m_deadline->is_pending(); }
+
     bool   is_acceptable() const;
     bool   is_connectable() const;
     bool   is_readable() const;
     bool   is_writable() const;
+    bool   is_error() const;
+    bool   is_timeout() const;
     bool   is_valid() const;
+
+private:
+    void   run() override;   // 使其它线程设置的关注事件生效
 }; // end class SelectionKey
 
 class SelectableChannel {
+private:
+    std::vector<SelectionKey*> m_keys;   // 本通道在各Selector上的注册键
+
+    friend class Selector;
+
 public:
     SelectableChannel();
     virtual ~SelectableChannel();
@@ -48,6 +110,9 @@ protected:
     SelectableChannel & operator=(const SelectableChannel& other) = delete;
     SelectableChannel & operator=(SelectableChannel & other);
 
+    /// 注销本通道的全部注册键，通道关闭前调用。
+    void cancel_keys();
+
 public:
 
     SelectionKey * reg(Selector *selector, int ops, RuntimeError &e);
@@ -56,15 +121,24 @@ public:
     bool           is_registered() const;
 
 public:
+    virtual int fd() const = 0;
     virtual int valid_ops() const = 0;
 }; // end class SelectableChannel
 
 
 class Selector final {
+public:
+    const static int EngineEpoll = 0;   // epoll，默认
+    const static int EngineUring = 1;   // io_uring，就绪模式要求linux 5.11+，完成模式(*_async)要求linux 6.0+
+
 private:
     class SelectorImpl;
     SelectorImpl * m_pImpl;
 
+    friend class SelectionKey;
+    friend class ServerSocketChannel;
+    friend class StreamSocketChannel;
+
 public:
     Selector();
     Selector(const Selector &other) = delete;
@@ -77,16 +151,76 @@ public:
     bool close(RuntimeError &e);
     bool open(RuntimeError &e);
     bool is_open() const;
+
+    /**
+     * @brief 以指定的内核事件接口打开。EngineUring的注册和关注事件修改不产生系统调用，
+     * 与select合并为一次io_uring_enter提交；内核不支持时返回失败，可改用EngineEpoll。
+     */
+    bool open(int engine, RuntimeError &e);
+    int  engine() const;
+
+    /**
+     * @brief 等待已注册通道的事件。
+     * @param timeout 超时毫秒数，<0表示一直等待，0表示立即返回。
+     * @return 就绪的键数量，-1表示失败。
+     */
     int  select(RuntimeError &e);
     int  select(long timeout, RuntimeError &e);
+
+    /**
+     * @brief 唤醒阻塞在select上的线程，可在任意线程调用。
+     * 若select当前未阻塞，则下一次select立即返回。上一次唤醒尚未被select消费时，
+     * 新的唤醒被合并，不再产生系统调用。
+     */
     void wakeup();
 
+    /// 被合并的wakeup调用次数。
+    uint64_t wakeup_coalesced() const;
+
+    /**
+     * @brief 调度定时器，delay毫秒后在select中回调timer->on_timeout，只能在Selector所在线程调用。
+     * select的等待时间不超过最近定时器的到期时间，每次等待返回后批量回调到期的定时器；
+     * 只有定时器到期或完成事件时select返回0。取消调用timer->cancel()，Selector关闭时全部定时器被取消。
+     */
+    bool   schedule(Timer *timer, long delay, RuntimeError &e);
+    /// 等待中的定时器数量，包括各键的期限。
+    size_t timers() const;
+
+    /**
+     * @brief 提交任务到Selector线程，可在任意线程调用，任务在select返回前按提交顺序执行。
+     * 队列为空且调用方不是Selector线程时才唤醒select，否则只有一次原子交换。
+     * Selector关闭时执行已提交的任务；关闭后提交的任务在Selector析构时执行。
+     */
+    bool   submit(Task *task, RuntimeError &e);
+    /// 提交函数对象，每次提交分配一个任务对象，执行后释放。
+    bool   submit(std::function<void()> fn, RuntimeError &e);
+    /// 当前线程是否为Selector线程，即最近一次调用select的线程。尚未select时返回false，
+    /// 此时的修改以任务提交，在首次select等待之前生效。
+    bool   in_selector_thread() const;
+
+    /// 获取注册键和就绪键。传入的vector可以重复使用，容量足够时不再分配内存。
     size_t keys(std::vector<SelectionKey*> & keys);
     size_t selected_keys(std::vector<SelectionKey*> & keys);
 
     SelectionKey * reg(SelectableChannel *pch, int ops, void *att, RuntimeError &e);
     bool           unreg(SelectionKey *key, RuntimeError &e);
 
+    /**
+     * @brief 设置完成模式read_async使用的接收缓存环：count个size字节的缓存，由内核在数据到达时选取，
+     * 结果回调返回后归还。count须为2的幂，只能设置一次，须在首次read_async之前调用，否则使用默认的
+     * 1024个4096字节。缓存耗尽时read_async以-ENOBUFS结束，应增加count。只支持EngineUring。
+     */
+    bool     recv_buffers(unsigned count, unsigned size, RuntimeError &e);
+
+    /// 内核事件接口的系统调用次数(epoll_wait/epoll_ctl或io_uring_enter/io_uring_register)。
+    uint64_t syscalls() const;
+
+private:
+    /// 完成模式的异步操作，由通道的*_async调用，通道未注册到本Selector时以空关注事件注册。
+    bool accept_async(SelectableChannel *pch, Completion *c, RuntimeError &e);
+    bool read_async(SelectableChannel *pch, Completion *c, RuntimeError &e);
+    bool write_async(SelectableChannel *pch, const char *buf, size_t len, Completion *c, RuntimeError &e);
+    bool prepare_async(SelectableChannel *pch, RuntimeError &e);
 }; // end class Selector
 
 
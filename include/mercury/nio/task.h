@@ -0,0 +1,60 @@
+#pragma once
+#include <stddef.h>
+#include <atomic>
+
+namespace mercury {
+namespace nio {
+
+class TaskQueue;
+
+/**
+ * @brief 提交到Selector线程执行的任务，由Selector::submit提交。
+ * 任务对象由提交方持有，队列只以侵入式链表串联，入队不分配内存。
+ * run返回前队列已不再引用本任务，run中可以delete this或再次提交自身。
+ */
+class Task {
+private:
+    std::atomic<Task*> m_next;
+
+    friend class TaskQueue;
+
+public:
+    Task() : m_next(nullptr) {}
+    Task(const Task &other) = delete;
+    virtual ~Task() {}
+
+    Task & operator=(const Task &other) = delete;
+
+    virtual void run() = 0;
+}; // end class Task
+
+/**
+ * @brief 无锁多生产者单消费者任务队列。
+ * 生产者以一次原子交换把任务压入链表头，入队前队列为空时由该生产者负责唤醒消费者，
+ * 队列非空时说明已有生产者唤醒过，入队只有一次原子交换。
+ * 消费者一次交换取走整个链表，反转为入队顺序后依次执行；执行中新提交的任务留到下一次。
+ * 生产者在交换后才写入后继指针，期间后继为Busy标记，消费者遇到时短暂等待。
+ */
+class TaskQueue {
+private:
+    std::atomic<Task*> m_head;   // 最近入队的任务
+
+public:
+    TaskQueue() : m_head(nullptr) {}
+    TaskQueue(const TaskQueue &other) = delete;
+
+    TaskQueue & operator=(const TaskQueue &other) = delete;
+
+    /**
+     * @brief 入队，可在任意线程调用。
+     * @return 入队前队列是否为空，为空时调用方须唤醒消费者。
+     */
+    bool   push(Task *task);
+
+    /// 执行当前已入队的全部任务，只能在消费者线程调用，返回执行的任务数。
+    size_t run_all();
+
+    bool   empty() const { return m_head.load(std::memory_order_acquire) == nullptr; }
+}; // end class TaskQueue
+
+}} // end namespace mercury::nio
@@ -0,0 +1,108 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mercury {
+namespace nio {
+
+class TimerWheel;
+
+/**
+ * @brief 定时器，由TimerWheel或Selector::schedule调度，到期时回调on_timeout。
+ * 定时器对象由调用方持有，时间轮只以侵入式链表串联，调度和取消都不分配内存。
+ * 析构时自动取消。一个定时器同时只能在一个时间轮中等待，重复调度相当于先取消再调度。
+ */
+class Timer {
+private:
+    Timer      * m_prev;
+    Timer      * m_next;
+    TimerWheel * m_wheel;    // 所在的时间轮，nullptr表示未调度
+    int64_t      m_expire;   // 到期时刻，时间轮的毫秒刻度
+    int          m_slot;     // 所在的槽位，见TimerWheel
+
+    friend class TimerWheel;
+
+public:
+    Timer();
+    Timer(const Timer &other) = delete;
+    virtual ~Timer();
+
+    Timer & operator=(const Timer &other) = delete;
+
+    /// 取消等待，未调度时不做任何事。
+    void    cancel();
+    bool    is_pending() const { return m_wheel != nullptr; }
+    int64_t expire() const { return m_expire; }
+
+    /// 到期回调，调用前定时器已不在时间轮中，可在回调内重新调度自身或取消其它定时器。
+    virtual void on_timeout() = 0;
+}; // end class Timer
+
+/**
+ * @brief 分层时间轮，刻度为1毫秒。
+ * 第0层256个槽，每槽1个刻度；其上3层各64个槽，每槽分别为2^8、2^14、2^20个刻度，
+ * 共覆盖2^26毫秒(约18.6小时)，更远的定时器放在最高层最后一个槽，到时再重新放置。
+ * 定时器按到期时刻直接计算槽位，调度和取消都是O(1)。高层的槽在其时间段到来时
+ * 整体下移(cascade)到低层，每个定时器最多下移3次。
+ * 各层维护非空槽位图，推进时跳过空槽，并据此计算最近一次需要处理的时刻。
+ * 非线程安全，只能在所属Selector的线程使用。
+ */
+class TimerWheel {
+public:
+    const static int Levels     = 4;
+    const static int Slots0Bits = 8;
+    const static int SlotsNBits = 6;
+    const static int Slots0     = 1 << Slots0Bits;   // 256
+    const static int SlotsN     = 1 << SlotsNBits;   // 64
+    const static int TotalSlots = Slots0 + SlotsN * (Levels - 1);
+    const static int64_t MaxSpan = (int64_t)1 << (Slots0Bits + SlotsNBits * (Levels - 1));
+
+private:
+    int64_t   m_now;                       // 已处理到的刻度
+    size_t    m_count;                     // 等待中的定时器数量
+    Timer   * m_slots[TotalSlots];         // 各槽链表头
+    uint64_t  m_bitmap[TotalSlots / 64];   // 非空槽位图
+    Timer   * m_firing;                    // 正在回调的到期链表
+
+public:
+    explicit TimerWheel(int64_t now = 0);
+    TimerWheel(const TimerWheel &other) = delete;
+    ~TimerWheel();
+
+    TimerWheel & operator=(const TimerWheel &other) = delete;
+
+    /// 清空全部定时器，并把当前刻度设为now。
+    void    reset(int64_t now);
+    int64_t now() const { return m_now; }
+    size_t  size() const { return m_count; }
+    bool    empty() const { return m_count == 0; }
+
+    /// 在当前刻度delay毫秒后到期，delay<=0时在下一次推进时到期。
+    void    schedule(Timer *timer, int64_t delay);
+    /// 在指定刻度到期。
+    void    schedule_at(Timer *timer, int64_t expire);
+    void    cancel(Timer *timer);
+
+    /**
+     * @brief 距下一次需要推进的时刻的毫秒数，-1表示没有定时器。
+     * 最近的定时器在高层时返回的是其所在槽的下移时刻，早于实际到期时刻，
+     * 届时推进后再次计算即可得到精确值。
+     */
+    int64_t next_timeout(int64_t now) const;
+
+    /**
+     * @brief 推进到now，回调所有到期的定时器。
+     * @return 到期的定时器数量。
+     */
+    size_t  advance(int64_t now);
+
+private:
+    void    link(Timer *timer);
+    void    unlink(Timer *timer);
+    void    cascade(int level, int64_t tick);
+    size_t  fire(int slot);
+    int64_t next_tick() const;
+    int     find_slot(int base, int nslots, int from) const;
+}; // end class TimerWheel
+
+}} // end namespace mercury::nio
@@ -21,7 +21,10 @@ InetAddress::~InetAddress() {
 }
 
 InetAddress & InetAddress::operator=(const InetAddress& other) {
-    if ( this != &other ) this->m_domain = other.m_domain;
+    if ( this != &other ) {
+        this->m_domain = other.m_domain;
+        m_hostname.clear();   // 地址已改变，缓存的主机名失效
+    }
     return *this;
 }
 
@@ -176,6 +179,14 @@ Inet4Address::Inet4Address(const Inet4Address &other)
 
 Inet4Address::~Inet4Address() {}
 
+Inet4Address & Inet4Address::operator=(const Inet4Address &other) {
+    if ( this != &other ) {
+        InetAddress::operator=(other);
+        m_addr = other.m_addr;
+    }
+    return *this;
+}
+
 bool Inet4Address::operator==(const Inet4Address &other) const {
     if ( m_addr != other.m_addr ) return false;
     return InetAddress::operator==(other);
@@ -228,6 +239,15 @@ Inet6Address::Inet6Address(const mercury::net::Inet6Address & other )
 
 Inet6Address::~Inet6Address() {}
 
+Inet6Address & Inet6Address::operator=(const Inet6Address &other) {
+    if ( this != &other ) {
+        InetAddress::operator=(other);
+        *(struct in6_addr *)m_addr = *(const struct in6_addr *)other.m_addr;
+        m_hostname.clear();
+    }
+    return *this;
+}
+
 bool Inet6Address::operator==(const Inet6Address &other) const {
     return IN6_ARE_ADDR_EQUAL(m_addr, other.m_addr); // netinet/in.h
 }
@@ -298,6 +318,31 @@ public:
         }
     }
 
+    /**
+     * @brief 以C地址结构重新赋值，地址族不变时原地修改，不重新分配地址对象。
+     * addrlen小于地址族对应的结构长度时抛出异常。
+     */
+    void Assign(const struct sockaddr *paddr, socklen_t addrlen) {
+        int af = paddr->sa_family;
+        if ( af == AF_INET ) {
+            if ( addrlen < (socklen_t)sizeof(struct sockaddr_in) ) throw std::runtime_error("InetSocketAddressImpl::Assign, short inet address");
+            auto pinaddr = (const struct sockaddr_in *)paddr;
+            Inet4Address addr(pinaddr->sin_addr.s_addr);
+            if ( this->Domain() == AF_INET ) *(Inet4Address *)m_ptrAddress.get() = addr;
+            else m_ptrAddress.reset(new Inet4Address(addr));
+            m_port = ntohs(pinaddr->sin_port);
+        } else if ( af == AF_INET6 ) {
+            if ( addrlen < (socklen_t)sizeof(struct sockaddr_in6) ) throw std::runtime_error("InetSocketAddressImpl::Assign, short inet6 address");
+            auto pin6addr = (const struct sockaddr_in6 *)paddr;
+            Inet6Address addr(pin6addr->sin6_addr.s6_addr, 16);
+            if ( this->Domain() == AF_INET6 ) *(Inet6Address *)m_ptrAddress.get() = addr;
+            else m_ptrAddress.reset(new Inet6Address(addr));
+            m_port = ntohs(pin6addr->sin6_port);
+        } else {
+            throw std::runtime_error("InetSocketAddressImpl::Assign, invalid inet address domain");
+        }
+    }
+
     int Domain() const { 
         if ( m_ptrAddress ) return m_ptrAddress->domain();
         else return 0;
@@ -410,21 +455,26 @@ std::string InetSocketAddress::str() const {
     return str;
 }
 
+void InetSocketAddress::assign(const struct sockaddr *paddr, socklen_t addrlen) {
+    if ( m_pImpl ) m_pImpl->Assign(paddr, addrlen);
+    else m_pImpl = new InetSocketAddressImpl(paddr, addrlen);
+}
+
 int InetSocketAddress::domain() const {
-    if ( m_pImpl ) m_pImpl->Domain();
+    if ( m_pImpl ) return m_pImpl->Domain();
     else return AF_INET;   // 默认ipv4
 }
 
 struct sockaddr * InetSocketAddress::caddr()  {
-    if ( m_pImpl ) m_pImpl->GetCAddress();
+    if ( m_pImpl ) return (struct sockaddr *)m_pImpl->GetCAddress();
     else return nullptr;
 }
 const struct sockaddr * InetSocketAddress::caddr() const {
-    if ( m_pImpl ) m_pImpl->GetCAddress();
+    if ( m_pImpl ) return m_pImpl->GetCAddress();
     else return nullptr;
 }
 socklen_t InetSocketAddress::caddrsize() const {
-    if ( m_pImpl ) m_pImpl->GetCAddressSize();
+    if ( m_pImpl ) return m_pImpl->GetCAddressSize();
     else return 0;
 }
 
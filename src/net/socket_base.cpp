@@ -82,6 +82,18 @@ int SocketBase::get_reuse_addr() const {
     return -1;
 }
 
+bool SocketBase::set_reuse_port(int on, RuntimeError &e) {
+    SocketOptReusePort opt( m_pImpl->Fd() );
+    return opt.Set(on, e);
+}
+
+int SocketBase::get_reuse_port(RuntimeError &e) const {
+    SocketOptReusePort opt(m_pImpl->Fd());
+    int value;
+    if ( opt.Get(&value, e) ) return value?1:0;
+    else return -1;
+}
+
 bool SocketBase::set_block_mode(bool bBlocked, RuntimeError &e) {
     int r = ::fcntl(m_pImpl->Fd(), F_GETFL);
 	if ( r < 0 ) {
@@ -149,6 +161,23 @@ bool ServerSocket::accept(StreamSocket &rSock, RuntimeError &e) {
     return this->impl().accept(p->impl(), e);
 }
 
+ssize_t ServerSocket::accept_batch(StreamSocket **socks, size_t n, int flags, RuntimeError &e) {
+    size_t i = 0;
+    for ( ; i < n; ++i ) {
+        SocketBase * p = static_cast<SocketBase *>(socks[i]);
+        assert( p->is_closed() );
+        int r = this->impl().Accept4(p->impl(), flags, e);
+        if ( r == 0 ) break;
+        if ( r < 0 ) return i > 0 ? (ssize_t)i : -1;   // 已接受的连接先交给调用者
+    }
+    return (ssize_t)i;
+}
+
+bool ServerSocket::adopt(int fd, StreamSocket &sock, RuntimeError &e) {
+    SocketBase * p = static_cast<SocketBase *>(&sock);
+    return this->impl().Adopt(p->impl(), fd, e);
+}
+
 bool ServerSocket::set_so_timeout(int timeout, RuntimeError &e) {
     SocketOptRecvTimeout opt(this->fd());
     if ( opt.Set(timeout, e) ) return true;
@@ -181,6 +210,10 @@ bool StreamSocket::connect(const char *ip, int port, RuntimeError &e) {
     return impl().Connect(ip, port, e);
 }
 
+int StreamSocket::finish_connect(RuntimeError &e) {
+    return impl().FinishConnect(e);
+}
+
 ssize_t StreamSocket::send(const char *buf, size_t len, RuntimeError &e) {
     SocketWriterImpl writer(impl().Fd(), buf, len);
     return writer(e);
@@ -191,6 +224,50 @@ ssize_t StreamSocket::receive(char *buf, size_t len, RuntimeError &e) {
     return reader(e);
 }
 
+ssize_t StreamSocket::send_all(const char *buf, size_t len, RuntimeError &e) {
+    SocketWriterImpl writer(impl().Fd(), buf, len);
+    return writer.WriteAll(e);
+}
+
+ssize_t StreamSocket::receive_all(char *buf, size_t len, size_t *received, RuntimeError &e) {
+    SocketReaderImpl reader(impl().Fd(), buf, len);
+    ssize_t r = reader.ReadAll(e);
+    if ( received ) *received = reader.Position();
+    return r;
+}
+
+ssize_t StreamSocket::sendv(const struct iovec *iov, int iovcnt, RuntimeError &e) {
+    return SocketVectorIoImpl::Writev(impl().Fd(), iov, iovcnt, e);
+}
+
+ssize_t StreamSocket::receivev(const struct iovec *iov, int iovcnt, RuntimeError &e) {
+    return SocketVectorIoImpl::Readv(impl().Fd(), iov, iovcnt, e);
+}
+
+bool StreamSocket::set_zerocopy(int on, RuntimeError &e) {
+    SocketOptZeroCopy opt( impl().Fd() );
+    return opt.Set(on, e);
+}
+
+int StreamSocket::get_zerocopy(RuntimeError &e) const {
+    SocketOptZeroCopy opt( impl().Fd() );
+    int on;
+    if ( opt.Get(&on, e) ) return on ? 1 : 0;
+    else return -1;
+}
+
+ssize_t StreamSocket::send_zerocopy(const char *buf, size_t len, RuntimeError &e) {
+    return SocketZeroCopyImpl::Send(impl().Fd(), buf, len, e);
+}
+
+int StreamSocket::read_zerocopy_completion(uint32_t *lo, uint32_t *hi, bool *copied, RuntimeError &e) {
+    return SocketZeroCopyImpl::ReadCompletion(impl().Fd(), lo, hi, copied, e);
+}
+
+ssize_t StreamSocket::transfer_from(int fd, int64_t offset, size_t len, RuntimeError &e) {
+    return impl().TransferFrom(fd, offset, len, e);
+}
+
 bool StreamSocket::shutdown_input(RuntimeError &e) {
     return impl().ShutdownInput( e);
 }
@@ -301,17 +378,59 @@ bool DatagramSocket::create(int domain, RuntimeError &e) {
 }
 
 ssize_t DatagramSocket::send(const DatagramPacket &data, RuntimeError &e) {
-    SocketWriterImpl writer(impl().Fd(), data.buffer(), data.length());
-    return writer.Write(*data.endpoint(), e);
+    // 经由sendmsg发送，以便携带UDP_SEGMENT等控制消息。
+    ssize_t r = DatagramBatchImpl::Send(impl().Fd(), &data, 1, e);
+    return r > 0 ? (ssize_t)data.length() : r;
 }
 
 ssize_t DatagramSocket::receive(DatagramPacket *data, RuntimeError &e) {
-    char * buffer = data->buffer() + data->length();
-    size_t length = data->capacity() - data->length();
-    SocketReaderImpl reader(impl().Fd(), buffer, length);
-    ssize_t r = reader.Read(data->endpoint(), e);
-    if ( r > 0 ) data->setbuflen(length + r);
-    return r;
+    size_t  length = data->length();
+    ssize_t r = DatagramBatchImpl::Receive(impl().Fd(), data, 1, e);
+    return r > 0 ? (ssize_t)(data->length() - length) : r;
+}
+
+bool DatagramSocket::is_closed() {
+    return SocketBase::is_closed();
+}
+
+bool DatagramSocket::connect(const char *host, int port, RuntimeError &e) {
+    return impl().Connect(host, port, e);
+}
+
+bool DatagramSocket::is_connected() const {
+    return impl().State() == SocketImpl::SOCK_STATE_OPEN;
+}
+
+ssize_t DatagramSocket::send_batch(const DatagramPacket *packets, size_t n, RuntimeError &e) {
+    return DatagramBatchImpl::Send(impl().Fd(), packets, n, e);
+}
+
+ssize_t DatagramSocket::receive_batch(DatagramPacket *packets, size_t n, RuntimeError &e) {
+    return DatagramBatchImpl::Receive(impl().Fd(), packets, n, e);
+}
+
+bool DatagramSocket::set_udp_segment(int size, RuntimeError &e) {
+    SocketOptUdpSegment opt( impl().Fd() );
+    return opt.Set(size, e);
+}
+
+int DatagramSocket::get_udp_segment(RuntimeError &e) const {
+    SocketOptUdpSegment opt( impl().Fd() );
+    int size;
+    if ( opt.Get(&size, e) ) return size;
+    else return -1;
+}
+
+bool DatagramSocket::set_udp_gro(int on, RuntimeError &e) {
+    SocketOptUdpGro opt( impl().Fd() );
+    return opt.Set(on, e);
+}
+
+int DatagramSocket::get_udp_gro(RuntimeError &e) const {
+    SocketOptUdpGro opt( impl().Fd() );
+    int on;
+    if ( opt.Get(&on, e) ) return on ? 1 : 0;
+    else return -1;
 }
 
 } // end namespace net
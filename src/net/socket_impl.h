@@ -3,6 +3,8 @@
 #include <memory>
 #include <cassert>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/sendfile.h>
 
 #include "socket_utils.h"
 
@@ -38,11 +40,16 @@ namespace net {
         int                             m_shutdown;     // shutdown状态
         int                             m_domain;       // address family, AF_INET/AF_INET4
         int                             m_socktype;     // socket type, SOCK_STREAM/SOCK_DGRAM 
+        int                             m_pipe[2];      // splice中转管道，首次使用时创建
+        size_t                          m_piped;        // 管道中尚未写入socket的字节数
 
     public:
         SocketImpl() 
             : m_fd(INVALID_SOCKET), m_state(SOCK_STATE_CLOSED)
-            , m_shutdown(SOCK_SHUT_NONE), m_domain(0), m_socktype(0) {}
+            , m_shutdown(SOCK_SHUT_NONE), m_domain(0), m_socktype(0), m_piped(0)
+        {
+            m_pipe[0] = m_pipe[1] = INVALID_SOCKET;
+        }
 
         SocketImpl(const SocketImpl &other) = delete; 
         SocketImpl(SocketImpl && other);
@@ -57,9 +64,23 @@ namespace net {
         int   Fd() const { return m_fd; }
         
         bool  accept(SocketImpl &rSock, RuntimeError &e);
+
+        /**
+         * @brief 以accept4接受一个连接，flags为SOCK_NONBLOCK和SOCK_CLOEXEC的组合。
+         * @return 1表示接受成功，0表示没有等待的连接(EAGAIN)且不设置错误信息，-1表示失败。
+         */
+        int   Accept4(SocketImpl &rSock, int flags, RuntimeError &e);
+        /// 把已接受的连接nfd交给rSock，用于内核代为接受的连接(如io_uring的accept请求)。
+        bool  Adopt(SocketImpl &rSock, int nfd, RuntimeError &e);
         bool  Bind(const char *host, int port, RuntimeError & errinfo);
         bool  Close(RuntimeError &e);
         bool  Connect(const char *ip, int port, RuntimeError & errinfo);
+
+        /**
+         * @brief 完成非阻塞连接，在连接可写(OpConnect就绪)后调用，以SO_ERROR取得连接结果。
+         * @return 1表示已连接，0表示仍在连接中，-1表示连接失败，状态回到CREATED。
+         */
+        int   FinishConnect(RuntimeError &e);
         bool  Create(int af, int type, RuntimeError & errinfo);
         
         std::string GetLocalAddress(RuntimeError &error) const;
@@ -76,6 +97,18 @@ namespace net {
         std::string str() const;
 
         int   ShutdownState() const { return m_shutdown; }
+
+        /**
+         * @brief 把fd从offset起的len字节发送到socket，数据不经过用户空间。
+         * 优先使用sendfile；fd不支持时(如管道、socket)经由管道splice，此时忽略offset，
+         * socket写满时未写出的数据留在管道中，下一次调用时先写出。
+         * @return 本次写入socket的字节数，0表示socket发送缓冲已满或fd暂无数据，-1表示失败(含fd提前结束)。
+         */
+        ssize_t TransferFrom(int fd, int64_t offset, size_t len, RuntimeError &e);
+
+    private:
+        ssize_t SpliceFrom(int fd, size_t len, RuntimeError &e);
+        void    ClosePipe();
     }; // end class Socket
 
     inline SocketImpl::SocketImpl(SocketImpl && other) {
@@ -87,6 +120,12 @@ namespace net {
 
         m_domain = other.m_domain;
         m_socktype = other.m_socktype;
+
+        m_pipe[0] = other.m_pipe[0];
+        m_pipe[1] = other.m_pipe[1];
+        m_piped = other.m_piped;
+        other.m_pipe[0] = other.m_pipe[1] = INVALID_SOCKET;
+        other.m_piped = 0;
     }
 
     inline SocketImpl & SocketImpl::operator=(SocketImpl &&other) {
@@ -100,6 +139,13 @@ namespace net {
 
         m_domain = other.m_domain;
         m_socktype = other.m_socktype;
+
+        this->ClosePipe();
+        m_pipe[0] = other.m_pipe[0];
+        m_pipe[1] = other.m_pipe[1];
+        m_piped = other.m_piped;
+        other.m_pipe[0] = other.m_pipe[1] = INVALID_SOCKET;
+        other.m_piped = 0;
         return *this;
     }
 
@@ -123,7 +169,44 @@ namespace net {
         return false;
     }
 
+    inline int SocketImpl::Accept4(SocketImpl &rSock, int flags, RuntimeError &e) {
+        for ( ;; ) {
+            int nfd = ::accept4(m_fd, nullptr, nullptr, flags);
+            if ( nfd >= 0 ) {
+                this->Adopt(rSock, nfd, e);
+                return 1;
+            }
+
+            // 队列已空是批量接受的正常结束条件，直接返回，不构造错误消息。
+            int err = errno;
+            if ( err == EAGAIN || err == EWOULDBLOCK ) return 0;
+            // 被信号中断或连接在接受前已被对端重置，继续接受下一个。
+            if ( err == EINTR || err == ECONNABORTED ) continue;
+
+            RuntimeError e2;
+            std::ostringstream oss;
+            oss<<"accept4() error, "<<sockerr<<" fd: "<<m_fd<<", local: "<<this->GetLocalEndpoint(e2);
+            e.set(-1, oss.str().c_str(), "SocketImpl::Accept4");
+            return -1;
+        }
+    }
+
+    inline bool SocketImpl::Adopt(SocketImpl &rSock, int nfd, RuntimeError &e) {
+        if ( nfd < 0 || rSock.m_fd != INVALID_SOCKET ) {
+            std::ostringstream oss;
+            oss<<"adopt() error, invalid fd or socket already open, fd: "<<nfd<<", socket fd: "<<rSock.m_fd;
+            e.set(-1, oss.str().c_str(), "SocketImpl::Adopt");
+            return false;
+        }
+        rSock.m_domain   = this->m_domain;
+        rSock.m_socktype = this->m_socktype;
+        rSock.m_state    = SOCK_STATE_OPEN;
+        rSock.m_fd       = nfd;
+        return true;
+    }
+
     inline bool SocketImpl::Close(RuntimeError & e) {
+        this->ClosePipe();   // 管道中残留的数据属于本次连接，一并丢弃
         if ( m_fd != INVALID_SOCKET ) {
             m_state = SOCK_STATE_CLOSED;
             int r = ::close(m_fd);
@@ -191,9 +274,9 @@ namespace net {
         m_state = SOCK_STATE_OPENING;   // 开始连接
         int r = ::connect(m_fd, ptrRemoteAddr->caddr(), ptrRemoteAddr->caddrsize());
         if ( r == -1) {
-            int e = errno;
-            // 非阻塞连接，修改状态，可以根据状态值判断连接是否完成。
-            if ( e != EINPROGRESS ) m_state = SOCK_STATE_CREATED;  // 连接失败，回到CREATED状态 
+            // 非阻塞连接正在进行，保持OPENING状态，由FinishConnect完成连接。
+            if ( errno == EINPROGRESS ) return true;
+            m_state = SOCK_STATE_CREATED;  // 连接失败，回到CREATED状态 
             std::ostringstream oss;
             oss<<"connect() error, "<<sockerr<<" fd: "<<m_fd<<", remote: "<<ptrRemoteAddr->str();
             errinfo.set(-1, oss.str().c_str(), "SocketImpl::Connect");
@@ -203,6 +286,37 @@ namespace net {
         return true;
     }
 
+    inline int SocketImpl::FinishConnect(RuntimeError &e) {
+        if ( m_state == SOCK_STATE_OPEN ) return 1;
+        if ( m_state != SOCK_STATE_OPENING ) {
+            std::ostringstream oss;
+            oss<<"no connection pending, fd: "<<m_fd<<", state: "<<m_state;
+            e.set(-1, oss.str().c_str(), "SocketImpl::FinishConnect");
+            return -1;
+        }
+
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if ( ::getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &err, &len) == -1 ) err = errno;
+        if ( err == 0 ) {
+            // 没有错误时以getpeername区分已连接和仍在连接中(提前调用)。
+            struct sockaddr_storage addr;
+            socklen_t addrlen = sizeof(addr);
+            if ( ::getpeername(m_fd, (struct sockaddr *)&addr, &addrlen) == 0 ) {
+                m_state = SOCK_STATE_OPEN;
+                return 1;
+            }
+            if ( errno == ENOTCONN ) return 0;
+            err = errno;
+        }
+
+        m_state = SOCK_STATE_CREATED;
+        std::ostringstream oss;
+        oss<<"connect() failed, errno: "<<err<<", errmsg: "<<strerror(err)<<", fd: "<<m_fd;
+        e.set(-1, oss.str().c_str(), "SocketImpl::FinishConnect");
+        return -1;
+    }
+
     inline std::string SocketImpl::GetLocalEndpoint(RuntimeError &error ) const {
         char addrbuf[32];
         socklen_t addrlen = 32;
@@ -374,4 +488,82 @@ namespace net {
         return true;
     }
 
+    inline void SocketImpl::ClosePipe() {
+        if ( m_pipe[0] != INVALID_SOCKET ) {
+            ::close(m_pipe[0]);
+            ::close(m_pipe[1]);
+            m_pipe[0] = m_pipe[1] = INVALID_SOCKET;
+        }
+        m_piped = 0;
+    }
+
+    inline ssize_t SocketImpl::TransferFrom(int fd, int64_t offset, size_t len, RuntimeError &e) {
+        if ( m_piped > 0 ) return this->SpliceFrom(fd, len, e);   // 上一次splice尚未写完
+
+        off_t  off  = (off_t)offset;
+        size_t sent = 0;
+        while ( sent < len ) {
+            ssize_t r = ::sendfile(m_fd, fd, &off, len - sent);
+            if ( r > 0 ) { sent += r; continue; }
+            if ( r == 0 ) {
+                if ( sent > 0 ) break;
+                std::ostringstream oss;
+                oss<<"sendfile() failed, unexpected end of file. fd: "<<m_fd<<", in_fd: "<<fd<<", offset: "<<offset;
+                e.set(-1, oss.str().c_str(), "SocketImpl::TransferFrom");
+                return -1;
+            }
+            int eno = errno;
+            if ( eno == EINTR ) continue;
+            if ( eno == EAGAIN || eno == EWOULDBLOCK ) break;   // socket发送缓冲已满
+            if ( (eno == EINVAL || eno == ESPIPE || eno == ENOSYS) && sent == 0 ) return this->SpliceFrom(fd, len, e);
+            if ( sent > 0 ) break;
+            std::ostringstream oss;
+            oss<<"sendfile() failed, "<<sockerr<<" fd: "<<m_fd<<", in_fd: "<<fd<<", offset: "<<offset;
+            e.set(-1, oss.str().c_str(), "SocketImpl::TransferFrom");
+            return -1;
+        }
+        return (ssize_t)sent;
+    }
+
+    inline ssize_t SocketImpl::SpliceFrom(int fd, size_t len, RuntimeError &e) {
+        if ( m_pipe[0] == INVALID_SOCKET && ::pipe2(m_pipe, O_NONBLOCK | O_CLOEXEC) == -1 ) {
+            m_pipe[0] = m_pipe[1] = INVALID_SOCKET;
+            std::ostringstream oss;
+            oss<<"pipe2() failed, "<<syserr<<" fd: "<<m_fd;
+            e.set(-1, oss.str().c_str(), "SocketImpl::SpliceFrom");
+            return -1;
+        }
+
+        const unsigned flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+        size_t sent = 0;
+        for ( ;; ) {
+            // 先把管道中的数据写入socket，这部分数据已从fd读出，计入本次发送的长度。
+            while ( m_piped > 0 && sent < len ) {
+                size_t  want = m_piped < len - sent ? m_piped : len - sent;
+                ssize_t r = ::splice(m_pipe[0], nullptr, m_fd, nullptr, want, flags);
+                if ( r > 0 ) { m_piped -= r; sent += r; continue; }
+                int eno = errno;
+                if ( r < 0 && eno == EINTR ) continue;
+                if ( r < 0 && (eno == EAGAIN || eno == EWOULDBLOCK) ) return (ssize_t)sent;
+                std::ostringstream oss;
+                oss<<"splice() to socket failed, "<<sockerr<<" fd: "<<m_fd;
+                e.set(-1, oss.str().c_str(), "SocketImpl::SpliceFrom");
+                return sent > 0 ? (ssize_t)sent : -1;
+            }
+            if ( sent + m_piped >= len ) return (ssize_t)sent;
+
+            ssize_t r = ::splice(fd, nullptr, m_pipe[1], nullptr, len - sent - m_piped, flags);
+            if ( r > 0 ) { m_piped += r; continue; }
+            int eno = errno;
+            if ( r < 0 && eno == EINTR ) continue;
+            if ( r < 0 && (eno == EAGAIN || eno == EWOULDBLOCK) ) return (ssize_t)sent;  // fd暂无数据
+            if ( sent > 0 ) return (ssize_t)sent;
+            std::ostringstream oss;
+            if ( r == 0 ) oss<<"splice() failed, unexpected end of input. fd: "<<m_fd<<", in_fd: "<<fd;
+            else oss<<"splice() from fd failed, "<<syserr<<" fd: "<<m_fd<<", in_fd: "<<fd;
+            e.set(-1, oss.str().c_str(), "SocketImpl::SpliceFrom");
+            return -1;
+        }
+    }
+
 }} // end namespace mercury::net
\ No newline at end of file
@@ -2,9 +2,14 @@
 
 #include <sys/types.h>          /* See NOTES */
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
 #include <errno.h>
+#include <string.h>
 
 #include "socket_utils.h"
+#include "socket_opt_impl.h"
 
 namespace mercury {
 namespace net {
@@ -37,7 +42,7 @@ public:
      * @return >0表示实际读取的字节数。0表示对端关闭。-1表示读取异常，根据error确定异常内容
      */
     ssize_t Read(size_t limit, RuntimeError & e) {
-        assert(m_pos + limit > m_size);
+        assert(m_pos + limit <= m_size);
         ssize_t r = ::recv(m_fd, m_buffer + m_pos, limit, 0);
         if ( r > 0 )  {
             m_pos += r;
@@ -61,6 +66,24 @@ public:
         size_t limit = m_size - m_pos;
         return this->Read(limit, e);
     }
+
+    /**
+     * @brief 循环读取直到EAGAIN、对端关闭或缓存写满，用于边沿触发模式。
+     * 读取不足请求长度时不能认为接收缓冲已空：数据和FIN可能同时到达，
+     * 边沿触发下不会再有通知，必须继续读到EAGAIN或0才能发现对端关闭。
+     * @return >=0表示本次累计读取的字节数，返回值等于调用前的剩余空间时可能仍有数据未读。
+     *         -1表示对端关闭或读取异常，此前已读取的数据仍在缓存中，见Position()。
+     */
+    ssize_t ReadAll(RuntimeError & e) {
+        size_t start = m_pos;
+        while ( m_pos < m_size ) {
+            size_t  limit = m_size - m_pos;
+            ssize_t r = this->Read(limit, e);
+            if ( r < 0 ) return -1;           // 对端关闭或读取异常
+            if ( r == 0 ) break;              // EAGAIN
+        }
+        return (ssize_t)(m_pos - start);
+    }
     
     ssize_t Read(InetSocketAddress *endp, RuntimeError &e) {
         socklen_t addrlen = endp->caddrsize();
@@ -83,7 +106,7 @@ public:
     /**
      * @brief 缓存写入位置归零, 或者设置到指定位置。
      */
-    void    Reset(size_t pos = 0) { assert(pos <= m_size); m_pos == pos;  }
+    void    Reset(size_t pos = 0) { assert(pos <= m_size); m_pos = pos;  }
     size_t  Position() const { return m_pos; }
     size_t  Size() const { return m_size; }
     char *  Buffer() const { return m_buffer; }
@@ -116,8 +139,8 @@ public:
      * @return >0表示实际写入的字节数。0表示对端关闭。-1表示写入异常，根据error确定异常内容。
      */
     ssize_t Write(size_t limit, RuntimeError & error) {
-        assert(m_pos + limit > m_size);
-        ssize_t r = ::send(m_fd, m_buffer + m_pos, limit, 0);
+        assert(m_pos + limit <= m_size);
+        ssize_t r = ::send(m_fd, m_buffer + m_pos, limit, MSG_NOSIGNAL);   // 对端已关闭时返回EPIPE，不产生SIGPIPE
         if ( r >= 0 )  { m_pos += r;  return r; }  // 发送r个字节(包括0个字节)
         else {     // 发送失败。包含非阻塞无消息可读
             int en = errno;
@@ -133,8 +156,25 @@ public:
         return this->Write(limit, e);
     }
 
+    /**
+     * @brief 循环写入直到缓存写完或EAGAIN，用于边沿触发模式。
+     * 部分写入后发送缓冲可能已被对端确认腾出空间，继续写到EAGAIN，
+     * 否则边沿触发下不会再有可写事件。
+     * @return >=0表示本次累计写入的字节数，-1表示写入异常。
+     */
+    ssize_t WriteAll(RuntimeError & e) {
+        size_t start = m_pos;
+        while ( m_pos < m_size ) {
+            size_t  limit = m_size - m_pos;
+            ssize_t r = this->Write(limit, e);
+            if ( r < 0 ) return -1;
+            if ( r == 0 ) break;              // 发送缓冲已满(EAGAIN)
+        }
+        return (ssize_t)(m_pos - start);
+    }
+
     ssize_t Write(InetSocketAddress & endp, RuntimeError &e) {
-        ssize_t r = ::sendto(m_fd, m_buffer + m_pos, m_size - m_pos, 0,
+        ssize_t r = ::sendto(m_fd, m_buffer + m_pos, m_size - m_pos, MSG_NOSIGNAL,
                             endp.caddr(), endp.caddrsize());
         if ( r >= 0 )  { m_pos += r;  return r; }  // 发送r个字节(包括0个字节)
         else {     // 发送失败。包含非阻塞无消息可读
@@ -156,5 +196,260 @@ public:
     ssize_t operator() (RuntimeError &e ) { return this->Write(e); }
 }; // end class SocketWriterImpl
 
+/**
+ * @brief 分散读取和集中写入，一次系统调用读写多段缓存。
+ */
+class SocketVectorIoImpl {
+public:
+    /**
+     * @brief 以readv读取到多段缓存，依次填满前面的缓存。
+     * @return >0表示实际读取的字节数，0表示非阻塞未读到数据，-1表示对端关闭或读取异常。
+     */
+    static ssize_t Readv(int fd, const struct iovec *iov, int iovcnt, RuntimeError &e) {
+        ssize_t r = ::readv(fd, iov, iovcnt);
+        if ( r > 0 ) return r;
+        if ( r == 0 ) {
+            std::ostringstream oss;
+            oss<<"readv() failed, connection closed by peer. fd: "<<fd;
+            e.set(-1, oss.str().c_str(), "SocketVectorIoImpl::Readv");
+            return -1;
+        }
+        int eno = errno;
+        if ( eno == EAGAIN || eno == EWOULDBLOCK ) return 0;  // 非阻塞未读到数据
+        std::ostringstream oss;
+        oss<<"readv() failed, "<<sockerr<<" fd: "<<fd<<", iovcnt: "<<iovcnt;
+        e.set(-1, oss.str().c_str(), "SocketVectorIoImpl::Readv");
+        return -1;
+    }
+
+    /**
+     * @brief 写入多段缓存，以sendmsg代替writev，才能带MSG_NOSIGNAL。
+     * @return >=0表示实际写入的字节数，0表示非阻塞时发送缓冲已满，-1表示写入异常。
+     */
+    static ssize_t Writev(int fd, const struct iovec *iov, int iovcnt, RuntimeError &e) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = const_cast<struct iovec *>(iov);
+        msg.msg_iovlen = iovcnt;
+        ssize_t r = ::sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if ( r >= 0 ) return r;
+        int eno = errno;
+        if ( eno == EAGAIN || eno == EWOULDBLOCK ) return 0;
+        std::ostringstream oss;
+        oss<<"sendmsg() failed, "<<sockerr<<" fd: "<<fd<<", iovcnt: "<<iovcnt;
+        e.set(-1, oss.str().c_str(), "SocketVectorIoImpl::Writev");
+        return -1;
+    }
+}; // end class SocketVectorIoImpl
+
+/**
+ * @brief 数据报文的批量收发，以sendmmsg/recvmmsg一次系统调用处理多个报文。
+ * 消息头、iovec、地址和控制消息缓存都在栈上，每批最多MaxBatch个报文，超出部分分批处理。
+ * 报文的segmentSize非0时以UDP_SEGMENT控制消息发送，接收时从UDP_GRO控制消息取得分段长度。
+ */
+class DatagramBatchImpl {
+public:
+    static const size_t MaxBatch = 64;
+
+private:
+    union ControlBuffer {
+        char           buf[CMSG_SPACE(sizeof(int))];
+        struct cmsghdr align;
+    };
+
+public:
+    static ssize_t Send(int fd, const DatagramPacket *packets, size_t n, RuntimeError &e) {
+        struct mmsghdr msgs[MaxBatch];
+        struct iovec   iovs[MaxBatch];
+        ControlBuffer  ctrls[MaxBatch];
+        size_t sent = 0;
+        while ( sent < n ) {
+            size_t cnt = n - sent < MaxBatch ? n - sent : MaxBatch;
+            for ( size_t i = 0; i < cnt; ++i ) {
+                const DatagramPacket &pkt = packets[sent + i];
+                iovs[i].iov_base = pkt.buffer();
+                iovs[i].iov_len  = pkt.length();
+                struct msghdr &hdr = msgs[i].msg_hdr;
+                memset(&hdr, 0, sizeof(hdr));
+                if ( pkt.endpoint() ) {
+                    hdr.msg_name    = (void *)pkt.endpoint()->caddr();
+                    hdr.msg_namelen = pkt.endpoint()->caddrsize();
+                }
+                hdr.msg_iov    = &iovs[i];
+                hdr.msg_iovlen = 1;
+                if ( pkt.segmentSize() > 0 ) {
+                    hdr.msg_control    = ctrls[i].buf;
+                    hdr.msg_controllen = CMSG_SPACE(sizeof(uint16_t));
+                    struct cmsghdr *cm = CMSG_FIRSTHDR(&hdr);
+                    cm->cmsg_level = SOL_UDP;
+                    cm->cmsg_type  = UDP_SEGMENT;
+                    cm->cmsg_len   = CMSG_LEN(sizeof(uint16_t));
+                    uint16_t segsize = (uint16_t)pkt.segmentSize();
+                    memcpy(CMSG_DATA(cm), &segsize, sizeof(segsize));
+                }
+            }
+
+            int r = ::sendmmsg(fd, msgs, (unsigned)cnt, MSG_NOSIGNAL);
+            if ( r < 0 ) {
+                int eno = errno;
+                if ( eno == EINTR ) continue;
+                if ( eno == EAGAIN || eno == EWOULDBLOCK ) break;   // 发送缓冲已满
+                if ( sent > 0 ) break;      // 已发送的报文先报告给调用者，错误留给下一次调用
+                std::ostringstream oss;
+                oss<<"sendmmsg() failed, "<<sockerr<<" fd: "<<fd<<", vlen: "<<cnt;
+                e.set(-1, oss.str().c_str(), "DatagramBatchImpl::Send");
+                return -1;
+            }
+            sent += r;
+            if ( (size_t)r < cnt ) break;
+        }
+        return (ssize_t)sent;
+    }
+
+    static ssize_t Receive(int fd, DatagramPacket *packets, size_t n, RuntimeError &e) {
+        struct mmsghdr          msgs[MaxBatch];
+        struct iovec            iovs[MaxBatch];
+        struct sockaddr_storage addrs[MaxBatch];
+        ControlBuffer           ctrls[MaxBatch];
+        size_t received = 0;
+        while ( received < n ) {
+            size_t cnt = n - received < MaxBatch ? n - received : MaxBatch;
+            for ( size_t i = 0; i < cnt; ++i ) {
+                DatagramPacket &pkt = packets[received + i];
+                iovs[i].iov_base = pkt.buffer() + pkt.length();
+                iovs[i].iov_len  = pkt.capacity() - pkt.length();
+                struct msghdr &hdr = msgs[i].msg_hdr;
+                memset(&hdr, 0, sizeof(hdr));
+                hdr.msg_name       = &addrs[i];
+                hdr.msg_namelen    = sizeof(addrs[i]);
+                hdr.msg_iov        = &iovs[i];
+                hdr.msg_iovlen     = 1;
+                hdr.msg_control    = ctrls[i].buf;
+                hdr.msg_controllen = sizeof(ctrls[i].buf);
+            }
+
+            // 第一批收到一个报文即返回，之后的批次只取已到达的报文。
+            int flags = received == 0 ? MSG_WAITFORONE : MSG_DONTWAIT;
+            int r = ::recvmmsg(fd, msgs, (unsigned)cnt, flags, nullptr);
+            if ( r < 0 ) {
+                int eno = errno;
+                if ( eno == EINTR && received == 0 ) continue;
+                if ( eno == EAGAIN || eno == EWOULDBLOCK || received > 0 ) break;
+                std::ostringstream oss;
+                oss<<"recvmmsg() failed, "<<sockerr<<" fd: "<<fd<<", vlen: "<<cnt;
+                e.set(-1, oss.str().c_str(), "DatagramBatchImpl::Receive");
+                return -1;
+            }
+
+            for ( int i = 0; i < r; ++i ) {
+                DatagramPacket &pkt = packets[received + i];
+                struct msghdr  &hdr = msgs[i].msg_hdr;
+                pkt.setbuflen(pkt.length() + msgs[i].msg_len);
+                pkt.setSegmentSize(GroSegmentSize(&hdr));
+                if ( pkt.endpoint() ) {
+                    pkt.endpoint()->assign((const struct sockaddr *)&addrs[i], hdr.msg_namelen);
+                }
+            }
+            received += r;
+            if ( (size_t)r < cnt ) break;
+        }
+        return (ssize_t)received;
+    }
+
+private:
+    /// 取UDP_GRO控制消息中的分段长度，报文未经合并时返回0。
+    static size_t GroSegmentSize(struct msghdr *hdr) {
+        for ( struct cmsghdr *cm = CMSG_FIRSTHDR(hdr); cm != nullptr; cm = CMSG_NXTHDR(hdr, cm) ) {
+            if ( cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO ) {
+                int segsize;
+                memcpy(&segsize, CMSG_DATA(cm), sizeof(segsize));
+                return (size_t)segsize;
+            }
+        }
+        return 0;
+    }
+}; // end class DatagramBatchImpl
+
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif // MSG_ZEROCOPY
+
+/**
+ * @brief MSG_ZEROCOPY发送及错误队列中完成通知的读取。
+ * 每次成功(发送字节数>0)的零拷贝发送占用一个通知序号，序号从0开始按发送次数递增，
+ * 内核以[lo, hi]区间批量通知这些发送引用的用户内存已释放。
+ */
+class SocketZeroCopyImpl {
+public:
+    /**
+     * @brief 以MSG_ZEROCOPY发送，返回值含义与SocketWriterImpl::Write相同。
+     */
+    static ssize_t Send(int fd, const char *buf, size_t len, RuntimeError &e) {
+        ssize_t r = ::send(fd, buf, len, MSG_ZEROCOPY | MSG_NOSIGNAL);
+        if ( r >= 0 ) return r;
+        int eno = errno;
+        if ( eno == EAGAIN || eno == EWOULDBLOCK ) return 0;
+        std::ostringstream oss;
+        oss<<"send(MSG_ZEROCOPY) failed, "<<sockerr<<" fd: "<<fd<<", len: "<<len;
+        e.set(-1, oss.str().c_str(), "SocketZeroCopyImpl::Send");
+        return -1;
+    }
+
+    /**
+     * @brief 从错误队列读取一条零拷贝完成通知。
+     * @param copied 输出内核是否实际退回了复制发送(如回环地址)，此时零拷贝没有收益。
+     * @return 1表示读到通知，0表示错误队列已空，-1表示读取失败或socket有未决错误。
+     */
+    static int ReadCompletion(int fd, uint32_t *lo, uint32_t *hi, bool *copied, RuntimeError &e) {
+        for ( ;; ) {
+            union {
+                char           buf[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+                struct cmsghdr align;
+            } ctrl;
+            struct msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_control    = ctrl.buf;
+            msg.msg_controllen = sizeof(ctrl.buf);
+
+            ssize_t r = ::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT);
+            if ( r < 0 ) {
+                int eno = errno;
+                if ( eno == EINTR ) continue;
+                if ( eno == EAGAIN || eno == EWOULDBLOCK ) return CheckSocketError(fd, e);
+                std::ostringstream oss;
+                oss<<"recvmsg(MSG_ERRQUEUE) failed, "<<sockerr<<" fd: "<<fd;
+                e.set(-1, oss.str().c_str(), "SocketZeroCopyImpl::ReadCompletion");
+                return -1;
+            }
+
+            for ( struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm) ) {
+                bool isrecverr = (cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR)
+                              || (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR);
+                if ( !isrecverr ) continue;
+                struct sock_extended_err serr;
+                memcpy(&serr, CMSG_DATA(cm), sizeof(serr));
+                if ( serr.ee_errno != 0 || serr.ee_origin != SO_EE_ORIGIN_ZEROCOPY ) continue;
+                *lo = serr.ee_info;
+                *hi = serr.ee_data;
+                *copied = (serr.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+                return 1;
+            }
+            // 其他来源的错误消息(如ICMP)，跳过继续读取。
+        }
+    }
+
+private:
+    /// 错误队列为空时检查socket的未决错误，避免EPOLLERR持续触发而无从处理。
+    static int CheckSocketError(int fd, RuntimeError &e) {
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if ( ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0 ) return 0;
+        std::ostringstream oss;
+        oss<<"socket error, errno: "<<err<<", errmsg: "<<strerror(err)<<", fd: "<<fd;
+        e.set(-1, oss.str().c_str(), "SocketZeroCopyImpl::ReadCompletion");
+        return -1;
+    }
+}; // end class SocketZeroCopyImpl
+
 } // end namespace net
 } // end namespace mercury
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <netinet/tcp.h>
+#include <netinet/udp.h>
 
 #include "socket_utils.h"
 
@@ -12,6 +13,7 @@ namespace net {
 
 class SocketOptImpl;
 class SocketOptReuseAddr;
+class SocketOptReusePort;
 class SocketOptRecvBuffer;
 class SocketOptSendBuffer;
 class SocketOptRecvTimeout;
@@ -19,6 +21,9 @@ class SocketOptSendTimeout;
 class SocketOptKeepAlive;
 class SocketOptLinger;
 class SocketOptTcpNoDelay;
+class SocketOptUdpSegment;
+class SocketOptUdpGro;
+class SocketOptZeroCopy;
 
 /**
  * @brief Socket Option访问基类。
@@ -76,6 +81,23 @@ public:
     }
 }; // end class SocketOptReuseAddr
 
+/**
+ * @brief SOL_SOCKET/SO_REUSEPORT选项操作类，允许多个socket绑定同一端口，由内核分发连接。
+ */ 
+class SocketOptReusePort : protected SocketOptImpl {
+public:
+    SocketOptReusePort(int fd) : SocketOptImpl(fd, SOL_SOCKET, SO_REUSEPORT) {}
+    
+    bool Get(int * enable, RuntimeError &errinfo) {
+        socklen_t len  = sizeof(*enable);
+        return SocketOptImpl::Get(enable, &len, errinfo);
+    }
+
+    bool Set(int enable, RuntimeError &errinfo) {
+        return SocketOptImpl::Set(&enable, sizeof(enable), errinfo);
+    }
+}; // end class SocketOptReusePort
+
 class SocketOptRecvBuffer : protected SocketOptImpl {
 public:
     SocketOptRecvBuffer(int fd) : SocketOptImpl(fd, SOL_SOCKET, SO_RCVBUF) {}
@@ -179,6 +201,63 @@ public:
     }
 }; // end class SocketOptTcpNoDelay
 
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif // UDP_SEGMENT
+
+#ifndef UDP_GRO
+#define UDP_GRO     104
+#endif // UDP_GRO
+
+/**
+ * @brief SOL_UDP/UDP_SEGMENT选项操作类，设置后发送的大报文由内核按此长度分段(GSO)，0表示关闭。
+ */
+class SocketOptUdpSegment : protected SocketOptImpl {
+public:
+    SocketOptUdpSegment(int fd) : SocketOptImpl(fd, SOL_UDP, UDP_SEGMENT) {}
+    bool Get(int *value, RuntimeError &e) {
+        socklen_t len = sizeof(*value);
+        return SocketOptImpl::Get(value, &len, e);
+    }
+    bool Set(int value, RuntimeError &e) {
+        return SocketOptImpl::Set(&value, sizeof(value), e);
+    }
+}; // end class SocketOptUdpSegment
+
+/**
+ * @brief SOL_UDP/UDP_GRO选项操作类，开启后接收的同流报文可由内核合并为一个大报文(GRO)。
+ */
+class SocketOptUdpGro : protected SocketOptImpl {
+public:
+    SocketOptUdpGro(int fd) : SocketOptImpl(fd, SOL_UDP, UDP_GRO) {}
+    bool Get(int *value, RuntimeError &e) {
+        socklen_t len = sizeof(*value);
+        return SocketOptImpl::Get(value, &len, e);
+    }
+    bool Set(int value, RuntimeError &e) {
+        return SocketOptImpl::Set(&value, sizeof(value), e);
+    }
+}; // end class SocketOptUdpGro
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif // SO_ZEROCOPY
+
+/**
+ * @brief SOL_SOCKET/SO_ZEROCOPY选项操作类，开启后才能以MSG_ZEROCOPY发送。
+ */
+class SocketOptZeroCopy : protected SocketOptImpl {
+public:
+    SocketOptZeroCopy(int fd) : SocketOptImpl(fd, SOL_SOCKET, SO_ZEROCOPY) {}
+    bool Get(int *value, RuntimeError &e) {
+        socklen_t len = sizeof(*value);
+        return SocketOptImpl::Get(value, &len, e);
+    }
+    bool Set(int value, RuntimeError &e) {
+        return SocketOptImpl::Set(&value, sizeof(value), e);
+    }
+}; // end class SocketOptZeroCopy
+
 
 
 } // end namespace net
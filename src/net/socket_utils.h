@@ -18,12 +18,12 @@ namespace net {
      * @brief 将Socket错误信息输出到传入的输出流。
      * @param oss       输出流，Socket错误消息将被输出此流对象中。
      */
-    inline std::ostringstream & sockerr(std::ostringstream &oss) {
+    inline std::ostream & sockerr(std::ostream &oss) {
         int e = errno;
         oss<<" socket errno: "<<e<<", errmsg: "<<strerror(e)<<". ";
         return oss;
     }
-    inline std::ostringstream & syserr(std::ostringstream &oss) {
+    inline std::ostream & syserr(std::ostream &oss) {
         int e = errno;
         oss<<" sys errno: "<<e<<", errmsg: "<<strerror(e)<<". ";
         return oss;
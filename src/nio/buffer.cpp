@@ -1,9 +1,99 @@
 #include <mercury/nio/buffer.h>
+#include "byte_swap.h"
+#include "varint.h"
 #include <memory.h>
 
 namespace mercury {
 namespace nio {
 
+const char * ByteOrder::swap_kernel() {
+    return nio::swap_kernel();
+}
+
+ByteBuffer ByteBuffer::allocate(size_t cap) {
+    ByteBuffer buf;
+    buf.m_block = BufferPool::allocate(cap);
+    buf.m_buf   = buf.m_block->data();
+    buf.m_cap   = cap;
+    buf.m_lim   = cap;
+    return buf;
+}
+
+ByteBuffer::ByteBuffer(const ByteBuffer &other)
+    : Buffer(other), m_ord(other.m_ord), m_block(other.m_block), m_readonly(other.m_readonly)
+{
+    if ( m_block ) BufferPool::retain(m_block);
+}
+
+ByteBuffer::ByteBuffer(ByteBuffer &&other)
+    : Buffer(other), m_ord(other.m_ord), m_block(other.m_block), m_readonly(other.m_readonly)
+{
+    other.m_block = nullptr;
+    other.m_buf = nullptr;
+    other.m_cap = other.m_pos = other.m_lim = other.m_mark = 0;
+}
+
+ByteBuffer::~ByteBuffer() {
+    if ( m_block ) BufferPool::release(m_block);
+    m_block = nullptr;
+}
+
+ByteBuffer & ByteBuffer::operator=(const ByteBuffer &other) {
+    if ( this != &other ) {
+        if ( other.m_block ) BufferPool::retain(other.m_block);
+        if ( m_block ) BufferPool::release(m_block);
+        Buffer::operator=(other);
+        m_ord   = other.m_ord;
+        m_block = other.m_block;
+        m_readonly = other.m_readonly;
+    }
+    return *this;
+}
+
+ByteBuffer & ByteBuffer::operator=(ByteBuffer &&other) {
+    if ( this != &other ) {
+        if ( m_block ) BufferPool::release(m_block);
+        Buffer::operator=(other);
+        m_ord   = other.m_ord;
+        m_block = other.m_block;
+        m_readonly = other.m_readonly;
+        other.m_block = nullptr;
+        other.m_buf = nullptr;
+        other.m_cap = other.m_pos = other.m_lim = other.m_mark = 0;
+    }
+    return *this;
+}
+
+ByteBuffer ByteBuffer::slice() const {
+    return this->slice(m_pos, Buffer::remaining());
+}
+
+ByteBuffer ByteBuffer::slice(size_t idx, size_t len) const {
+    assert( idx <= m_lim && m_lim - idx >= len );
+    ByteBuffer view(*this);
+    view.m_buf  = (char *)m_buf + idx;
+    view.m_cap  = len;
+    view.m_lim  = len;
+    view.m_pos  = 0;
+    view.m_mark = 0;
+    return view;
+}
+
+ByteBuffer ByteBuffer::as_read_only() const {
+    ByteBuffer view(*this);
+    view.m_readonly = true;
+    return view;
+}
+
+void ByteBuffer::compact() {
+    assert( !m_readonly );
+    size_t remain = Buffer::remaining();
+    if ( remain > 0 && m_pos > 0 ) memmove(m_buf, (char *)m_buf + m_pos, remain);
+    m_pos  = remain;
+    m_lim  = m_cap;
+    m_mark = 0;
+}
+
 char ByteBuffer::get() {
     assert(Buffer::remaining() >= sizeof(char));
     char * p = Buffer::get<char>(m_pos);
@@ -15,7 +105,7 @@ size_t ByteBuffer::get(char *array, size_t len) {
     size_t remain = Buffer::remaining();
     if ( len > remain )  len = remain;
     const char *p = Buffer::get<char>(m_pos);
-    assert( array < p && array >= p + len);  // 复制区域不能重叠检查
+    assert( array + len <= p || array >= p + len );  // 复制区域不能重叠检查
     memcpy(array, p, len);
     m_pos += len;
     return len;
@@ -24,77 +114,111 @@ size_t ByteBuffer::get(char *array, size_t len) {
 size_t ByteBuffer::get(size_t idx, char *array, size_t len) const {
     size_t remain = Buffer::limit() - idx;
     if ( len > remain )  len = remain;
-    const char *p = Buffer::get<char>(m_pos);
-    assert( array < p && array >= p + len);  // 复制区域不能重叠检查
+    const char *p = Buffer::get<char>(idx);
+    assert( array + len <= p || array >= p + len );  // 复制区域不能重叠检查
     memcpy(array, p, len);
     return len;
 }
 
 int16_t ByteBuffer::get_int16() {
-    assert(Buffer::remaining() >= sizeof(int16_t));
-    const int16_t *p = Buffer::get<int16_t>(m_pos);
-    m_pos += sizeof(sizeof(int16_t));
-    return m_ord(*p);
+    return this->load<int16_t>(this->advance(sizeof(int16_t)));
 }
 
 int16_t ByteBuffer::get_int16(size_t idx) const {
-    assert(Buffer::limit() - idx >= sizeof(int16_t));
-    const int16_t *p = Buffer::get<int16_t>(idx);
-    return m_ord(*p);
+    return this->load<int16_t>(idx);
 }
 
 int32_t ByteBuffer::get_int32() {
-    assert(Buffer::remaining() >= sizeof(int32_t));
-    const int32_t *p = Buffer::get<int32_t>(m_pos);
-    m_pos += sizeof(sizeof(int32_t));
-    return m_ord(*p);
+    return this->load<int32_t>(this->advance(sizeof(int32_t)));
 }
 
 int32_t ByteBuffer::get_int32(size_t idx) const {
-    assert(Buffer::limit() - idx >= sizeof(int32_t));
-    const int32_t *p = Buffer::get<int32_t>(idx);
-    return m_ord(*p);
+    return this->load<int32_t>(idx);
 }
 
 int64_t ByteBuffer::get_int64() {
-    assert(Buffer::remaining() > sizeof(int64_t));
-    const int64_t *p = Buffer::get<int64_t>(m_pos);
-    m_pos += sizeof(sizeof(int64_t));
-    return m_ord(*p);
+    return this->load<int64_t>(this->advance(sizeof(int64_t)));
 }
 
 int64_t ByteBuffer::get_int64(size_t idx) const {
-    assert(Buffer::limit() - idx >= sizeof(int64_t));
-    const int64_t *p = Buffer::get<int64_t>(idx);
-    return m_ord(*p);
+    return this->load<int64_t>(idx);
+}
+
+float ByteBuffer::get_float() {
+    return this->load<float>(this->advance(sizeof(float)));
+}
+
+float ByteBuffer::get_float(size_t idx) const {
+    return this->load<float>(idx);
+}
+
+double ByteBuffer::get_double() {
+    return this->load<double>(this->advance(sizeof(double)));
+}
+
+double ByteBuffer::get_double(size_t idx) const {
+    return this->load<double>(idx);
+}
+
+void ByteBuffer::load_array(size_t idx, void *array, size_t n, size_t width) const {
+    assert( idx <= m_lim && (m_lim - idx) / width >= n );
+    const char *p = (const char *)m_buf + idx;
+    if ( m_ord.need_swap() ) swap_copy(array, p, n, width);
+    else if ( n > 0 ) memcpy(array, p, n * width);
 }
 
-float   ByteBuffer::get_float() {
-    assert(Buffer::remaining() >= sizeof(float));
-    const float *p = Buffer::get<float>(m_pos);
-    m_pos += sizeof(sizeof(float));
-    return m_ord(*p);
+void ByteBuffer::get_int16s(int16_t *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(int16_t) >= n );
+    this->load_array(m_pos, array, n, sizeof(int16_t));
+    m_pos += n * sizeof(int16_t);
 }
-float   ByteBuffer::get_float(size_t idx) const {
-    assert(Buffer::limit() - idx >= sizeof(float));
-    const float *p = Buffer::get<float>(idx);
-    return m_ord(*p);
+
+void ByteBuffer::get_int16s(size_t idx, int16_t *array, size_t n) const {
+    this->load_array(idx, array, n, sizeof(int16_t));
+}
+
+void ByteBuffer::get_int32s(int32_t *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(int32_t) >= n );
+    this->load_array(m_pos, array, n, sizeof(int32_t));
+    m_pos += n * sizeof(int32_t);
+}
+
+void ByteBuffer::get_int32s(size_t idx, int32_t *array, size_t n) const {
+    this->load_array(idx, array, n, sizeof(int32_t));
+}
+
+void ByteBuffer::get_int64s(int64_t *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(int64_t) >= n );
+    this->load_array(m_pos, array, n, sizeof(int64_t));
+    m_pos += n * sizeof(int64_t);
+}
+
+void ByteBuffer::get_int64s(size_t idx, int64_t *array, size_t n) const {
+    this->load_array(idx, array, n, sizeof(int64_t));
+}
+
+void ByteBuffer::get_floats(float *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(float) >= n );
+    this->load_array(m_pos, array, n, sizeof(float));
+    m_pos += n * sizeof(float);
 }
 
-double  ByteBuffer::get_double() {
-    assert(Buffer::remaining() >= sizeof(double));
-    const double *p = Buffer::get<double>(m_pos);
-    m_pos += sizeof(sizeof(double));
-    return m_ord(*p);
+void ByteBuffer::get_floats(size_t idx, float *array, size_t n) const {
+    this->load_array(idx, array, n, sizeof(float));
 }
 
-double  ByteBuffer::get_double(size_t idx) const {
-    assert(Buffer::limit() - idx >= sizeof(double));
-    const double *p = Buffer::get<double>(idx);
-    return m_ord(*p);
+void ByteBuffer::get_doubles(double *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(double) >= n );
+    this->load_array(m_pos, array, n, sizeof(double));
+    m_pos += n * sizeof(double);
+}
+
+void ByteBuffer::get_doubles(size_t idx, double *array, size_t n) const {
+    this->load_array(idx, array, n, sizeof(double));
 }
 
 void ByteBuffer::put(char ch) {
+    assert( !m_readonly );
     assert(Buffer::remaining() >= sizeof(char));
     char * p = Buffer::get<char>(m_pos);
     ++m_pos;
@@ -102,12 +226,14 @@ void ByteBuffer::put(char ch) {
 }
 
 void ByteBuffer::put(size_t idx, char ch) {
+    assert( !m_readonly );
     assert(Buffer::limit() - idx >= sizeof(char));
     char *p = Buffer::get<char>(idx);
     *p = ch;
 }
 
 void ByteBuffer::put(const char *array, size_t len) {
+    assert( !m_readonly );
     assert(Buffer::remaining() >= len );
     char *p = Buffer::get<char>(m_pos);
     memcpy(p, array, len);
@@ -115,73 +241,165 @@ void ByteBuffer::put(const char *array, size_t len) {
 }
 
 void ByteBuffer::put(size_t idx, const char *array, size_t len) {
-    assert(Buffer::limit() - idx >= sizeof(char));
+    assert( !m_readonly );
+    assert(Buffer::limit() - idx >= len);
     char *p = Buffer::get<char>(idx);
     memcpy(p, array, len);
 }
 
-void  ByteBuffer::put_int16(int16_t value) {
-    assert(Buffer::remaining() >= sizeof(int16_t));
-    int16_t *p = Buffer::get<int16_t>(m_pos);
-    m_pos += sizeof(sizeof(int16_t));
-    *p = m_ord(value);
+void ByteBuffer::put_int16(int16_t value) {
+    this->store<int16_t>(this->advance(sizeof(int16_t)), value);
+}
+
+void ByteBuffer::put_int16(size_t idx, int16_t value) {
+    this->store<int16_t>(idx, value);
+}
+
+void ByteBuffer::put_int32(int32_t value) {
+    this->store<int32_t>(this->advance(sizeof(int32_t)), value);
+}
+
+void ByteBuffer::put_int32(size_t idx, int32_t value) {
+    this->store<int32_t>(idx, value);
+}
+
+void ByteBuffer::put_int64(int64_t value) {
+    this->store<int64_t>(this->advance(sizeof(int64_t)), value);
+}
+
+void ByteBuffer::put_int64(size_t idx, int64_t value) {
+    this->store<int64_t>(idx, value);
+}
+
+void ByteBuffer::put_float(float value) {
+    this->store<float>(this->advance(sizeof(float)), value);
+}
+
+void ByteBuffer::put_float(size_t idx, float value) {
+    this->store<float>(idx, value);
+}
+
+void ByteBuffer::put_double(double value) {
+    this->store<double>(this->advance(sizeof(double)), value);
+}
+
+void ByteBuffer::put_double(size_t idx, double value) {
+    this->store<double>(idx, value);
+}
+
+void ByteBuffer::store_array(size_t idx, const void *array, size_t n, size_t width) {
+    assert( !m_readonly );
+    assert( idx <= m_lim && (m_lim - idx) / width >= n );
+    char *p = (char *)m_buf + idx;
+    if ( m_ord.need_swap() ) swap_copy(p, array, n, width);
+    else if ( n > 0 ) memcpy(p, array, n * width);
+}
+
+void ByteBuffer::put_int16s(const int16_t *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(int16_t) >= n );
+    this->store_array(m_pos, array, n, sizeof(int16_t));
+    m_pos += n * sizeof(int16_t);
+}
+
+void ByteBuffer::put_int16s(size_t idx, const int16_t *array, size_t n) {
+    this->store_array(idx, array, n, sizeof(int16_t));
+}
+
+void ByteBuffer::put_int32s(const int32_t *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(int32_t) >= n );
+    this->store_array(m_pos, array, n, sizeof(int32_t));
+    m_pos += n * sizeof(int32_t);
+}
+
+void ByteBuffer::put_int32s(size_t idx, const int32_t *array, size_t n) {
+    this->store_array(idx, array, n, sizeof(int32_t));
+}
+
+void ByteBuffer::put_int64s(const int64_t *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(int64_t) >= n );
+    this->store_array(m_pos, array, n, sizeof(int64_t));
+    m_pos += n * sizeof(int64_t);
 }
 
-void  ByteBuffer::put_int16(size_t idx, int16_t value) {
-    assert(Buffer::limit() - idx >= sizeof(int16_t));
-    int16_t *p = Buffer::get<int16_t>(idx);
-    *p = m_ord(value);
+void ByteBuffer::put_int64s(size_t idx, const int64_t *array, size_t n) {
+    this->store_array(idx, array, n, sizeof(int64_t));
 }
 
-void  ByteBuffer::put_int32(int32_t value) {
-    assert(Buffer::remaining() >= sizeof(int32_t));
-    int32_t *p = Buffer::get<int32_t>(m_pos);
-    m_pos += sizeof(sizeof(int32_t));
-    *p = m_ord(value);
+void ByteBuffer::put_floats(const float *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(float) >= n );
+    this->store_array(m_pos, array, n, sizeof(float));
+    m_pos += n * sizeof(float);
 }
 
-void  ByteBuffer::put_int32(size_t idx, int32_t value) {
-    assert(Buffer::limit() - idx >= sizeof(int32_t));
-    int32_t *p = Buffer::get<int32_t>(idx);
-    *p = m_ord(value);
+void ByteBuffer::put_floats(size_t idx, const float *array, size_t n) {
+    this->store_array(idx, array, n, sizeof(float));
 }
 
-void  ByteBuffer::put_int64(int64_t value) {
-    assert(Buffer::remaining() >= sizeof(int64_t));
-    int64_t *p = Buffer::get<int64_t>(m_pos);
-    m_pos += sizeof(sizeof(int64_t));
-    *p = m_ord(value);
+void ByteBuffer::put_doubles(const double *array, size_t n) {
+    assert( Buffer::remaining() / sizeof(double) >= n );
+    this->store_array(m_pos, array, n, sizeof(double));
+    m_pos += n * sizeof(double);
 }
-void  ByteBuffer::put_int64(size_t idx, int64_t value) {
-    assert(Buffer::limit() - idx >= sizeof(int64_t));
-    int64_t *p = Buffer::get<int64_t>(idx);
-    *p = m_ord(value);
+
+void ByteBuffer::put_doubles(size_t idx, const double *array, size_t n) {
+    this->store_array(idx, array, n, sizeof(double));
+}
+
+size_t ByteBuffer::varint_size(uint64_t value) {
+    return nio::varint_size(value);
+}
+
+void ByteBuffer::put_varint(uint64_t value) {
+    assert( !m_readonly );
+    assert( Buffer::remaining() >= nio::varint_size(value) );
+    m_pos += varint_encode((char *)m_buf + m_pos, value);
+}
+
+void ByteBuffer::put_svarint(int64_t value) {
+    this->put_varint(zigzag_encode(value));
+}
+
+bool ByteBuffer::get_varint(uint64_t &value) {
+    size_t n = varint_decode((const char *)m_buf + m_pos, Buffer::remaining(), &value);
+    m_pos += n;
+    return n > 0;
+}
+
+bool ByteBuffer::get_svarint(int64_t &value) {
+    uint64_t u;
+    if ( !this->get_varint(u) ) return false;
+    value = zigzag_decode(u);
+    return true;
 }
 
-void  ByteBuffer::put_float(float value) {
-    assert(Buffer::remaining() >= sizeof(float));
-    float *p = Buffer::get<float>(m_pos);
-    m_pos += sizeof(sizeof(float));
-    *p = m_ord(value);
+size_t ByteBuffer::put_varints(const uint64_t *array, size_t n) {
+    assert( !m_readonly );
+    size_t used;
+    n = varint_encode_n((char *)m_buf + m_pos, Buffer::remaining(), array, n, &used);
+    m_pos += used;
+    return n;
 }
 
-void  ByteBuffer::put_float(size_t idx, float value) {
-    assert(Buffer::limit() - idx >= sizeof(float));
-    float *p = Buffer::get<float>(idx);
-    *p = m_ord(value);
+size_t ByteBuffer::put_svarints(const int64_t *array, size_t n) {
+    assert( !m_readonly );
+    size_t used;
+    n = svarint_encode_n((char *)m_buf + m_pos, Buffer::remaining(), array, n, &used);
+    m_pos += used;
+    return n;
 }
 
-void  ByteBuffer::put_double(double value) {
-    assert(Buffer::remaining() >= sizeof(double));
-    double *p = Buffer::get<double>(m_pos);
-    m_pos += sizeof(sizeof(double));
-    *p = m_ord(value);
+size_t ByteBuffer::get_varints(uint64_t *array, size_t n) {
+    size_t used;
+    n = varint_decode_n((const char *)m_buf + m_pos, Buffer::remaining(), array, n, &used);
+    m_pos += used;
+    return n;
 }
 
-void  ByteBuffer::put_double(size_t idx, double value) {
-    assert(Buffer::limit() - idx >= sizeof(double));
-    double *p = Buffer::get<double>(idx);
-    *p = m_ord(value);
+size_t ByteBuffer::get_svarints(int64_t *array, size_t n) {
+    size_t used;
+    n = svarint_decode_n((const char *)m_buf + m_pos, Buffer::remaining(), array, n, &used);
+    m_pos += used;
+    return n;
 }
 
 }} // end namespace mercury::nio
\ No newline at end of file
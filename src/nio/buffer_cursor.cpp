@@ -0,0 +1,16 @@
+#include <mercury/nio/buffer_cursor.h>
+
+namespace mercury {
+namespace nio {
+
+void cursor_overflow(RuntimeError &e, const char *where, size_t need, size_t remain) {
+    std::ostringstream oss;
+    oss<<"buffer overflow, need: "<<need<<", remaining: "<<remain;
+    e.set(-1, oss.str().c_str(), where);
+}
+
+void cursor_readonly(RuntimeError &e, const char *where) {
+    e.set(-1, "read only buffer", where);
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,231 @@
+#include <mercury/nio/buffer_pool.h>
+#include <cassert>
+#include <mutex>
+#include <new>
+#include <stdlib.h>
+
+namespace mercury {
+namespace nio {
+
+static_assert( sizeof(BufferBlock) % 16 == 0, "BufferBlock header must keep data 16-byte aligned" );
+
+static std::atomic<uint64_t> g_system_allocs(0);
+static std::atomic<uint64_t> g_system_frees(0);
+
+/// 每个尺寸类线程缓存的块数上限，至少2块，最多2批。
+static inline size_t cache_limit(uint32_t cls) {
+    size_t n = BufferPool::CacheBytes / BufferPool::class_size(cls);
+    if ( n < 2 ) n = 2;
+    if ( n > 2 * BufferPool::MaxBatch ) n = 2 * BufferPool::MaxBatch;
+    return n;
+}
+
+static inline size_t depot_limit(uint32_t cls) {
+    size_t n = BufferPool::DepotBytes / BufferPool::class_size(cls);
+    return n < cache_limit(cls) ? cache_limit(cls) : n;
+}
+
+static BufferBlock * system_alloc(size_t size, uint32_t cls) {
+    void *p = ::malloc(sizeof(BufferBlock) + size);
+    if ( p == nullptr ) throw std::bad_alloc();
+    g_system_allocs.fetch_add(1, std::memory_order_relaxed);
+    BufferBlock *block = (BufferBlock *)p;
+    new (&block->refs) std::atomic<uint32_t>(0);
+    block->cls  = cls;
+    block->size = size;
+    block->next = nullptr;
+    return block;
+}
+
+static void system_free(BufferBlock *block) {
+    g_system_frees.fetch_add(1, std::memory_order_relaxed);
+    ::free(block);
+}
+
+/**
+ * @brief 全局仓库，每个尺寸类一个加锁的空闲链表。进程退出时不析构，
+ * 以免静态对象析构后仍有缓存被释放。
+ */
+class BufferDepot {
+private:
+    struct Class {
+        std::mutex    lock;
+        BufferBlock * head;
+        size_t        count;
+        Class() : head(nullptr), count(0) {}
+    };
+    Class m_classes[BufferPool::Classes];
+
+public:
+    static BufferDepot & instance() {
+        static BufferDepot * depot = new BufferDepot();
+        return *depot;
+    }
+
+    /// 放入以head开始、以nullptr结尾的链表，超出上限的部分归还系统。
+    void put(uint32_t cls, BufferBlock *head) {
+        Class &c = m_classes[cls];
+        size_t limit = depot_limit(cls);
+        {
+            std::lock_guard<std::mutex> guard(c.lock);
+            while ( head && c.count < limit ) {
+                BufferBlock *next = head->next;
+                head->next = c.head;
+                c.head = head;
+                ++c.count;
+                head = next;
+            }
+        }
+        while ( head ) {
+            BufferBlock *next = head->next;
+            system_free(head);
+            head = next;
+        }
+    }
+
+    /// 取出最多n个块，返回链表头，取出的数量写入*got。
+    BufferBlock * take(uint32_t cls, size_t n, size_t *got) {
+        Class &c = m_classes[cls];
+        std::lock_guard<std::mutex> guard(c.lock);
+        BufferBlock *head = c.head, *tail = nullptr;
+        size_t cnt = 0;
+        for ( BufferBlock *p = head; p && cnt < n; p = p->next ) { tail = p; ++cnt; }
+        if ( tail ) {
+            c.head = tail->next;
+            tail->next = nullptr;
+            c.count -= cnt;
+        } else {
+            head = nullptr;
+        }
+        *got = cnt;
+        return head;
+    }
+}; // end class BufferDepot
+
+/**
+ * @brief 线程缓存，各尺寸类一个后进先出的空闲链表，最近释放的块最先被重用。
+ */
+class BufferThreadCache {
+private:
+    struct Class {
+        BufferBlock * head;
+        size_t        count;
+    };
+    Class m_classes[BufferPool::Classes];
+
+public:
+    BufferThreadCache();
+    ~BufferThreadCache();
+
+    BufferBlock * pop(uint32_t cls) {
+        Class &c = m_classes[cls];
+        if ( c.head == nullptr ) {
+            size_t got;
+            c.head = BufferDepot::instance().take(cls, cache_limit(cls) / 2, &got);
+            c.count = got;
+            if ( c.head == nullptr ) return nullptr;
+        }
+        BufferBlock *block = c.head;
+        c.head = block->next;
+        --c.count;
+        return block;
+    }
+
+    void push(BufferBlock *block) {
+        uint32_t cls = block->cls;
+        Class &c = m_classes[cls];
+        block->next = c.head;
+        c.head = block;
+        if ( ++c.count > cache_limit(cls) ) this->spill(cls, cache_limit(cls) / 2);
+    }
+
+    /// 把n个块交给全局仓库。
+    void spill(uint32_t cls, size_t n) {
+        Class &c = m_classes[cls];
+        BufferBlock *head = c.head, *tail = nullptr;
+        size_t cnt = 0;
+        for ( BufferBlock *p = head; p && cnt < n; p = p->next ) { tail = p; ++cnt; }
+        if ( tail == nullptr ) return;
+        c.head = tail->next;
+        c.count -= cnt;
+        tail->next = nullptr;
+        BufferDepot::instance().put(cls, head);
+    }
+
+    void flush() {
+        for ( uint32_t cls = 0; cls < BufferPool::Classes; ++cls ) this->spill(cls, m_classes[cls].count);
+    }
+}; // end class BufferThreadCache
+
+// 线程缓存的状态，析构后在本线程分配和释放的块直接经由全局仓库。
+enum { CacheUnused, CacheAlive, CacheDestroyed };
+static thread_local int t_cache_state = CacheUnused;
+static thread_local BufferThreadCache t_cache;
+
+BufferThreadCache::BufferThreadCache() {
+    for ( size_t i = 0; i < BufferPool::Classes; ++i ) {
+        m_classes[i].head  = nullptr;
+        m_classes[i].count = 0;
+    }
+    t_cache_state = CacheAlive;
+}
+
+BufferThreadCache::~BufferThreadCache() {
+    t_cache_state = CacheDestroyed;
+    this->flush();
+}
+
+uint32_t BufferPool::size_class(size_t size) {
+    if ( size <= ((size_t)1 << MinClassBits) ) return 0;
+    if ( size > ((size_t)1 << MaxClassBits) ) return LargeClass;
+    // 向上取整到2的幂
+    size_t bits = 64 - __builtin_clzll((unsigned long long)(size - 1));
+    return (uint32_t)(bits - MinClassBits);
+}
+
+BufferBlock * BufferPool::allocate(size_t size) {
+    uint32_t cls = size_class(size);
+    BufferBlock *block = nullptr;
+    if ( cls == LargeClass ) {
+        block = system_alloc(size, LargeClass);
+    } else {
+        // 首次访问t_cache时构造线程缓存
+        if ( t_cache_state != CacheDestroyed ) {
+            block = t_cache.pop(cls);
+        } else {
+            size_t got;
+            block = BufferDepot::instance().take(cls, 1, &got);
+        }
+        if ( block == nullptr ) block = system_alloc(class_size(cls), cls);
+    }
+    block->next = nullptr;
+    block->refs.store(1, std::memory_order_relaxed);
+    return block;
+}
+
+void BufferPool::release(BufferBlock *block) {
+    if ( block->refs.fetch_sub(1, std::memory_order_acq_rel) != 1 ) return;
+    if ( block->cls == LargeClass ) {
+        system_free(block);
+        return;
+    }
+    if ( t_cache_state != CacheDestroyed ) {
+        t_cache.push(block);
+    } else {
+        block->next = nullptr;
+        BufferDepot::instance().put(block->cls, block);
+    }
+}
+
+BufferPool::Stats BufferPool::stats() {
+    Stats s;
+    s.system_allocs = g_system_allocs.load(std::memory_order_relaxed);
+    s.system_frees  = g_system_frees.load(std::memory_order_relaxed);
+    return s;
+}
+
+void BufferPool::flush_thread_cache() {
+    if ( t_cache_state == CacheAlive ) t_cache.flush();
+}
+
+}} // end namespace mercury::nio
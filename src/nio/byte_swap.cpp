@@ -0,0 +1,153 @@
+#include "byte_swap.h"
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MERCURY_SWAP_SIMD 1
+#endif
+
+namespace mercury {
+namespace nio {
+
+typedef void (*SwapFunc)(char *dst, const char *src, size_t n);
+
+static void scalar_swap16(char *dst, const char *src, size_t n) {
+    for ( size_t i = 0; i < n; ++i ) {
+        uint16_t v;
+        memcpy(&v, src + i * 2, 2);
+        v = __builtin_bswap16(v);
+        memcpy(dst + i * 2, &v, 2);
+    }
+}
+
+static void scalar_swap32(char *dst, const char *src, size_t n) {
+    for ( size_t i = 0; i < n; ++i ) {
+        uint32_t v;
+        memcpy(&v, src + i * 4, 4);
+        v = __builtin_bswap32(v);
+        memcpy(dst + i * 4, &v, 4);
+    }
+}
+
+static void scalar_swap64(char *dst, const char *src, size_t n) {
+    for ( size_t i = 0; i < n; ++i ) {
+        uint64_t v;
+        memcpy(&v, src + i * 8, 8);
+        v = __builtin_bswap64(v);
+        memcpy(dst + i * 8, &v, 8);
+    }
+}
+
+#ifdef MERCURY_SWAP_SIMD
+
+// 每个元素内部字节逆序的pshufb掩码，16字节一组
+static const char g_mask16[16] = { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+static const char g_mask32[16] = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 };
+static const char g_mask64[16] = { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 };
+
+/// 以16字节为一组交换，返回已处理的字节数，不足一组的尾部留给标量实现。
+__attribute__((target("ssse3")))
+static size_t ssse3_shuffle(char *dst, const char *src, size_t bytes, const char *mask) {
+    const __m128i m = _mm_loadu_si128((const __m128i *)mask);
+    size_t i = 0;
+    for ( ; i + 16 <= bytes; i += 16 ) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, m));
+    }
+    return i;
+}
+
+/// 以64字节为一组交换，vpshufb在两个128位通道内分别使用同一掩码。
+__attribute__((target("avx2")))
+static size_t avx2_shuffle(char *dst, const char *src, size_t bytes, const char *mask) {
+    const __m256i m = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)mask));
+    size_t i = 0;
+    for ( ; i + 64 <= bytes; i += 64 ) {
+        __m256i v0 = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i *)(src + i + 32));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(v0, m));
+        _mm256_storeu_si256((__m256i *)(dst + i + 32), _mm256_shuffle_epi8(v1, m));
+    }
+    for ( ; i + 32 <= bytes; i += 32 ) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_shuffle_epi8(v, m));
+    }
+    return i;
+}
+
+static void ssse3_swap16(char *dst, const char *src, size_t n) {
+    size_t done = ssse3_shuffle(dst, src, n * 2, g_mask16);
+    scalar_swap16(dst + done, src + done, n - done / 2);
+}
+
+static void ssse3_swap32(char *dst, const char *src, size_t n) {
+    size_t done = ssse3_shuffle(dst, src, n * 4, g_mask32);
+    scalar_swap32(dst + done, src + done, n - done / 4);
+}
+
+static void ssse3_swap64(char *dst, const char *src, size_t n) {
+    size_t done = ssse3_shuffle(dst, src, n * 8, g_mask64);
+    scalar_swap64(dst + done, src + done, n - done / 8);
+}
+
+static void avx2_swap16(char *dst, const char *src, size_t n) {
+    size_t done = avx2_shuffle(dst, src, n * 2, g_mask16);
+    ssse3_swap16(dst + done, src + done, n - done / 2);
+}
+
+static void avx2_swap32(char *dst, const char *src, size_t n) {
+    size_t done = avx2_shuffle(dst, src, n * 4, g_mask32);
+    ssse3_swap32(dst + done, src + done, n - done / 4);
+}
+
+static void avx2_swap64(char *dst, const char *src, size_t n) {
+    size_t done = avx2_shuffle(dst, src, n * 8, g_mask64);
+    ssse3_swap64(dst + done, src + done, n - done / 8);
+}
+
+#endif // MERCURY_SWAP_SIMD
+
+struct SwapKernels {
+    SwapFunc     swap16;
+    SwapFunc     swap32;
+    SwapFunc     swap64;
+    const char * name;
+};
+
+static SwapKernels select_kernels() {
+#ifdef MERCURY_SWAP_SIMD
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx2") ) {
+        SwapKernels k = { avx2_swap16, avx2_swap32, avx2_swap64, "avx2" };
+        return k;
+    }
+    if ( __builtin_cpu_supports("ssse3") ) {
+        SwapKernels k = { ssse3_swap16, ssse3_swap32, ssse3_swap64, "ssse3" };
+        return k;
+    }
+#endif
+    SwapKernels k = { scalar_swap16, scalar_swap32, scalar_swap64, "scalar" };
+    return k;
+}
+
+static const SwapKernels & kernels() {
+    static const SwapKernels k = select_kernels();
+    return k;
+}
+
+void swap_copy(void *dst, const void *src, size_t n, size_t width) {
+    const SwapKernels &k = kernels();
+    switch ( width ) {
+        case 2: k.swap16((char *)dst, (const char *)src, n); break;
+        case 4: k.swap32((char *)dst, (const char *)src, n); break;
+        case 8: k.swap64((char *)dst, (const char *)src, n); break;
+        default: break;
+    }
+}
+
+const char * swap_kernel() {
+    return kernels().name;
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,17 @@
+#pragma once
+#include <stddef.h>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 批量交换字节序的内核，把src的n个width字节元素逐个交换字节序后写入dst。
+ * width为2、4或8。dst与src可以相同，但不能部分重叠。
+ * 首次调用时按CPU特性选择AVX2、SSSE3或标量实现。
+ */
+void         swap_copy(void *dst, const void *src, size_t n, size_t width);
+
+/// 当前使用的内核名称，"avx2"、"ssse3"或"scalar"。
+const char * swap_kernel();
+
+}} // end namespace mercury::nio
@@ -0,0 +1,244 @@
+#include <mercury/nio/composite_buffer.h>
+#include <string.h>
+
+namespace mercury {
+namespace nio {
+
+void CompositeByteBuffer::append(const ByteBuffer &seg) {
+    if ( seg.remaining() == 0 ) return;
+    Segment s = { seg.slice(), m_cap };
+    size_t len = s.buf.capacity();
+    m_segs.push_back(s);
+    m_cap += len;
+    m_lim += len;
+}
+
+void CompositeByteBuffer::prepend(const ByteBuffer &seg) {
+    if ( seg.remaining() == 0 ) return;
+    Segment s = { seg.slice(), 0 };
+    size_t len = s.buf.capacity();
+    for ( size_t i = 0; i < m_segs.size(); ++i ) m_segs[i].offset += len;
+    m_segs.insert(m_segs.begin(), s);
+    m_cap += len;
+    m_lim += len;
+    m_last = 0;
+}
+
+void CompositeByteBuffer::remove_all() {
+    m_segs.clear();
+    m_cap = m_pos = m_lim = m_mark = 0;
+    m_last = 0;
+}
+
+size_t CompositeByteBuffer::locate(size_t idx) const {
+    assert( idx < m_cap );
+    const Segment &last = m_segs[m_last];
+    if ( idx >= last.offset && idx - last.offset < last.buf.capacity() ) return m_last;
+
+    // 二分查找最后一个起始位置不大于idx的分段，分段都不为空
+    size_t lo = 0, hi = m_segs.size();
+    while ( hi - lo > 1 ) {
+        size_t mid = (lo + hi) / 2;
+        if ( m_segs[mid].offset <= idx ) lo = mid;
+        else hi = mid;
+    }
+    m_last = lo;
+    return lo;
+}
+
+void CompositeByteBuffer::read(size_t idx, void *dst, size_t len) const {
+    if ( len == 0 ) return;
+    char *out = (char *)dst;
+    size_t i = this->locate(idx);
+    while ( len > 0 ) {
+        const Segment &s = m_segs[i];
+        size_t off = idx - s.offset;
+        size_t n = s.buf.capacity() - off;
+        if ( n > len ) n = len;
+        s.buf.get(off, out, n);
+        out += n;
+        idx += n;
+        len -= n;
+        ++i;
+    }
+    m_last = i - 1;
+}
+
+void CompositeByteBuffer::write(size_t idx, const void *src, size_t len) {
+    if ( len == 0 ) return;
+    const char *in = (const char *)src;
+    size_t i = this->locate(idx);
+    while ( len > 0 ) {
+        Segment &s = m_segs[i];
+        size_t off = idx - s.offset;
+        size_t n = s.buf.capacity() - off;
+        if ( n > len ) n = len;
+        s.buf.put(off, in, n);
+        in += n;
+        idx += n;
+        len -= n;
+        ++i;
+    }
+    m_last = i - 1;
+}
+
+template<class T>
+T CompositeByteBuffer::read_value(size_t idx) const {
+    assert( m_lim - idx >= sizeof(T) );
+    T value;
+    this->read(idx, &value, sizeof(T));
+    return m_ord(value);
+}
+
+template<class T>
+void CompositeByteBuffer::write_value(size_t idx, T value) {
+    assert( m_lim - idx >= sizeof(T) );
+    value = m_ord(value);
+    this->write(idx, &value, sizeof(T));
+}
+
+size_t CompositeByteBuffer::iovecs(struct iovec *iov, size_t n) const {
+    if ( m_pos >= m_lim ) return 0;
+    size_t cnt = 0;
+    for ( size_t i = this->locate(m_pos); i < m_segs.size() && cnt < n; ++i ) {
+        const Segment &s = m_segs[i];
+        if ( s.offset >= m_lim ) break;
+        size_t begin = m_pos > s.offset ? m_pos - s.offset : 0;
+        size_t end = s.buf.capacity();
+        if ( s.offset + end > m_lim ) end = m_lim - s.offset;
+        if ( end <= begin ) continue;
+        iov[cnt].iov_base = const_cast<char *>(s.buf.ptr(begin));
+        iov[cnt].iov_len  = end - begin;
+        ++cnt;
+    }
+    return cnt;
+}
+
+char CompositeByteBuffer::get() {
+    assert( Buffer::remaining() >= sizeof(char) );
+    char ch;
+    this->read(m_pos, &ch, 1);
+    ++m_pos;
+    return ch;
+}
+
+char CompositeByteBuffer::get(size_t idx) const {
+    assert( idx < m_lim );
+    char ch;
+    this->read(idx, &ch, 1);
+    return ch;
+}
+
+size_t CompositeByteBuffer::get(char *array, size_t len) {
+    size_t remain = Buffer::remaining();
+    if ( len > remain ) len = remain;
+    this->read(m_pos, array, len);
+    m_pos += len;
+    return len;
+}
+
+size_t CompositeByteBuffer::get(size_t idx, char *array, size_t len) const {
+    size_t remain = Buffer::limit() - idx;
+    if ( len > remain ) len = remain;
+    this->read(idx, array, len);
+    return len;
+}
+
+int16_t CompositeByteBuffer::get_int16() {
+    int16_t value = this->read_value<int16_t>(m_pos);
+    m_pos += sizeof(int16_t);
+    return value;
+}
+
+int16_t CompositeByteBuffer::get_int16(size_t idx) const { return this->read_value<int16_t>(idx); }
+
+int32_t CompositeByteBuffer::get_int32() {
+    int32_t value = this->read_value<int32_t>(m_pos);
+    m_pos += sizeof(int32_t);
+    return value;
+}
+
+int32_t CompositeByteBuffer::get_int32(size_t idx) const { return this->read_value<int32_t>(idx); }
+
+int64_t CompositeByteBuffer::get_int64() {
+    int64_t value = this->read_value<int64_t>(m_pos);
+    m_pos += sizeof(int64_t);
+    return value;
+}
+
+int64_t CompositeByteBuffer::get_int64(size_t idx) const { return this->read_value<int64_t>(idx); }
+
+float CompositeByteBuffer::get_float() {
+    float value = this->read_value<float>(m_pos);
+    m_pos += sizeof(float);
+    return value;
+}
+
+float CompositeByteBuffer::get_float(size_t idx) const { return this->read_value<float>(idx); }
+
+double CompositeByteBuffer::get_double() {
+    double value = this->read_value<double>(m_pos);
+    m_pos += sizeof(double);
+    return value;
+}
+
+double CompositeByteBuffer::get_double(size_t idx) const { return this->read_value<double>(idx); }
+
+void CompositeByteBuffer::put(char ch) {
+    assert( Buffer::remaining() >= sizeof(char) );
+    this->write(m_pos, &ch, 1);
+    ++m_pos;
+}
+
+void CompositeByteBuffer::put(size_t idx, char ch) {
+    assert( idx < m_lim );
+    this->write(idx, &ch, 1);
+}
+
+void CompositeByteBuffer::put(const char *array, size_t len) {
+    assert( Buffer::remaining() >= len );
+    this->write(m_pos, array, len);
+    m_pos += len;
+}
+
+void CompositeByteBuffer::put(size_t idx, const char *array, size_t len) {
+    assert( Buffer::limit() - idx >= len );
+    this->write(idx, array, len);
+}
+
+void CompositeByteBuffer::put_int16(int16_t value) {
+    this->write_value<int16_t>(m_pos, value);
+    m_pos += sizeof(int16_t);
+}
+
+void CompositeByteBuffer::put_int16(size_t idx, int16_t value) { this->write_value<int16_t>(idx, value); }
+
+void CompositeByteBuffer::put_int32(int32_t value) {
+    this->write_value<int32_t>(m_pos, value);
+    m_pos += sizeof(int32_t);
+}
+
+void CompositeByteBuffer::put_int32(size_t idx, int32_t value) { this->write_value<int32_t>(idx, value); }
+
+void CompositeByteBuffer::put_int64(int64_t value) {
+    this->write_value<int64_t>(m_pos, value);
+    m_pos += sizeof(int64_t);
+}
+
+void CompositeByteBuffer::put_int64(size_t idx, int64_t value) { this->write_value<int64_t>(idx, value); }
+
+void CompositeByteBuffer::put_float(float value) {
+    this->write_value<float>(m_pos, value);
+    m_pos += sizeof(float);
+}
+
+void CompositeByteBuffer::put_float(size_t idx, float value) { this->write_value<float>(idx, value); }
+
+void CompositeByteBuffer::put_double(double value) {
+    this->write_value<double>(m_pos, value);
+    m_pos += sizeof(double);
+}
+
+void CompositeByteBuffer::put_double(size_t idx, double value) { this->write_value<double>(idx, value); }
+
+}} // end namespace mercury::nio
@@ -0,0 +1,98 @@
+#include <mercury/nio/channel.h>
+#include <cassert>
+#include <string.h>
+
+namespace mercury {
+namespace nio {
+
+class DatagramSocketChannel::DatagramSocketChannelImpl {
+public:
+    mercury::net::DatagramSocket m_socket;
+}; // end class DatagramSocketChannel::DatagramSocketChannelImpl
+
+DatagramSocketChannel::DatagramSocketChannel() : m_pSockImpl(new DatagramSocketChannelImpl()) {}
+
+DatagramSocketChannel::~DatagramSocketChannel() {
+    this->cancel_keys();
+    delete m_pSockImpl;
+    m_pSockImpl = nullptr;
+}
+
+bool DatagramSocketChannel::create(int domain, RuntimeError &e) {
+    assert( m_pSockImpl->m_socket.is_closed() );
+    if ( !m_pSockImpl->m_socket.create(domain, e) ) return false;
+    return m_pSockImpl->m_socket.set_block_mode(false, e);
+}
+
+bool DatagramSocketChannel::close(RuntimeError &e) {
+    if ( m_pSockImpl->m_socket.is_closed() ) return true;
+    this->cancel_keys();
+    return m_pSockImpl->m_socket.close(e);
+}
+
+bool DatagramSocketChannel::is_closed() const {
+    return m_pSockImpl->m_socket.is_closed();
+}
+
+bool DatagramSocketChannel::bind(const char *addr, int port, RuntimeError &e) {
+    return m_pSockImpl->m_socket.bind(addr, port, e);
+}
+
+bool DatagramSocketChannel::connect(const char *host, int port, RuntimeError &e) {
+    if ( m_pSockImpl->m_socket.is_closed() ) {
+        int domain = strchr(host, ':') ? AF_INET6 : AF_INET;
+        if ( !this->create(domain, e) ) return false;
+    }
+    return m_pSockImpl->m_socket.connect(host, port, e);
+}
+
+bool DatagramSocketChannel::is_connected() const {
+    return m_pSockImpl->m_socket.is_connected();
+}
+
+/// buf剩余区间的起始地址，没有剩余空间时position可能已在容量末尾，不能取址。
+static char * space(ByteBuffer &buf) {
+    return buf.remaining() > 0 ? buf.ptr() : nullptr;
+}
+
+ssize_t DatagramSocketChannel::receive(ByteBuffer &buf, net::InetSocketAddress *from, RuntimeError &e) {
+    net::DatagramPacket packet(space(buf), 0, buf.remaining(), from);
+    ssize_t r = m_pSockImpl->m_socket.receive(&packet, e);
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+ssize_t DatagramSocketChannel::send(ByteBuffer &buf, const net::InetSocketAddress &to, RuntimeError &e) {
+    net::DatagramPacket packet(space(buf), buf.remaining(), const_cast<net::InetSocketAddress*>(&to));
+    ssize_t r = m_pSockImpl->m_socket.send(packet, e);
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+ssize_t DatagramSocketChannel::read(ByteBuffer &buf, RuntimeError &e) {
+    net::DatagramPacket packet(space(buf), 0, buf.remaining());
+    ssize_t r = m_pSockImpl->m_socket.receive(&packet, e);
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+ssize_t DatagramSocketChannel::write(ByteBuffer &buf, RuntimeError &e) {
+    net::DatagramPacket packet(space(buf), buf.remaining());
+    ssize_t r = m_pSockImpl->m_socket.send(packet, e);
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+net::DatagramSocket * DatagramSocketChannel::socket() {
+    return &m_pSockImpl->m_socket;
+}
+
+int DatagramSocketChannel::fd() const {
+    return m_pSockImpl->m_socket.fd();
+}
+
+int DatagramSocketChannel::valid_ops() const {
+    return SelectionKey::OpRead | SelectionKey::OpWrite | SelectionKey::OpError;
+}
+
+}} // end namespace mercury::nio
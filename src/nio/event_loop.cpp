@@ -0,0 +1,220 @@
+#include <mercury/nio/event_loop.h>
+
+#include <pthread.h>
+#include <sched.h>
+#include <cassert>
+#include <errno.h>
+#include <string.h>
+#include <sstream>
+#include <system_error>
+
+namespace mercury {
+namespace nio {
+
+EventLoop::EventLoop(size_t index, EventHandler *handler)
+    : m_index(index), m_handler(handler), m_acceptKey(nullptr), m_running(false)
+{
+    for ( size_t i = 0; i < AcceptBatch; ++i ) m_accepted[i] = nullptr;
+    m_acceptResume.m_loop = this;
+}
+
+EventLoop::~EventLoop() {
+    this->stop();
+    this->join();
+    RuntimeError e;
+    this->close(e);
+    for ( size_t i = 0; i < AcceptBatch; ++i ) delete m_accepted[i];
+}
+
+bool EventLoop::open(int engine, int domain, const char *addr, int port, int backlog, RuntimeError &e) {
+    if ( !m_selector.open(engine, e) ) return false;
+    if ( !m_server.create(domain, e) ) return false;
+
+    net::ServerSocket * sock = m_server.socket();
+    if ( !sock->set_reuse_addr(1, e) || !sock->set_reuse_port(1, e) ) return false;
+    if ( !m_server.bind(addr, port, e) || !m_server.listen(backlog, e) ) return false;
+
+    m_acceptKey = m_server.reg(&m_selector, SelectionKey::OpAccept, e);
+    return m_acceptKey != nullptr;
+}
+
+bool EventLoop::close(RuntimeError &e) {
+    assert( !m_running );
+    m_acceptResume.cancel();
+    m_acceptKey = nullptr;
+    bool isok = m_server.close(e);
+    return m_selector.close(e) && isok;
+}
+
+bool EventLoop::start(RuntimeError &e) {
+    if ( m_running.exchange(true) ) return true;
+
+    // 绑定CPU，同一端口的连接由内核按监听socket分发，线程固定在核上可保持缓存局部性。
+    // 在进程允许的CPU中按序号轮流选取，容器或taskset限制的CPU集合不一定从0开始连续。
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if ( ::sched_getaffinity(0, sizeof(allowed), &allowed) == -1 ) {
+        m_running = false;
+        std::ostringstream oss;
+        oss<<"sched_getaffinity() error, index: "<<m_index<<", errno: "<<errno<<", errmsg: "<<strerror(errno);
+        e.set(-1, oss.str().c_str(), "EventLoop::start");
+        return false;
+    }
+    size_t nth = m_index % (size_t)CPU_COUNT(&allowed);
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    for ( int cpu = 0; cpu < CPU_SETSIZE; ++cpu ) {
+        if ( CPU_ISSET(cpu, &allowed) && nth-- == 0 ) {
+            CPU_SET(cpu, &cpuset);
+            break;
+        }
+    }
+
+    try {
+        m_thread = std::thread(&EventLoop::run, this);
+    } catch ( std::system_error &ex ) {
+        m_running = false;
+        std::ostringstream oss;
+        oss<<"start event loop thread error, index: "<<m_index<<", "<<ex.what();
+        e.set(-1, oss.str().c_str(), "EventLoop::start");
+        return false;
+    }
+
+    int err = ::pthread_setaffinity_np(m_thread.native_handle(), sizeof(cpuset), &cpuset);
+    if ( err != 0 ) {
+        this->stop();
+        this->join();
+        std::ostringstream oss;
+        oss<<"pthread_setaffinity_np() error, index: "<<m_index<<", errno: "<<err<<", errmsg: "<<strerror(err);
+        e.set(-1, oss.str().c_str(), "EventLoop::start");
+        return false;
+    }
+    return true;
+}
+
+int EventLoop::listen_port() {
+    RuntimeError e;
+    return m_server.socket()->local_port(e);
+}
+
+void EventLoop::stop() {
+    if ( m_running.exchange(false) ) m_selector.wakeup();
+}
+
+void EventLoop::join() {
+    if ( m_thread.joinable() ) m_thread.join();
+}
+
+void EventLoop::run() {
+    while ( m_running.load(std::memory_order_acquire) ) {
+        int n = m_selector.select(m_error);
+        if ( n < 0 ) {
+            m_error.push("EventLoop::run() exit. ");
+            m_running = false;
+            break;
+        }
+
+        m_selector.selected_keys(m_selected);
+        for ( size_t i = 0; i < m_selected.size(); ++i ) {
+            SelectionKey *key = m_selected[i];
+            if ( !key->is_valid() ) continue;   // 本轮中已被注销
+            if ( key == m_acceptKey ) this->accept_all();
+            else m_handler->on_select(*this, key);
+        }
+    }
+}
+
+void EventLoop::accept_all() {
+    // 一次就绪事件中接受全部等待的连接，直到队列为空(EAGAIN)或出错。
+    // 交给处理者的通道在下一批之前补齐，未用到的通道留待下次就绪时复用。
+    for ( ;; ) {
+        for ( size_t i = 0; i < AcceptBatch; ++i ) {
+            if ( m_accepted[i] == nullptr ) m_accepted[i] = new StreamSocketChannel();
+        }
+
+        RuntimeError e;
+        ssize_t n = m_server.accept_batch(m_accepted, AcceptBatch, e);
+        for ( ssize_t i = 0; i < n; ++i ) {
+            StreamSocketChannel * ch = m_accepted[i];
+            m_accepted[i] = nullptr;
+            m_handler->on_accept(*this, ch);
+        }
+        if ( n < 0 ) {
+            this->accept_backoff(e);
+            break;
+        }
+        if ( n < (ssize_t)AcceptBatch ) break;
+    }
+}
+
+void EventLoop::accept_backoff(const RuntimeError &e) {
+    // 监听通道是水平触发的，未能接受的连接仍在队列中，继续关注OpAccept会立即再次就绪并
+    // 反复失败而占满CPU。暂停关注一段时间，等待连接关闭释放资源后再恢复。
+    m_handler->on_accept_error(*this, e);
+    RuntimeError e2;
+    if ( !m_selector.schedule(&m_acceptResume, AcceptBackoff, e2) ) {
+        m_handler->on_accept_error(*this, e2);
+        return;
+    }
+    m_acceptKey->interest_ops(0);
+}
+
+void EventLoop::AcceptResume::on_timeout() {
+    if ( m_loop->m_acceptKey ) m_loop->m_acceptKey->interest_ops(SelectionKey::OpAccept);
+}
+
+EventLoopGroup::EventLoopGroup() : m_engine(Selector::EngineEpoll) {}
+
+EventLoopGroup::~EventLoopGroup() {
+    this->stop();
+    this->join();
+    RuntimeError e;
+    this->close(e);
+}
+
+bool EventLoopGroup::open(size_t n, int domain, const char *addr, int port, EventHandler *handler, RuntimeError &e) {
+    assert( m_loops.empty() );
+    if ( n == 0 ) n = std::thread::hardware_concurrency();
+    if ( n == 0 ) n = 1;
+
+    for ( size_t i = 0; i < n; ++i ) {
+        EventLoop * loop = new EventLoop(i, handler);
+        m_loops.push_back(loop);
+        if ( !loop->open(m_engine, domain, addr, port, SOMAXCONN, e) ) {
+            std::ostringstream oss;
+            oss<<"EventLoopGroup::open() failed, loop index: "<<i<<". ";
+            e.push(oss.str().c_str());
+            return false;
+        }
+        // 端口为0时由第一个监听确定实际端口，其余按此端口绑定。
+        if ( port == 0 ) port = loop->listen_port();
+    }
+    return true;
+}
+
+bool EventLoopGroup::close(RuntimeError &e) {
+    bool isok = true;
+    for ( size_t i = 0; i < m_loops.size(); ++i ) {
+        if ( !m_loops[i]->close(e) ) isok = false;
+        delete m_loops[i];
+    }
+    m_loops.clear();
+    return isok;
+}
+
+bool EventLoopGroup::start(RuntimeError &e) {
+    for ( size_t i = 0; i < m_loops.size(); ++i ) {
+        if ( !m_loops[i]->start(e) ) return false;
+    }
+    return true;
+}
+
+void EventLoopGroup::stop() {
+    for ( size_t i = 0; i < m_loops.size(); ++i ) m_loops[i]->stop();
+}
+
+void EventLoopGroup::join() {
+    for ( size_t i = 0; i < m_loops.size(); ++i ) m_loops[i]->join();
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,164 @@
+#include <mercury/nio/frame_codec.h>
+#include <string.h>
+
+namespace mercury {
+namespace nio {
+
+/// 读取idx处宽width字节的长度字段，字节序为buf的字节序。
+static uint64_t read_length(const ByteBuffer &buf, size_t idx, size_t width) {
+    switch ( width ) {
+        case 1: return (uint8_t)*buf.ptr(idx);
+        case 2: return (uint16_t)buf.get_int16(idx);
+        case 4: return (uint32_t)buf.get_int32(idx);
+        default: return (uint64_t)buf.get_int64(idx);
+    }
+}
+
+/// 向上取整到缓存池的尺寸类，充分使用分配到的内存块。
+static size_t pool_size(size_t size) {
+    uint32_t cls = BufferPool::size_class(size);
+    return cls == BufferPool::LargeClass ? size : BufferPool::class_size(cls);
+}
+
+FrameDecoder::FrameDecoder(size_t width, const ByteOrder &order, size_t max_frame, size_t bufsize)
+    : m_width(width), m_ord(order), m_max(max_frame), m_bufsize(bufsize), m_read(0)
+{
+    assert( width == 1 || width == 2 || width == 4 || width == 8 );
+}
+
+size_t FrameDecoder::frame_need() const {
+    size_t avail = this->buffered();
+    if ( avail < m_width ) return m_width - avail;
+    uint64_t len = read_length(m_buf, m_read, m_width);
+    if ( len > m_max ) return 0;   // 由next报告错误
+    size_t total = m_width + (size_t)len;
+    return total > avail ? total - avail : 0;
+}
+
+void FrameDecoder::reserve(size_t n) {
+    size_t pos = m_buf.position();
+    if ( m_buf.capacity() - pos >= n ) return;
+    size_t unread = pos - m_read;
+
+    // 没有帧引用当前缓存时原地移动未解析的数据
+    if ( m_buf.is_pooled() && !m_buf.is_shared() && unread + n <= m_buf.capacity() ) {
+        m_buf.limit(pos);
+        m_buf.position(m_read);
+        m_buf.compact();
+        m_read = 0;
+        return;
+    }
+    size_t cap = unread + n > m_bufsize ? unread + n : m_bufsize;
+    ByteBuffer buf = ByteBuffer::allocate(pool_size(cap));
+    buf.order(m_ord);
+    if ( unread > 0 ) buf.put(m_buf.ptr(m_read), unread);
+    m_buf = std::move(buf);
+    m_read = 0;
+}
+
+ssize_t FrameDecoder::read(StreamSocketChannel &ch, RuntimeError &e) {
+    // 至少为当前帧的剩余部分预留空间，使负载在缓存中连续
+    size_t want = this->frame_need();
+    if ( want < m_bufsize / 4 ) want = m_bufsize / 4;
+    if ( want == 0 ) want = 1;
+    this->reserve(want);
+    return ch.read(m_buf, e);
+}
+
+void FrameDecoder::append(const char *data, size_t len) {
+    if ( len == 0 ) return;
+    this->reserve(len);
+    m_buf.put(data, len);
+}
+
+bool FrameDecoder::next(ByteBuffer &frame, RuntimeError &e) {
+    size_t avail = this->buffered();
+    if ( avail < m_width ) return false;
+    uint64_t len = read_length(m_buf, m_read, m_width);
+    if ( len > m_max ) {
+        std::ostringstream oss;
+        oss<<"frame too long, length: "<<len<<", max: "<<m_max;
+        e.set(-1, oss.str().c_str(), "FrameDecoder::next");
+        return false;
+    }
+    if ( avail - m_width < len ) return false;
+    frame = m_buf.slice(m_read + m_width, (size_t)len).as_read_only();
+    m_read += m_width + (size_t)len;
+    return true;
+}
+
+size_t FrameDecoder::next_all(std::vector<ByteBuffer> &frames, RuntimeError &e) {
+    size_t n = 0;
+    ByteBuffer frame;
+    while ( this->next(frame, e) ) {
+        frames.push_back(std::move(frame));
+        ++n;
+    }
+    return n;
+}
+
+FrameEncoder::FrameEncoder(size_t width, const ByteOrder &order)
+    : m_width(width), m_ord(order), m_sealed(0)
+{
+    assert( width == 1 || width == 2 || width == 4 || width == 8 );
+}
+
+void FrameEncoder::seal() {
+    size_t pos = m_stage.position();
+    if ( pos > m_sealed ) m_out.append(m_stage.slice(m_sealed, pos - m_sealed));
+    m_sealed = pos;
+}
+
+bool FrameEncoder::encode(const ByteBuffer &payload, RuntimeError &e) {
+    size_t len = payload.remaining();
+    if ( m_width < 8 && (uint64_t)len >> (8 * m_width) != 0 ) {
+        std::ostringstream oss;
+        oss<<"payload too long for "<<m_width<<" byte length field, length: "<<len;
+        e.set(-1, oss.str().c_str(), "FrameEncoder::encode");
+        return false;
+    }
+
+    bool copy = len <= CopyThreshold;
+    size_t need = m_width + (copy ? len : 0);
+    if ( !m_stage.is_pooled() || m_stage.remaining() < need ) {
+        this->seal();
+        m_stage = ByteBuffer::allocate(StageBlockSize);
+        m_stage.order(m_ord);
+        m_sealed = 0;
+    }
+    switch ( m_width ) {
+        case 1: m_stage.put((char)len); break;
+        case 2: m_stage.put_int16((int16_t)len); break;
+        case 4: m_stage.put_int32((int32_t)len); break;
+        default: m_stage.put_int64((int64_t)len); break;
+    }
+    if ( copy ) {
+        if ( len > 0 ) m_stage.put(payload.ptr(), len);
+    } else {
+        this->seal();
+        m_out.append(payload);
+    }
+    return true;
+}
+
+ssize_t FrameEncoder::flush(StreamSocketChannel &ch, RuntimeError &e) {
+    this->seal();
+    ssize_t total = 0;
+    while ( m_out.remaining() > 0 ) {
+        ssize_t r = ch.write(m_out, e);
+        if ( r < 0 ) return -1;
+        if ( r == 0 ) break;   // 发送缓冲已满
+        total += r;
+    }
+    if ( m_out.remaining() == 0 ) {
+        m_out.remove_all();
+        // 暂存区不再被引用时从头复用
+        if ( !m_stage.is_shared() ) {
+            m_stage.clear();
+            m_sealed = 0;
+        }
+    }
+    return total;
+}
+
+}} // end namespace mercury::nio
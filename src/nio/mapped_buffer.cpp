@@ -0,0 +1,178 @@
+#include <mercury/nio/mapped_buffer.h>
+#include "../net/socket_utils.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace mercury {
+namespace nio {
+
+MappedByteBuffer::MappedByteBuffer()
+    : m_fd(-1), m_mode(ReadOnly), m_advice(AccessNormal), m_flags(0)
+    , m_file_size(0), m_offset(0), m_window(0), m_map(nullptr), m_map_len(0)
+{}
+
+MappedByteBuffer::~MappedByteBuffer() {
+    RuntimeError e;
+    this->close(e);
+}
+
+bool MappedByteBuffer::open(const char *path, int mode, RuntimeError &e) {
+    assert( m_fd < 0 );
+    int fd = ::open(path, (mode == ReadWrite ? O_RDWR : O_RDONLY) | O_CLOEXEC);
+    if ( fd < 0 ) {
+        std::ostringstream oss;
+        oss<<"open() file error, "<<net::syserr<<"path: "<<path;
+        e.set(-1, oss.str().c_str(), "MappedByteBuffer::open");
+        return false;
+    }
+    struct stat st;
+    if ( fstat(fd, &st) != 0 ) {
+        std::ostringstream oss;
+        oss<<"fstat() file error, "<<net::syserr<<"path: "<<path;
+        e.set(-1, oss.str().c_str(), "MappedByteBuffer::open");
+        ::close(fd);
+        return false;
+    }
+    m_fd = fd;
+    m_mode = mode;
+    m_file_size = (size_t)st.st_size;
+    m_readonly = mode != ReadWrite;
+    return true;
+}
+
+bool MappedByteBuffer::close(RuntimeError &e) {
+    if ( m_fd < 0 ) return true;
+    bool isok = this->unmap(e);
+    if ( ::close(m_fd) != 0 && isok ) {
+        std::ostringstream oss;
+        oss<<"close() file error, "<<net::syserr<<"fd: "<<m_fd;
+        e.set(-1, oss.str().c_str(), "MappedByteBuffer::close");
+        isok = false;
+    }
+    m_fd = -1;
+    m_file_size = 0;
+    m_offset = m_window = 0;
+    return isok;
+}
+
+bool MappedByteBuffer::unmap(RuntimeError &e) {
+    bool isok = true;
+    if ( m_map && munmap(m_map, m_map_len) != 0 ) {
+        std::ostringstream oss;
+        oss<<"munmap() error, "<<net::syserr<<"fd: "<<m_fd;
+        e.set(-1, oss.str().c_str(), "MappedByteBuffer::unmap");
+        isok = false;
+    }
+    m_map = nullptr;
+    m_map_len = 0;
+    m_buf = nullptr;
+    m_cap = m_pos = m_lim = m_mark = 0;
+    return isok;
+}
+
+bool MappedByteBuffer::map(size_t offset, size_t length, int flags, RuntimeError &e) {
+    assert( m_fd >= 0 );
+    if ( !this->unmap(e) ) return false;
+    m_flags = flags;
+    m_window = length;
+    m_offset = offset < m_file_size ? offset : m_file_size;
+    if ( length == 0 || length > m_file_size - m_offset ) length = m_file_size - m_offset;
+    if ( length == 0 ) return true;   // 空文件或窗口位于文件末尾
+
+    // mmap的文件偏移必须按页对齐，窗口起始位置之前的部分不属于缓存
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t head = m_offset % page;
+    int prot = m_mode == ReadWrite ? PROT_READ | PROT_WRITE : PROT_READ;
+    int mflags = MAP_SHARED;
+    if ( flags & MapPopulate ) mflags |= MAP_POPULATE;
+    void *p = ( flags & MapHugePages ) ? this->map_aligned(head + length, m_offset - head, prot, mflags)
+                                       : mmap(nullptr, head + length, prot, mflags, m_fd, (off_t)(m_offset - head));
+    if ( p == MAP_FAILED ) {
+        std::ostringstream oss;
+        oss<<"mmap() file error, "<<net::syserr<<"fd: "<<m_fd<<", offset: "<<m_offset<<", length: "<<length;
+        e.set(-1, oss.str().c_str(), "MappedByteBuffer::map");
+        return false;
+    }
+    m_map = (char *)p;
+    m_map_len = head + length;
+    m_buf = m_map + head;
+    m_cap = m_lim = length;
+    m_pos = m_mark = 0;
+
+#ifdef MADV_HUGEPAGE
+    // 文件映射的大页依赖内核配置，不支持时madvise返回EINVAL，只是提示所以忽略
+    if ( flags & MapHugePages ) madvise(m_map, m_map_len, MADV_HUGEPAGE);
+#endif
+    if ( m_advice != AccessNormal && m_advice != AccessWillNeed ) return this->apply_advice(m_advice, e);
+    return true;
+}
+
+void * MappedByteBuffer::map_aligned(size_t len, size_t file_off, int prot, int mflags) {
+    // 先预留多出一个大页的地址区间，在其中选取与文件偏移模HugePageSize同余的起点，
+    // 使文件中按大页对齐的部分在地址上同样对齐，内核才能以整个大页映射。预留失败时不对齐。
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t resv_len = len + HugePageSize;
+    void *r = mmap(nullptr, resv_len, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if ( r == MAP_FAILED ) return mmap(nullptr, len, prot, mflags, m_fd, (off_t)file_off);
+
+    char *base = (char *)r;
+    size_t skew = (file_off - (uintptr_t)base) & (HugePageSize - 1);
+    char *addr = base + skew;
+    void *p = mmap(addr, len, prot, mflags | MAP_FIXED, m_fd, (off_t)file_off);
+    if ( p == MAP_FAILED ) {
+        int err = errno;
+        munmap(base, resv_len);
+        errno = err;
+        return MAP_FAILED;
+    }
+    // 释放预留区间中映射之外的部分
+    char *tail = addr + (len + page - 1) / page * page;
+    char *end  = base + (resv_len + page - 1) / page * page;
+    if ( skew > 0 ) munmap(base, skew);
+    if ( end > tail ) munmap(tail, end - tail);
+    return p;
+}
+
+bool MappedByteBuffer::slide(RuntimeError &e) {
+    return this->map(m_offset + m_pos, m_window, m_flags, e);
+}
+
+bool MappedByteBuffer::advise(int advice, RuntimeError &e) {
+    if ( advice != AccessWillNeed ) m_advice = advice;
+    if ( m_map == nullptr ) return true;
+    return this->apply_advice(advice, e);
+}
+
+bool MappedByteBuffer::apply_advice(int advice, RuntimeError &e) {
+    int adv = MADV_NORMAL;
+    switch ( advice ) {
+        case AccessSequential: adv = MADV_SEQUENTIAL; break;
+        case AccessRandom:     adv = MADV_RANDOM; break;
+        case AccessWillNeed:   adv = MADV_WILLNEED; break;
+        default: break;
+    }
+    if ( madvise(m_map, m_map_len, adv) != 0 ) {
+        std::ostringstream oss;
+        oss<<"madvise() error, "<<net::syserr<<"advice: "<<advice;
+        e.set(-1, oss.str().c_str(), "MappedByteBuffer::advise");
+        return false;
+    }
+    return true;
+}
+
+bool MappedByteBuffer::sync(RuntimeError &e) {
+    if ( m_map == nullptr || m_mode != ReadWrite ) return true;
+    if ( msync(m_map, m_map_len, MS_SYNC) != 0 ) {
+        std::ostringstream oss;
+        oss<<"msync() error, "<<net::syserr<<"fd: "<<m_fd;
+        e.set(-1, oss.str().c_str(), "MappedByteBuffer::sync");
+        return false;
+    }
+    return true;
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,157 @@
+#pragma once
+#include <mercury/error.h>
+#include <mercury/nio/completion.h>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <stdint.h>
+
+#include "../net/socket_utils.h"
+
+namespace mercury {
+namespace nio {
+
+/// 就绪事件，事件位使用EPOLL*定义，data.ptr为注册时传入的指针。
+typedef struct epoll_event PollEvent;
+
+/**
+ * @brief Selector使用的内核事件接口，每个fd只能注册一次。
+ * events使用EPOLLIN/EPOLLOUT等位，包含EPOLLET时表示边沿触发。
+ */
+class Poller {
+protected:
+    uint64_t m_syscalls;   // 发起的系统调用次数
+
+public:
+    Poller() : m_syscalls(0) {}
+    virtual ~Poller() {}
+
+    virtual bool open(RuntimeError &e) = 0;
+    virtual bool close(RuntimeError &e) = 0;
+
+    virtual bool add(int fd, uint32_t events, void *ptr, RuntimeError &e) = 0;
+    virtual bool modify(int fd, uint32_t events, void *ptr, RuntimeError &e) = 0;
+    virtual bool remove(int fd, RuntimeError &e) = 0;
+
+    /**
+     * @brief 等待事件。
+     * @param timeout 超时毫秒数，<0表示一直等待。
+     * @return 写入events的事件数，-1表示失败。
+     */
+    virtual int  wait(PollEvent *events, int n, long timeout, RuntimeError &e) = 0;
+
+    /**
+     * @brief 完成模式的异步操作，见Completion，只有io_uring支持，默认返回失败。
+     * fd须已经add，remove时取消其全部未结束的请求。结果在wait中收取，由complete回调。
+     */
+    virtual bool accept_async(int, Completion *, RuntimeError &e) { return unsupported(e, "Poller::accept_async"); }
+    virtual bool recv_async(int, Completion *, RuntimeError &e) { return unsupported(e, "Poller::recv_async"); }
+    virtual bool send_async(int, const char *, size_t, Completion *, RuntimeError &e) {
+        return unsupported(e, "Poller::send_async");
+    }
+    /// 设置recv_async使用的接收缓存环，见Selector::recv_buffers。
+    virtual bool recv_buffers(unsigned, unsigned, RuntimeError &e) { return unsupported(e, "Poller::recv_buffers"); }
+    /// 回调最近一次wait收取的完成事件，返回回调次数。
+    virtual size_t complete() { return 0; }
+
+    uint64_t syscalls() const { return m_syscalls; }
+
+protected:
+    static bool unsupported(RuntimeError &e, const char *where) {
+        e.set(-1, "completion mode requires Selector::EngineUring", where);
+        return false;
+    }
+}; // end class Poller
+
+/**
+ * @brief 基于epoll的Poller。
+ */
+class EpollPoller : public Poller {
+private:
+    int m_epfd;
+
+public:
+    EpollPoller() : m_epfd(-1) {}
+    virtual ~EpollPoller() { RuntimeError e; this->close(e); }
+
+    virtual bool open(RuntimeError &e);
+    virtual bool close(RuntimeError &e);
+    virtual bool add(int fd, uint32_t events, void *ptr, RuntimeError &e);
+    virtual bool modify(int fd, uint32_t events, void *ptr, RuntimeError &e);
+    virtual bool remove(int fd, RuntimeError &e);
+    virtual int  wait(PollEvent *events, int n, long timeout, RuntimeError &e);
+
+private:
+    bool control(int op, int fd, uint32_t events, void *ptr, RuntimeError &e);
+}; // end class EpollPoller
+
+inline bool EpollPoller::open(RuntimeError &e) {
+    int fd = ::epoll_create1(EPOLL_CLOEXEC);
+    if ( fd < 0 ) {
+        std::ostringstream oss;
+        oss<<"epoll_create1() error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "EpollPoller::open");
+        return false;
+    }
+    m_epfd = fd;
+    return true;
+}
+
+inline bool EpollPoller::close(RuntimeError &e) {
+    if ( m_epfd < 0 ) return true;
+    int r = ::close(m_epfd);
+    m_epfd = -1;
+    if ( r == -1 ) {
+        std::ostringstream oss;
+        oss<<"close() epoll fd error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "EpollPoller::close");
+        return false;
+    }
+    return true;
+}
+
+inline bool EpollPoller::control(int op, int fd, uint32_t events, void *ptr, RuntimeError &e) {
+    struct epoll_event ev;
+    ev.events = events;
+    ev.data.ptr = ptr;
+    int r = ::epoll_ctl(m_epfd, op, fd, &ev);
+    ++m_syscalls;
+    if ( r == -1 ) {
+        // fd已关闭时内核已自动移除，注销时忽略EBADF和ENOENT。
+        if ( op == EPOLL_CTL_DEL && (errno == EBADF || errno == ENOENT) ) return true;
+        std::ostringstream oss;
+        oss<<"epoll_ctl() error, "<<net::syserr<<" op: "<<op<<", fd: "<<fd<<", events: "<<events;
+        e.set(-1, oss.str().c_str(), "EpollPoller::control");
+        return false;
+    }
+    return true;
+}
+
+inline bool EpollPoller::add(int fd, uint32_t events, void *ptr, RuntimeError &e) {
+    return this->control(EPOLL_CTL_ADD, fd, events, ptr, e);
+}
+
+inline bool EpollPoller::modify(int fd, uint32_t events, void *ptr, RuntimeError &e) {
+    return this->control(EPOLL_CTL_MOD, fd, events, ptr, e);
+}
+
+inline bool EpollPoller::remove(int fd, RuntimeError &e) {
+    return this->control(EPOLL_CTL_DEL, fd, 0, nullptr, e);
+}
+
+inline int EpollPoller::wait(PollEvent *events, int n, long timeout, RuntimeError &e) {
+    int ms = timeout < 0 ? -1 : (int)timeout;
+    int r = ::epoll_wait(m_epfd, events, n, ms);
+    ++m_syscalls;
+    if ( r < 0 ) {
+        if ( errno == EINTR ) return 0;
+        std::ostringstream oss;
+        oss<<"epoll_wait() error, "<<net::syserr<<" epfd: "<<m_epfd;
+        e.set(-1, oss.str().c_str(), "EpollPoller::wait");
+        return -1;
+    }
+    return r;
+}
+
+}} // end namespace mercury::nio
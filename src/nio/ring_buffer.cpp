@@ -0,0 +1,87 @@
+#include <mercury/nio/ring_buffer.h>
+#include "../net/socket_utils.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace mercury {
+namespace nio {
+
+RingByteBuffer::~RingByteBuffer() {
+    RuntimeError e;
+    this->close(e);
+}
+
+bool RingByteBuffer::open(size_t cap, RuntimeError &e) {
+    assert( m_base == nullptr );
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    cap = cap == 0 ? page : (cap + page - 1) / page * page;
+
+    int fd = memfd_create("mercury-ring", MFD_CLOEXEC);
+    if ( fd < 0 ) {
+        std::ostringstream oss;
+        oss<<"memfd_create() error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "RingByteBuffer::open");
+        return false;
+    }
+    if ( ftruncate(fd, (off_t)cap) != 0 ) {
+        std::ostringstream oss;
+        oss<<"ftruncate() ring memory error, "<<net::syserr<<"size: "<<cap;
+        e.set(-1, oss.str().c_str(), "RingByteBuffer::open");
+        ::close(fd);
+        return false;
+    }
+
+    // 先保留两倍容量的连续地址，再把同一段内存以MAP_FIXED映射到前后两半
+    char *base = (char *)mmap(nullptr, 2 * cap, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( base == MAP_FAILED ) {
+        std::ostringstream oss;
+        oss<<"mmap() reserve ring address error, "<<net::syserr<<"size: "<<2 * cap;
+        e.set(-1, oss.str().c_str(), "RingByteBuffer::open");
+        ::close(fd);
+        return false;
+    }
+    for ( int i = 0; i < 2; ++i ) {
+        void *p = mmap(base + i * cap, cap, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0);
+        if ( p == MAP_FAILED ) {
+            std::ostringstream oss;
+            oss<<"mmap() ring memory error, "<<net::syserr<<"size: "<<cap;
+            e.set(-1, oss.str().c_str(), "RingByteBuffer::open");
+            munmap(base, 2 * cap);
+            ::close(fd);
+            return false;
+        }
+    }
+    ::close(fd);   // 映射持有内存，不再需要fd
+
+    m_base = base;
+    m_cap = cap;
+    m_head = m_size = 0;
+    return true;
+}
+
+bool RingByteBuffer::close(RuntimeError &e) {
+    if ( m_base == nullptr ) return true;
+    bool isok = true;
+    if ( munmap(m_base, 2 * m_cap) != 0 ) {
+        std::ostringstream oss;
+        oss<<"munmap() ring memory error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "RingByteBuffer::close");
+        isok = false;
+    }
+    m_base = nullptr;
+    m_cap = m_head = m_size = 0;
+    return isok;
+}
+
+ByteBuffer RingByteBuffer::read_buffer(const ByteOrder &order) const {
+    ByteBuffer buf(const_cast<char *>(this->read_ptr()), m_size, order);
+    return buf.as_read_only();
+}
+
+ByteBuffer RingByteBuffer::write_buffer(const ByteOrder &order) {
+    return ByteBuffer(this->write_ptr(), this->writable(), order);
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,327 @@
+#include <mercury/nio/selector.h>
+#include "selector_impl.h"
+
+namespace mercury {
+namespace nio {
+
+SelectionKey::SelectionKey()
+    : m_selector(nullptr), m_channel(nullptr), m_att(nullptr)
+    , m_interest(0), m_edge(false), m_ready(0), m_index(0), m_deadline(nullptr)
+    , m_pending(-1), m_released(false), m_valid(false) {}
+
+SelectionKey::~SelectionKey() {
+    m_selector = nullptr;
+    m_channel = nullptr;
+    m_att = nullptr;
+    m_valid = false;
+}
+
+void * SelectionKey::attach(void *obj) {
+    void * old = m_att;
+    m_att = obj;
+    return old;
+}
+
+void * SelectionKey::attachment() const { return m_att; }
+
+int  SelectionKey::interest_ops() const { return m_interest; }
+
+void SelectionKey::interest_ops(int ops) const {
+    SelectionKey *self = const_cast<SelectionKey*>(this);
+    if ( !m_selector->m_pImpl->in_selector_thread() ) {
+        // 已提交尚未执行时只更新待生效的值
+        if ( self->m_pending.exchange(ops, std::memory_order_acq_rel) < 0 ) m_selector->m_pImpl->submit(self);
+        return;
+    }
+    // 已提交的任务执行时以本次设置为准
+    if ( m_pending.load(std::memory_order_acquire) >= 0 ) self->m_pending.store(ops, std::memory_order_release);
+    if ( !m_valid || ops == m_interest ) return;
+    RuntimeError e;
+    m_selector->m_pImpl->modify(self, ops, m_edge, e);
+}
+
+int  SelectionKey::ready_ops() const { return m_ready; }
+
+bool SelectionKey::edge_triggered() const { return m_edge; }
+
+void SelectionKey::edge_triggered(bool on) const {
+    if ( !m_valid || on == m_edge ) return;
+    RuntimeError e;
+    m_selector->m_pImpl->modify(const_cast<SelectionKey*>(this), m_interest, on, e);
+}
+
+void SelectionKey::deadline(long timeout) const {
+    if ( !m_valid ) return;
+    m_selector->m_pImpl->set_deadline(const_cast<SelectionKey*>(this), timeout);
+}
+
+bool SelectionKey::is_acceptable() const { return m_ready & OpAccept; }
+bool SelectionKey::is_timeout() const { return m_ready & OpTimeout; }
+bool SelectionKey::is_error() const { return m_ready & OpError; }
+bool SelectionKey::is_connectable() const { return m_ready & OpConnect; }
+bool SelectionKey::is_readable() const { return m_ready & OpRead; }
+bool SelectionKey::is_writable() const { return m_ready & OpWrite; }
+bool SelectionKey::is_valid() const { return m_valid; }
+
+void SelectionKey::run() {
+    int ops = m_pending.exchange(-1, std::memory_order_acq_rel);
+    if ( m_released ) { delete this; return; }
+    if ( !m_valid || ops < 0 || ops == m_interest ) return;
+    RuntimeError e;
+    m_selector->m_pImpl->modify(this, ops, m_edge, e);
+}
+
+SelectableChannel::SelectableChannel() {}
+
+SelectableChannel::~SelectableChannel() {
+    this->cancel_keys();
+}
+
+void SelectableChannel::cancel_keys() {
+    RuntimeError e;
+    for ( size_t i = 0; i < m_keys.size(); ++i ) {
+        SelectionKey *key = m_keys[i];
+        if ( key->is_valid() ) key->selector()->unreg(key, e);
+        key->m_channel = nullptr;   // 键由Selector延迟释放，断开与通道的关联
+    }
+    m_keys.clear();
+}
+
+SelectionKey * SelectableChannel::reg(Selector *selector, int ops, RuntimeError &e) {
+    return selector->reg(this, ops, nullptr, e);
+}
+
+SelectionKey * SelectableChannel::reg(Selector *selector, int ops, void *att, RuntimeError &e) {
+    return selector->reg(this, ops, att, e);
+}
+
+SelectionKey * SelectableChannel::key_for(Selector *selector) {
+    for ( size_t i = 0; i < m_keys.size(); ++i ) {
+        if ( m_keys[i]->is_valid() && m_keys[i]->selector() == selector ) return m_keys[i];
+    }
+    return nullptr;
+}
+
+bool SelectableChannel::is_registered() const {
+    for ( size_t i = 0; i < m_keys.size(); ++i ) {
+        if ( m_keys[i]->is_valid() ) return true;
+    }
+    return false;
+}
+
+Selector::Selector() : m_pImpl(nullptr) {}
+
+Selector::Selector(Selector &&other) : m_pImpl(other.m_pImpl) {
+    other.m_pImpl = nullptr;
+    if ( m_pImpl ) m_pImpl->rebind(this);
+}
+
+Selector::~Selector() {
+    if ( m_pImpl ) {
+        delete m_pImpl;
+        m_pImpl = nullptr;
+    }
+}
+
+Selector & Selector::operator=(Selector &&other) {
+    if ( this != &other ) {
+        delete m_pImpl;
+        m_pImpl = other.m_pImpl;
+        other.m_pImpl = nullptr;
+        if ( m_pImpl ) m_pImpl->rebind(this);
+    }
+    return *this;
+}
+
+bool Selector::open(RuntimeError &e) {
+    return this->open(EngineEpoll, e);
+}
+
+bool Selector::open(int engine, RuntimeError &e) {
+    if ( m_pImpl == nullptr ) m_pImpl = new SelectorImpl();
+
+    if ( !m_pImpl->is_open( ))  {
+        return m_pImpl->open(engine, e);
+    } else {
+        return true;
+    }
+}
+
+int Selector::engine() const {
+    return m_pImpl ? m_pImpl->engine() : EngineEpoll;
+}
+
+bool Selector::close(RuntimeError &e) {
+    if ( m_pImpl ) return m_pImpl->close(e);
+    else return true;
+}
+
+bool Selector::is_open() const {
+    return m_pImpl != nullptr && m_pImpl->is_open();
+}
+
+int Selector::select(RuntimeError &e) {
+    return this->select(-1, e);
+}
+
+int Selector::select(long timeout, RuntimeError &e) {
+    if ( !this->is_open() ) {
+        e.set(-1, "selector is not open", "Selector::select");
+        return -1;
+    }
+    return m_pImpl->select(timeout, e);
+}
+
+void Selector::wakeup() {
+    if ( this->is_open() ) m_pImpl->wakeup();
+}
+
+uint64_t Selector::wakeup_coalesced() const {
+    return m_pImpl ? m_pImpl->wakeup_coalesced() : 0;
+}
+
+bool Selector::schedule(Timer *timer, long delay, RuntimeError &e) {
+    if ( !this->is_open() ) {
+        e.set(-1, "selector is not open", "Selector::schedule");
+        return false;
+    }
+    m_pImpl->schedule(timer, delay);
+    return true;
+}
+
+size_t Selector::timers() const {
+    return m_pImpl ? m_pImpl->timers() : 0;
+}
+
+/**
+ * @brief 包装函数对象的任务，执行后释放自身。
+ */
+class FunctionTask : public Task {
+private:
+    std::function<void()> m_fn;
+
+public:
+    explicit FunctionTask(std::function<void()> &&fn) : m_fn(std::move(fn)) {}
+    void run() override { m_fn(); delete this; }
+};
+
+bool Selector::submit(Task *task, RuntimeError &e) {
+    if ( !this->is_open() ) {
+        e.set(-1, "selector is not open", "Selector::submit");
+        return false;
+    }
+    m_pImpl->submit(task);
+    return true;
+}
+
+bool Selector::submit(std::function<void()> fn, RuntimeError &e) {
+    if ( !this->is_open() ) {
+        e.set(-1, "selector is not open", "Selector::submit");
+        return false;
+    }
+    m_pImpl->submit(new FunctionTask(std::move(fn)));
+    return true;
+}
+
+bool Selector::in_selector_thread() const {
+    return m_pImpl == nullptr || m_pImpl->in_selector_thread();
+}
+
+size_t Selector::keys(std::vector<SelectionKey*> & keys) {
+    if ( m_pImpl == nullptr ) { keys.clear(); return 0; }
+    keys.assign(m_pImpl->keys().begin(), m_pImpl->keys().end());
+    return keys.size();
+}
+
+size_t Selector::selected_keys(std::vector<SelectionKey*> & keys) {
+    if ( m_pImpl == nullptr ) { keys.clear(); return 0; }
+    keys.assign(m_pImpl->selected().begin(), m_pImpl->selected().end());
+    return keys.size();
+}
+
+SelectionKey * Selector::reg(SelectableChannel *pch, int ops, void *att, RuntimeError &e) {
+    if ( !this->is_open() ) {
+        e.set(-1, "selector is not open", "Selector::reg");
+        return nullptr;
+    }
+    if ( (ops & ~pch->valid_ops()) != 0 ) {
+        std::ostringstream oss;
+        oss<<"invalid ops for channel, ops: "<<ops<<", valid ops: "<<pch->valid_ops();
+        e.set(-1, oss.str().c_str(), "Selector::reg");
+        return nullptr;
+    }
+
+    // 已注册的通道，更新关注事件和附件后返回原有的键。
+    SelectionKey * key = pch->key_for(this);
+    if ( key ) {
+        if ( ops != key->m_interest && !m_pImpl->modify(key, ops, key->m_edge, e) ) return nullptr;
+        key->attach(att);
+        return key;
+    }
+
+    key = new SelectionKey();
+    key->m_selector = this;
+    key->m_channel  = pch;
+    key->m_att      = att;
+    key->m_interest = ops;
+    if ( !m_pImpl->add(key, e) ) {
+        delete key;
+        e.push("Selector::reg() failed. ");
+        return nullptr;
+    }
+    key->m_valid = true;
+    pch->m_keys.push_back(key);
+    return key;
+}
+
+bool Selector::unreg(SelectionKey *key, RuntimeError &e) {
+    if ( key == nullptr || !key->is_valid() ) return true;
+    assert( key->selector() == this );
+    return m_pImpl->remove(key, e);
+}
+
+bool Selector::recv_buffers(unsigned count, unsigned size, RuntimeError &e) {
+    if ( !this->is_open() ) {
+        e.set(-1, "selector is not open", "Selector::recv_buffers");
+        return false;
+    }
+    return m_pImpl->poller()->recv_buffers(count, size, e);
+}
+
+uint64_t Selector::syscalls() const {
+    return this->is_open() ? m_pImpl->poller()->syscalls() : 0;
+}
+
+bool Selector::prepare_async(SelectableChannel *pch, RuntimeError &e) {
+    if ( !this->is_open() ) {
+        e.set(-1, "selector is not open", "Selector::prepare_async");
+        return false;
+    }
+    if ( m_pImpl->engine() != EngineUring ) {
+        e.set(-1, "completion mode requires Selector::EngineUring", "Selector::prepare_async");
+        return false;
+    }
+    if ( pch->fd() < 0 ) {
+        e.set(-1, "channel is not open", "Selector::prepare_async");
+        return false;
+    }
+    // 注销键时Poller取消该fd上全部未结束的请求，通道关闭前总会注销。
+    return pch->key_for(this) != nullptr || this->reg(pch, 0, nullptr, e) != nullptr;
+}
+
+bool Selector::accept_async(SelectableChannel *pch, Completion *c, RuntimeError &e) {
+    if ( !this->prepare_async(pch, e) ) return false;
+    return m_pImpl->poller()->accept_async(pch->fd(), c, e);
+}
+
+bool Selector::read_async(SelectableChannel *pch, Completion *c, RuntimeError &e) {
+    if ( !this->prepare_async(pch, e) ) return false;
+    return m_pImpl->poller()->recv_async(pch->fd(), c, e);
+}
+
+bool Selector::write_async(SelectableChannel *pch, const char *buf, size_t len, Completion *c, RuntimeError &e) {
+    if ( !this->prepare_async(pch, e) ) return false;
+    return m_pImpl->poller()->send_async(pch->fd(), buf, len, c, e);
+}
+
+}} // end namespace mercury::nio
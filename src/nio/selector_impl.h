@@ -0,0 +1,369 @@
+#pragma once
+#include <mercury/nio/selector.h>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cassert>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "../net/socket_utils.h"
+#include "poller.h"
+#include "uring_poller.h"
+
+namespace mercury {
+namespace nio {
+
+using mercury::net::syserr;
+
+/**
+ * @brief Selector实现，内核事件接口由Poller完成(epoll或io_uring)。
+ * 注册键保存在连续数组中，键记录自身下标，注册和注销都是O(1)。
+ * 事件数组和就绪键数组预先分配，select过程中不做内存分配，
+ * 只有当一次返回的事件数占满事件数组时才扩容。
+ *
+ * wakeup通过eventfd实现，eventfd以空指针注册到Poller。m_wakeup_pending标记
+ * 已有未被消费的唤醒，期间其它线程的wakeup只计数不再写eventfd，
+ * 多次并发唤醒合并为一次epoll事件。
+ *
+ * 定时器由分层时间轮管理，select的等待时间不超过时间轮下一次需要推进的时刻，
+ * 等待返回后推进时间轮并批量回调到期的定时器。键的期限也是时间轮中的定时器，
+ * 到期时键以OpTimeout就绪。
+ *
+ * 其它线程提交的任务进入无锁任务队列，select返回前执行。队列由空变为非空时
+ * 提交方通过wakeup唤醒select，Selector线程自身提交时只需让下一次select不等待。
+ *
+ * 完成模式的请求由Poller直接提交，结果随就绪事件一起收取，在就绪键整理之后、
+ * 定时器之前回调。
+ */
+class Selector::SelectorImpl {
+public:
+    const static size_t InitEvents = 1024;
+    const static size_t MaxEvents  = 65536;
+
+private:
+    Poller                         * m_poller;
+    int                              m_engine;
+    int                              m_wakefd;     // wakeup使用的eventfd
+    std::atomic<bool>                m_wakeup_pending;
+    std::atomic<uint64_t>            m_wakeup_coalesced;
+    std::vector<PollEvent>           m_events;     // Poller::wait输出缓存
+    std::vector<SelectionKey*>       m_keys;       // 全部有效注册键
+    std::vector<SelectionKey*>       m_selected;   // 最近一次select的就绪键
+    std::vector<SelectionKey*>       m_cancelled;  // 已注销待释放的键
+    TimerWheel                       m_timers;     // 定时器和键的期限
+    TaskQueue                        m_tasks;      // 其它线程提交的任务
+    std::atomic<std::thread::id>     m_owner;      // 最近一次调用select的线程
+
+public:
+    SelectorImpl()
+        : m_poller(nullptr), m_engine(Selector::EngineEpoll), m_wakefd(-1)
+        , m_wakeup_pending(false), m_wakeup_coalesced(0), m_owner(std::thread::id()) {}
+    ~SelectorImpl() { RuntimeError e; this->close(e); m_tasks.run_all(); }
+
+    bool open(int engine, RuntimeError &e);
+    bool close(RuntimeError &e);
+    bool is_open() const { return m_poller != nullptr; }
+    int  engine() const { return m_engine; }
+
+    int  select(long timeout, RuntimeError &e);
+
+    Poller * poller() const { return m_poller; }
+
+    void     wakeup();
+    uint64_t wakeup_coalesced() const { return m_wakeup_coalesced.load(std::memory_order_relaxed); }
+
+    bool add(SelectionKey *key, RuntimeError &e);
+    bool modify(SelectionKey *key, int ops, bool edge, RuntimeError &e);
+    bool remove(SelectionKey *key, RuntimeError &e);
+
+    void   set_deadline(SelectionKey *key, long timeout);
+    void   schedule(Timer *timer, long delay) { m_timers.schedule_at(timer, now_ms() + delay); }
+    size_t timers() const { return m_timers.size(); }
+
+    void   submit(Task *task);
+    bool   in_selector_thread() const {
+        return m_owner.load(std::memory_order_relaxed) == std::this_thread::get_id();
+    }
+
+    /// 单调时钟的当前毫秒数。
+    static int64_t now_ms() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /// Selector对象移动后，更新所有键指向的Selector。
+    void rebind(Selector *selector);
+
+    const std::vector<SelectionKey*> & keys() const { return m_keys; }
+    const std::vector<SelectionKey*> & selected() const { return m_selected; }
+
+public:
+    static uint32_t to_epoll(int ops, bool edge);
+    static int      to_ready(uint32_t events, int interest);
+
+private:
+    void consume_wakeup();
+    long wait_timeout(long timeout) const;
+    void expire_key(SelectionKey *key);
+    void release_cancelled();
+    void release_key(SelectionKey *key);
+
+    /// 键的期限定时器，到期时把键加入就绪键。
+    class KeyDeadline : public Timer {
+    public:
+        SelectorImpl * impl;
+        SelectionKey * key;
+        KeyDeadline(SelectorImpl *i, SelectionKey *k) : impl(i), key(k) {}
+        void on_timeout() override { impl->expire_key(key); }
+    };
+}; // end class Selector::SelectorImpl
+
+inline uint32_t Selector::SelectorImpl::to_epoll(int ops, bool edge) {
+    uint32_t events = 0;
+    if ( ops & (SelectionKey::OpRead  | SelectionKey::OpAccept) )  events |= EPOLLIN;
+    if ( ops & (SelectionKey::OpWrite | SelectionKey::OpConnect) ) events |= EPOLLOUT;
+    // 边沿触发时同时关注EPOLLRDHUP，对端关闭总能产生一次通知，由读取循环读到0发现关闭。
+    if ( edge ) events |= EPOLLET | EPOLLRDHUP;
+    return events;
+}
+
+inline int Selector::SelectorImpl::to_ready(uint32_t events, int interest) {
+    int ready = 0;
+    // 关注OpError时EPOLLERR只报告为OpError，由调用方读取错误队列，不再视为可读写。
+    if ( interest & SelectionKey::OpError ) {
+        if ( events & EPOLLERR ) ready |= SelectionKey::OpError;
+        events &= ~EPOLLERR;
+    }
+    // 错误和挂断同时视为可读写，由后续的读写操作获得具体错误。
+    if ( events & (EPOLLIN | EPOLLERR | EPOLLHUP | EPOLLRDHUP) )
+        ready |= interest & (SelectionKey::OpRead | SelectionKey::OpAccept);
+    if ( events & (EPOLLOUT | EPOLLERR | EPOLLHUP) )
+        ready |= interest & (SelectionKey::OpWrite | SelectionKey::OpConnect);
+    return ready;
+}
+
+inline bool Selector::SelectorImpl::open(int engine, RuntimeError &e) {
+    assert( m_poller == nullptr );
+    Poller * poller = nullptr;
+    if ( engine == Selector::EngineEpoll ) poller = new EpollPoller();
+    else if ( engine == Selector::EngineUring ) poller = new UringPoller();
+    else {
+        std::ostringstream oss;
+        oss<<"unknown selector engine: "<<engine;
+        e.set(-1, oss.str().c_str(), "SelectorImpl::open");
+        return false;
+    }
+    if ( !poller->open(e) ) {
+        delete poller;
+        e.push("SelectorImpl::open() failed. ");
+        return false;
+    }
+
+    int wfd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ( wfd < 0 ) {
+        std::ostringstream oss;
+        oss<<"eventfd() error, "<<syserr;
+        e.set(-1, oss.str().c_str(), "SelectorImpl::open");
+        delete poller;
+        return false;
+    }
+
+    // 空指针表示唤醒事件
+    if ( !poller->add(wfd, EPOLLIN, nullptr, e) ) {
+        e.push("SelectorImpl::open() failed. ");
+        ::close(wfd);
+        delete poller;
+        return false;
+    }
+
+    m_poller = poller;
+    m_engine = engine;
+    m_wakefd = wfd;
+    m_wakeup_pending.store(false);
+    m_events.resize(InitEvents);
+    m_selected.reserve(InitEvents);
+    m_timers.reset(now_ms());
+    m_owner.store(std::thread::id(), std::memory_order_relaxed);
+    return true;
+}
+
+inline bool Selector::SelectorImpl::close(RuntimeError &e) {
+    if ( m_poller == nullptr ) return true;
+
+    // 先执行已提交的任务，释放键时仍在队列中的键留到队列执行时删除。
+    m_tasks.run_all();
+    release_cancelled();
+    for ( size_t i = 0; i < m_keys.size(); ++i ) release_key(m_keys[i]);
+    m_keys.clear();
+    m_selected.clear();
+    m_timers.reset(0);
+    m_tasks.run_all();
+
+    bool isok = m_poller->close(e);
+    delete m_poller;
+    m_poller = nullptr;
+    ::close(m_wakefd);
+    m_wakefd = -1;
+    return isok;
+}
+
+inline int Selector::SelectorImpl::select(long timeout, RuntimeError &e) {
+    for ( size_t i = 0; i < m_selected.size(); ++i ) m_selected[i]->m_ready = 0;
+    m_selected.clear();
+    // 首次select或换线程select时先执行已提交的任务，此前的修改在本次等待前生效。
+    std::thread::id self = std::this_thread::get_id();
+    if ( m_owner.load(std::memory_order_relaxed) != self ) {
+        m_owner.store(self, std::memory_order_relaxed);
+        m_tasks.run_all();
+    }
+    release_cancelled();
+
+    int n = m_poller->wait(m_events.data(), (int)m_events.size(), this->wait_timeout(timeout), e);
+    if ( n < 0 ) {
+        e.push("SelectorImpl::select() failed. ");
+        return -1;
+    }
+
+    for ( int i = 0; i < n; ++i ) {
+        SelectionKey *key = (SelectionKey *)m_events[i].data.ptr;
+        if ( key == nullptr ) { consume_wakeup(); continue; }
+        int ready = to_ready(m_events[i].events, key->m_interest);
+        if ( ready == 0 ) continue;
+        // 同一个键可能在一次返回中出现多次(io_uring多次触发poll)，合并就绪事件。
+        if ( key->m_ready == 0 ) m_selected.push_back(key);
+        key->m_ready |= ready;
+    }
+
+    m_poller->complete();
+    // 没有定时器时也推进，保持时间轮的刻度跟随时钟，之后调度的定时器按当前刻度放置。
+    m_timers.advance(now_ms());
+    m_tasks.run_all();
+
+    // 事件数组被占满，说明就绪通道较多，扩容后下次可一次取回更多事件。
+    if ( (size_t)n == m_events.size() && m_events.size() < MaxEvents ) {
+        m_events.resize(m_events.size() * 2);
+        m_selected.reserve(m_events.size());
+    }
+    return (int)m_selected.size();
+}
+
+inline long Selector::SelectorImpl::wait_timeout(long timeout) const {
+    if ( !m_tasks.empty() ) return 0;
+    if ( m_timers.empty() || timeout == 0 ) return timeout;
+    int64_t wait = m_timers.next_timeout(now_ms());
+    return ( timeout < 0 || wait < timeout ) ? (long)wait : timeout;
+}
+
+inline void Selector::SelectorImpl::expire_key(SelectionKey *key) {
+    if ( key->m_ready == 0 ) m_selected.push_back(key);
+    key->m_ready |= SelectionKey::OpTimeout;
+}
+
+inline void Selector::SelectorImpl::set_deadline(SelectionKey *key, long timeout) {
+    if ( timeout < 0 ) {
+        if ( key->m_deadline ) key->m_deadline->cancel();
+        return;
+    }
+    if ( key->m_deadline == nullptr ) key->m_deadline = new KeyDeadline(this, key);
+    this->schedule(key->m_deadline, timeout);
+}
+
+inline void Selector::SelectorImpl::submit(Task *task) {
+    // Selector线程提交时下一次select不会等待，不需要唤醒。
+    if ( m_tasks.push(task) && m_owner.load(std::memory_order_relaxed) != std::this_thread::get_id() )
+        this->wakeup();
+}
+
+inline void Selector::SelectorImpl::wakeup() {
+    if ( m_wakeup_pending.exchange(true, std::memory_order_acq_rel) ) {
+        m_wakeup_coalesced.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    uint64_t one = 1;
+    ssize_t r = ::write(m_wakefd, &one, sizeof(one));
+    (void)r;   // 计数溢出时返回EAGAIN，此时eventfd本身已可读，无需处理
+}
+
+inline void Selector::SelectorImpl::consume_wakeup() {
+    // 先清标记再读eventfd：清标记后到来的wakeup会重新写入，最多引起一次多余的唤醒，不会丢失。
+    m_wakeup_pending.store(false, std::memory_order_release);
+    uint64_t value;
+    ssize_t r = ::read(m_wakefd, &value, sizeof(value));
+    (void)r;
+}
+
+inline bool Selector::SelectorImpl::add(SelectionKey *key, RuntimeError &e) {
+    int fd = key->m_channel->fd();
+    if ( !m_poller->add(fd, to_epoll(key->m_interest, key->m_edge), key, e) ) {
+        e.push("SelectorImpl::add() failed. ");
+        return false;
+    }
+    key->m_index = m_keys.size();
+    m_keys.push_back(key);
+    return true;
+}
+
+inline bool Selector::SelectorImpl::modify(SelectionKey *key, int ops, bool edge, RuntimeError &e) {
+    int fd = key->m_channel->fd();
+    if ( !m_poller->modify(fd, to_epoll(ops, edge), key, e) ) {
+        e.push("SelectorImpl::modify() failed. ");
+        return false;
+    }
+    key->m_interest = ops;
+    key->m_edge = edge;
+    return true;
+}
+
+inline bool Selector::SelectorImpl::remove(SelectionKey *key, RuntimeError &e) {
+    if ( !key->m_valid ) return true;
+
+    // 从注册表中移除，末尾元素补位。
+    size_t idx = key->m_index;
+    assert( idx < m_keys.size() && m_keys[idx] == key );
+    SelectionKey *last = m_keys.back();
+    m_keys[idx] = last;
+    last->m_index = idx;
+    m_keys.pop_back();
+
+    this->set_deadline(key, -1);
+    key->m_valid = false;
+    m_cancelled.push_back(key);
+
+    int fd = key->m_channel ? key->m_channel->fd() : -1;
+    if ( fd < 0 ) return true;
+    if ( !m_poller->remove(fd, e) ) {
+        e.push("SelectorImpl::remove() failed. ");
+        return false;
+    }
+    return true;
+}
+
+inline void Selector::SelectorImpl::rebind(Selector *selector) {
+    for ( size_t i = 0; i < m_keys.size(); ++i ) m_keys[i]->m_selector = selector;
+    for ( size_t i = 0; i < m_cancelled.size(); ++i ) m_cancelled[i]->m_selector = selector;
+}
+
+inline void Selector::SelectorImpl::release_cancelled() {
+    for ( size_t i = 0; i < m_cancelled.size(); ++i ) release_key(m_cancelled[i]);
+    m_cancelled.clear();
+}
+
+inline void Selector::SelectorImpl::release_key(SelectionKey *key) {
+    SelectableChannel *ch = key->m_channel;
+    if ( ch ) {
+        std::vector<SelectionKey*> &v = ch->m_keys;
+        v.erase(std::remove(v.begin(), v.end(), key), v.end());
+    }
+    delete key->m_deadline;
+    key->m_deadline = nullptr;
+    key->m_channel = nullptr;
+    // 仍在任务队列中的键由队列执行时删除，见SelectionKey::run
+    if ( key->m_pending.load(std::memory_order_acquire) >= 0 ) key->m_released = true;
+    else delete key;
+}
+
+}} // end namespace mercury::nio
@@ -1,48 +1,9 @@
 #include <mercury/nio/channel.h>
+#include <cassert>
 
 namespace mercury {
 namespace nio {
 
-SelectableChannel::SelectableChannel() {
-    // not impl
-}
-
-SelectableChannel::~SelectableChannel() {
-    // not impl
-}
-
-class Selector::SelectorImpl{
-private:
-public:
-    bool open(RuntimeError &e);
-    bool close(RuntimeError &e);
-    bool is_open() const;
-}; // end class Selector::SelectorImpl
-
-Selector::Selector() : m_pImpl(nullptr) {}
-
-Selector::~Selector() {
-    if ( m_pImpl ) {
-        delete m_pImpl; 
-        m_pImpl = nullptr; 
-    }
-}
-
-bool Selector::open(RuntimeError &e) {
-    if ( m_pImpl == nullptr ) m_pImpl = new SelectorImpl();
-
-    if ( !m_pImpl->is_open( ))  {
-        return m_pImpl->open(e);
-    } else {
-        return true;
-    }
-}
-
-bool Selector::close(RuntimeError &e) {
-    if ( m_pImpl ) return m_pImpl->close(e);
-    else return true;
-}
-
 class ServerSocketChannel::ServerSocketChannelImpl {
 public:
     mercury::net::ServerSocket m_socket;
@@ -51,6 +12,7 @@ public:
 ServerSocketChannel::ServerSocketChannel() : m_pSockImpl(nullptr) {}
 
 ServerSocketChannel::~ServerSocketChannel() {
+    this->cancel_keys();
     if ( m_pSockImpl ) {
         delete m_pSockImpl;
         m_pSockImpl = nullptr;
@@ -60,17 +22,72 @@ ServerSocketChannel::~ServerSocketChannel() {
 bool ServerSocketChannel::create(int domain, RuntimeError &e) {
     if ( m_pSockImpl == nullptr) m_pSockImpl = new ServerSocketChannelImpl();
     assert( m_pSockImpl->m_socket.is_closed() );
-    return m_pSockImpl->m_socket.create(domain, e); 
+    if ( !m_pSockImpl->m_socket.create(domain, e) ) return false;
+    return m_pSockImpl->m_socket.set_block_mode(false, e);
 }
 
 bool ServerSocketChannel::close(RuntimeError &e ) {
     if ( m_pSockImpl != nullptr && !m_pSockImpl->m_socket.is_closed()) {
+        this->cancel_keys();
         return m_pSockImpl->m_socket.close(e);
     } else {
         return true;
     }
 }
 
+bool ServerSocketChannel::bind(const char *addr, int port, RuntimeError &e) {
+    assert( m_pSockImpl != nullptr );
+    return m_pSockImpl->m_socket.bind(addr, port, e);
+}
+
+bool ServerSocketChannel::listen(int backlog, RuntimeError &e) {
+    assert( m_pSockImpl != nullptr );
+    return m_pSockImpl->m_socket.listen(backlog, e);
+}
+
+bool ServerSocketChannel::accept(net::StreamSocket &sock, RuntimeError &e) {
+    assert( m_pSockImpl != nullptr );
+    net::StreamSocket * p = &sock;
+    ssize_t r = m_pSockImpl->m_socket.accept_batch(&p, 1, SOCK_NONBLOCK | SOCK_CLOEXEC, e);
+    if ( r == 0 ) e.set(-1, "no pending connection", "ServerSocketChannel::accept");
+    return r == 1;
+}
+
+bool ServerSocketChannel::accept(StreamSocketChannel &ch, RuntimeError &e) {
+    assert( ch.socket()->is_closed() );
+    return this->accept(*ch.socket(), e);
+}
+
+ssize_t ServerSocketChannel::accept_batch(StreamSocketChannel **chs, size_t n, RuntimeError &e) {
+    assert( m_pSockImpl != nullptr );
+    size_t i = 0;
+    for ( ; i < n; ++i ) {
+        net::StreamSocket * p = chs[i]->socket();
+        ssize_t r = m_pSockImpl->m_socket.accept_batch(&p, 1, SOCK_NONBLOCK | SOCK_CLOEXEC, e);
+        if ( r == 0 ) break;
+        if ( r < 0 ) return i > 0 ? (ssize_t)i : -1;
+    }
+    return (ssize_t)i;
+}
+
+bool ServerSocketChannel::accept_async(Selector *selector, Completion *c, RuntimeError &e) {
+    assert( m_pSockImpl != nullptr );
+    return selector->accept_async(this, c, e);
+}
+
+bool ServerSocketChannel::adopt(int fd, StreamSocketChannel &ch, RuntimeError &e) {
+    assert( m_pSockImpl != nullptr );
+    return m_pSockImpl->m_socket.adopt(fd, *ch.socket(), e);
+}
+
+net::ServerSocket * ServerSocketChannel::socket() {
+    return m_pSockImpl ? &m_pSockImpl->m_socket : nullptr;
+}
+
+int ServerSocketChannel::fd() const {
+    return m_pSockImpl ? m_pSockImpl->m_socket.fd() : -1;
+}
+
 int ServerSocketChannel::valid_ops() const {
     return SelectionKey::OpAccept;
 }
@@ -0,0 +1,246 @@
+#include <mercury/nio/channel.h>
+#include <cassert>
+#include <string.h>
+#include <deque>
+
+namespace mercury {
+namespace nio {
+
+class StreamSocketChannel::StreamSocketChannelImpl {
+public:
+    /// 一次零拷贝发送，按通知序号顺序排列。
+    struct ZeroCopySend {
+        uint32_t seq;
+        void   * tag;
+        bool     done;
+    };
+
+    mercury::net::StreamSocket m_socket;
+    bool                       m_zerocopy;
+    size_t                     m_threshold;
+    uint32_t                   m_zcseq;      // 下一次零拷贝发送的通知序号
+    uint64_t                   m_zccopied;
+    std::deque<ZeroCopySend>   m_zcpending;
+
+    StreamSocketChannelImpl()
+        : m_zerocopy(false), m_threshold(ZeroCopyThreshold), m_zcseq(0), m_zccopied(0) {}
+
+    /// 标记序号区间[lo, hi]内的发送已完成，序号可能回绕。
+    void complete(uint32_t lo, uint32_t hi) {
+        if ( m_zcpending.empty() ) return;
+        uint32_t first = m_zcpending.front().seq;
+        for ( uint32_t seq = lo; ; ++seq ) {
+            uint32_t idx = seq - first;
+            if ( idx < m_zcpending.size() ) m_zcpending[idx].done = true;
+            if ( seq == hi ) break;
+        }
+    }
+}; // end class StreamSocketChannel::StreamSocketChannelImpl
+
+StreamSocketChannel::StreamSocketChannel() : m_pSockImpl(new StreamSocketChannelImpl()) {}
+
+StreamSocketChannel::~StreamSocketChannel() {
+    this->cancel_keys();
+    delete m_pSockImpl;
+    m_pSockImpl = nullptr;
+}
+
+bool StreamSocketChannel::close(RuntimeError &e) {
+    if ( m_pSockImpl->m_socket.is_closed() ) return true;
+    this->cancel_keys();
+    m_pSockImpl->m_zcpending.clear();   // 关闭后不再有完成通知
+    return m_pSockImpl->m_socket.close(e);
+}
+
+bool StreamSocketChannel::is_closed() const {
+    return m_pSockImpl->m_socket.is_closed();
+}
+
+bool StreamSocketChannel::create(int domain, RuntimeError &e) {
+    assert( m_pSockImpl->m_socket.is_closed() );
+    if ( !m_pSockImpl->m_socket.create(domain, e) ) return false;
+    return m_pSockImpl->m_socket.set_block_mode(false, e);
+}
+
+bool StreamSocketChannel::connect(const char *host, int port, RuntimeError &e) {
+    if ( m_pSockImpl->m_socket.is_closed() ) {
+        int domain = strchr(host, ':') ? AF_INET6 : AF_INET;
+        if ( !this->create(domain, e) ) return false;
+    }
+    return m_pSockImpl->m_socket.connect(host, port, e);
+}
+
+int StreamSocketChannel::finish_connect(RuntimeError &e) {
+    return m_pSockImpl->m_socket.finish_connect(e);
+}
+
+bool StreamSocketChannel::is_connection_pending() const {
+    return m_pSockImpl->m_socket.is_connecting();
+}
+
+bool StreamSocketChannel::is_connected() const {
+    return m_pSockImpl->m_socket.is_connected();
+}
+
+ssize_t StreamSocketChannel::read(ByteBuffer &buf, RuntimeError &e) {
+    size_t remain = buf.remaining();
+    if ( remain == 0 ) return 0;
+    ssize_t r = m_pSockImpl->m_socket.receive(buf.ptr(), remain, e);
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+ssize_t StreamSocketChannel::read(RingByteBuffer &buf, RuntimeError &e) {
+    size_t space = buf.writable();
+    if ( space == 0 ) return 0;
+    ssize_t r = m_pSockImpl->m_socket.receive(buf.write_ptr(), space, e);
+    if ( r > 0 ) buf.commit((size_t)r);
+    return r;
+}
+
+ssize_t StreamSocketChannel::write(ByteBuffer &buf, RuntimeError &e) {
+    size_t remain = buf.remaining();
+    if ( remain == 0 ) return 0;
+    ssize_t r = m_pSockImpl->m_socket.send(buf.ptr(), remain, e);
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+/// 由各缓存的剩余区间生成iovec，跳过没有剩余空间的缓存。
+static int fill_iov(struct iovec *iov, ByteBuffer **bufs, size_t n) {
+    int cnt = 0;
+    for ( size_t i = 0; i < n && cnt < (int)StreamSocketChannel::MaxIov; ++i ) {
+        size_t remain = bufs[i]->remaining();
+        if ( remain == 0 ) continue;
+        iov[cnt].iov_base = bufs[i]->ptr();
+        iov[cnt].iov_len  = remain;
+        ++cnt;
+    }
+    return cnt;
+}
+
+/// 按实际传输的字节数依次前移各缓存的position。
+static void advance(ByteBuffer **bufs, size_t n, size_t bytes) {
+    for ( size_t i = 0; i < n && bytes > 0; ++i ) {
+        size_t step = bufs[i]->remaining();
+        if ( step > bytes ) step = bytes;
+        bufs[i]->position(bufs[i]->position() + step);
+        bytes -= step;
+    }
+}
+
+ssize_t StreamSocketChannel::read(ByteBuffer **bufs, size_t n, RuntimeError &e) {
+    struct iovec iov[MaxIov];
+    int cnt = fill_iov(iov, bufs, n);
+    if ( cnt == 0 ) return 0;
+    ssize_t r = m_pSockImpl->m_socket.receivev(iov, cnt, e);
+    if ( r > 0 ) advance(bufs, n, (size_t)r);
+    return r;
+}
+
+ssize_t StreamSocketChannel::write(ByteBuffer **bufs, size_t n, RuntimeError &e) {
+    struct iovec iov[MaxIov];
+    int cnt = fill_iov(iov, bufs, n);
+    if ( cnt == 0 ) return 0;
+    ssize_t r = m_pSockImpl->m_socket.sendv(iov, cnt, e);
+    if ( r > 0 ) advance(bufs, n, (size_t)r);
+    return r;
+}
+
+ssize_t StreamSocketChannel::write(CompositeByteBuffer &buf, RuntimeError &e) {
+    struct iovec iov[MaxIov];
+    size_t cnt = buf.iovecs(iov, MaxIov);
+    if ( cnt == 0 ) return 0;
+    ssize_t r = m_pSockImpl->m_socket.sendv(iov, (int)cnt, e);
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+bool StreamSocketChannel::zerocopy(size_t threshold, RuntimeError &e) {
+    if ( !m_pSockImpl->m_socket.set_zerocopy(1, e) ) return false;
+    m_pSockImpl->m_zerocopy = true;
+    m_pSockImpl->m_threshold = threshold;
+    return true;
+}
+
+bool StreamSocketChannel::is_zerocopy() const {
+    return m_pSockImpl->m_zerocopy;
+}
+
+bool StreamSocketChannel::is_zerocopy(size_t len) const {
+    return m_pSockImpl->m_zerocopy && len >= m_pSockImpl->m_threshold;
+}
+
+ssize_t StreamSocketChannel::write_zerocopy(ByteBuffer &buf, void *tag, RuntimeError &e) {
+    size_t remain = buf.remaining();
+    if ( remain == 0 ) return 0;
+
+    ssize_t r;
+    if ( this->is_zerocopy(remain) ) {
+        r = m_pSockImpl->m_socket.send_zerocopy(buf.ptr(), remain, e);
+        if ( r > 0 ) {
+            StreamSocketChannelImpl::ZeroCopySend zc = { m_pSockImpl->m_zcseq++, tag, false };
+            m_pSockImpl->m_zcpending.push_back(zc);
+        }
+    } else {
+        r = m_pSockImpl->m_socket.send(buf.ptr(), remain, e);
+    }
+    if ( r > 0 ) buf.position(buf.position() + r);
+    return r;
+}
+
+ssize_t StreamSocketChannel::reap_zerocopy(void **tags, size_t n, RuntimeError &e) {
+    uint32_t lo, hi;
+    bool     copied;
+    int r;
+    while ( (r = m_pSockImpl->m_socket.read_zerocopy_completion(&lo, &hi, &copied, e)) > 0 ) {
+        m_pSockImpl->complete(lo, hi);
+        if ( copied ) m_pSockImpl->m_zccopied += hi - lo + 1;
+    }
+    if ( r < 0 ) return -1;
+
+    // 按发送顺序输出，同一tag的最后一次发送完成时才输出该tag。
+    std::deque<StreamSocketChannelImpl::ZeroCopySend> &pending = m_pSockImpl->m_zcpending;
+    size_t count = 0;
+    while ( count < n && !pending.empty() && pending.front().done ) {
+        void * tag = pending.front().tag;
+        pending.pop_front();
+        if ( pending.empty() || pending.front().tag != tag ) tags[count++] = tag;
+    }
+    return (ssize_t)count;
+}
+
+ssize_t StreamSocketChannel::transfer_from(int fd, int64_t offset, size_t len, RuntimeError &e) {
+    return m_pSockImpl->m_socket.transfer_from(fd, offset, len, e);
+}
+
+size_t StreamSocketChannel::zerocopy_pending() const {
+    return m_pSockImpl->m_zcpending.size();
+}
+
+uint64_t StreamSocketChannel::zerocopy_copied() const {
+    return m_pSockImpl->m_zccopied;
+}
+
+bool StreamSocketChannel::read_async(Selector *selector, Completion *c, RuntimeError &e) {
+    return selector->read_async(this, c, e);
+}
+
+bool StreamSocketChannel::write_async(Selector *selector, const ByteBuffer &buf, Completion *c, RuntimeError &e) {
+    size_t remain = buf.remaining();
+    return selector->write_async(this, remain > 0 ? buf.ptr() : nullptr, remain, c, e);
+}
+
+net::StreamSocket * StreamSocketChannel::socket() {
+    return &m_pSockImpl->m_socket;
+}
+
+int StreamSocketChannel::fd() const {
+    return m_pSockImpl->m_socket.fd();
+}
+
+int StreamSocketChannel::valid_ops() const {
+    return SelectionKey::OpConnect | SelectionKey::OpRead | SelectionKey::OpWrite | SelectionKey::OpError;
+}
+
+}} // end namespace mercury::nio
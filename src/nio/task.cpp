@@ -0,0 +1,45 @@
+#include <mercury/nio/task.h>
+#include <thread>
+
+namespace mercury {
+namespace nio {
+
+// 后继指针尚未写入的标记
+static Task * const Busy = reinterpret_cast<Task*>(static_cast<uintptr_t>(1));
+
+bool TaskQueue::push(Task *task) {
+    task->m_next.store(Busy, std::memory_order_relaxed);
+    Task *prev = m_head.exchange(task, std::memory_order_acq_rel);
+    task->m_next.store(prev, std::memory_order_release);
+    return prev == nullptr;
+}
+
+size_t TaskQueue::run_all() {
+    Task *node = m_head.exchange(nullptr, std::memory_order_acquire);
+    if ( node == nullptr ) return 0;
+
+    // 链表是后进先出的，反转为入队顺序。
+    Task *fifo = nullptr;
+    while ( node ) {
+        Task *next = node->m_next.load(std::memory_order_acquire);
+        for ( int spin = 0; next == Busy; ++spin ) {
+            if ( spin > 64 ) std::this_thread::yield();
+            next = node->m_next.load(std::memory_order_acquire);
+        }
+        node->m_next.store(fifo, std::memory_order_relaxed);
+        fifo = node;
+        node = next;
+    }
+
+    size_t n = 0;
+    while ( fifo ) {
+        Task *next = fifo->m_next.load(std::memory_order_relaxed);
+        fifo->m_next.store(nullptr, std::memory_order_relaxed);
+        fifo->run();   // 先取得后继，run中可以释放或再次提交本任务
+        fifo = next;
+        ++n;
+    }
+    return n;
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,191 @@
+#include <mercury/nio/timer.h>
+#include <cassert>
+#include <limits>
+
+namespace mercury {
+namespace nio {
+
+Timer::Timer()
+    : m_prev(nullptr), m_next(nullptr), m_wheel(nullptr), m_expire(0), m_slot(-1) {}
+
+Timer::~Timer() { this->cancel(); }
+
+void Timer::cancel() {
+    if ( m_wheel ) m_wheel->cancel(this);
+}
+
+// 第level层(1~3)每槽的刻度数的位数
+static inline int level_shift(int level) {
+    return TimerWheel::Slots0Bits + TimerWheel::SlotsNBits * (level - 1);
+}
+
+// 第level层(1~3)的首个槽位
+static inline int level_base(int level) {
+    return TimerWheel::Slots0 + TimerWheel::SlotsN * (level - 1);
+}
+
+TimerWheel::TimerWheel(int64_t now) : m_now(now), m_count(0), m_firing(nullptr) {
+    for ( int i = 0; i < TotalSlots; ++i ) m_slots[i] = nullptr;
+    for ( int i = 0; i < TotalSlots / 64; ++i ) m_bitmap[i] = 0;
+}
+
+TimerWheel::~TimerWheel() { this->reset(0); }
+
+void TimerWheel::reset(int64_t now) {
+    // 只断开定时器与本时间轮的关联，定时器对象由调用方持有。
+    for ( int i = -1; i < TotalSlots; ++i ) {
+        Timer *&head = ( i < 0 ) ? m_firing : m_slots[i];
+        for ( Timer *t = head; t; ) {
+            Timer *next = t->m_next;
+            t->m_prev = t->m_next = nullptr;
+            t->m_wheel = nullptr;
+            t->m_slot = -1;
+            t = next;
+        }
+        head = nullptr;
+    }
+    for ( int i = 0; i < TotalSlots / 64; ++i ) m_bitmap[i] = 0;
+    m_count = 0;
+    m_now = now;
+}
+
+void TimerWheel::schedule(Timer *timer, int64_t delay) {
+    this->schedule_at(timer, m_now + (delay > 0 ? delay : 0));
+}
+
+void TimerWheel::schedule_at(Timer *timer, int64_t expire) {
+    if ( timer->m_wheel ) timer->m_wheel->cancel(timer);
+    // 当前刻度已处理过，最早在下一个刻度到期，回调中重新调度自身也不会在本次推进中再次触发。
+    timer->m_expire = expire > m_now ? expire : m_now + 1;
+    timer->m_wheel = this;
+    this->link(timer);
+    ++m_count;
+}
+
+void TimerWheel::cancel(Timer *timer) {
+    if ( timer->m_wheel != this ) return;
+    this->unlink(timer);
+    timer->m_wheel = nullptr;
+    --m_count;
+}
+
+void TimerWheel::link(Timer *timer) {
+    int64_t expire = timer->m_expire;
+    int64_t delta  = expire - m_now;
+    int slot;
+    if ( delta < Slots0 ) {
+        slot = (int)(expire & (Slots0 - 1));
+    } else {
+        // 超出覆盖范围的放在最高层，下移时按实际到期时刻重新放置。
+        if ( delta >= MaxSpan ) expire = m_now + MaxSpan - 1;
+        int level = 1;
+        while ( level < Levels - 1 && delta >= ((int64_t)1 << level_shift(level + 1)) ) ++level;
+        slot = level_base(level) + (int)((expire >> level_shift(level)) & (SlotsN - 1));
+    }
+
+    Timer *head = m_slots[slot];
+    timer->m_prev = nullptr;
+    timer->m_next = head;
+    if ( head ) head->m_prev = timer;
+    m_slots[slot] = timer;
+    timer->m_slot = slot;
+    m_bitmap[slot >> 6] |= (uint64_t)1 << (slot & 63);
+}
+
+void TimerWheel::unlink(Timer *timer) {
+    int slot = timer->m_slot;
+    Timer *&head = ( slot < 0 ) ? m_firing : m_slots[slot];
+    if ( timer->m_prev ) timer->m_prev->m_next = timer->m_next;
+    else head = timer->m_next;
+    if ( timer->m_next ) timer->m_next->m_prev = timer->m_prev;
+    timer->m_prev = timer->m_next = nullptr;
+    timer->m_slot = -1;
+    if ( slot >= 0 && head == nullptr ) m_bitmap[slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+}
+
+void TimerWheel::cascade(int level, int64_t tick) {
+    int slot = level_base(level) + (int)((tick >> level_shift(level)) & (SlotsN - 1));
+    Timer *t = m_slots[slot];
+    m_slots[slot] = nullptr;
+    m_bitmap[slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+    while ( t ) {
+        Timer *next = t->m_next;
+        this->link(t);
+        t = next;
+    }
+}
+
+size_t TimerWheel::fire(int slot) {
+    // 整个槽移到到期链表后逐个回调，回调中取消到期链表里的其它定时器也是安全的。
+    m_firing = m_slots[slot];
+    m_slots[slot] = nullptr;
+    m_bitmap[slot >> 6] &= ~((uint64_t)1 << (slot & 63));
+    for ( Timer *t = m_firing; t; t = t->m_next ) t->m_slot = -1;
+
+    size_t fired = 0;
+    while ( m_firing ) {
+        Timer *t = m_firing;
+        this->unlink(t);
+        t->m_wheel = nullptr;
+        --m_count;
+        ++fired;
+        t->on_timeout();
+    }
+    return fired;
+}
+
+int TimerWheel::find_slot(int base, int nslots, int from) const {
+    // 从from开始循环查找第一个非空槽，返回与from的距离，没有时返回-1。
+    const uint64_t *words = m_bitmap + (base >> 6);
+    int nwords = nslots >> 6;
+    int w = from >> 6;
+    uint64_t bits = words[w] & (~(uint64_t)0 << (from & 63));
+    for ( int i = 0; i <= nwords; ++i ) {
+        if ( bits ) {
+            int slot = (w << 6) + __builtin_ctzll(bits);
+            return (slot - from + nslots) % nslots;
+        }
+        w = (w + 1) % nwords;
+        bits = words[w];
+    }
+    return -1;
+}
+
+int64_t TimerWheel::next_tick() const {
+    int64_t next = std::numeric_limits<int64_t>::max();
+    int d = this->find_slot(0, Slots0, (int)((m_now + 1) & (Slots0 - 1)));
+    if ( d >= 0 ) next = m_now + 1 + d;
+    for ( int level = 1; level < Levels; ++level ) {
+        int shift = level_shift(level);
+        int64_t cur = m_now >> shift;
+        d = this->find_slot(level_base(level), SlotsN, (int)((cur + 1) & (SlotsN - 1)));
+        if ( d < 0 ) continue;
+        int64_t tick = (cur + 1 + d) << shift;
+        if ( tick < next ) next = tick;
+    }
+    return next;
+}
+
+int64_t TimerWheel::next_timeout(int64_t now) const {
+    if ( m_count == 0 ) return -1;
+    int64_t wait = this->next_tick() - now;
+    return wait > 0 ? wait : 0;
+}
+
+size_t TimerWheel::advance(int64_t now) {
+    size_t fired = 0;
+    while ( m_now < now ) {
+        int64_t tick = this->next_tick();
+        if ( tick > now ) { m_now = now; break; }
+
+        // 高层先下移，下移到低层的定时器可能在同一刻度继续下移或到期。
+        m_now = tick;
+        for ( int level = Levels - 1; level >= 1; --level ) {
+            if ( (tick & (((int64_t)1 << level_shift(level)) - 1)) == 0 ) this->cascade(level, tick);
+        }
+        fired += this->fire((int)(tick & (Slots0 - 1)));
+    }
+    return fired;
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,622 @@
+#pragma once
+#include "poller.h"
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <string.h>
+#include <unordered_set>
+#include <vector>
+
+namespace mercury {
+namespace nio {
+
+/**
+ * @brief 基于io_uring的Poller，以IORING_OP_POLL_ADD实现就绪通知。
+ *
+ * 注册、修改和注销只在提交队列中排队，不发起系统调用，与下一次wait合并为
+ * 一次io_uring_enter提交，大量通道频繁修改关注事件时比epoll_ctl少得多的系统调用。
+ *
+ * 水平触发的fd使用单次poll，完成后在下一次wait前重新提交：若仍然就绪，内核在
+ * 提交时立即完成，语义与epoll水平触发一致。边沿触发的fd使用多次触发(multishot)poll。
+ *
+ * 以fd为下标保存注册信息，user_data由fd和代数(generation)组成，修改或注销时代数加一，
+ * 迟到的旧完成事件据此丢弃。
+ *
+ * 完成模式：accept_async/recv_async/send_async直接提交IORING_OP_ACCEPT/RECV/SEND，
+ * user_data为OpTag加Completion指针。accept和recv使用多次触发(multishot)，一次提交持续产生结果；
+ * recv从注册的缓存环(provided buffer ring)中由内核选取缓存，连接不需要各自预留接收缓存。
+ * 首次提交时注册稀疏的文件表(IORING_REGISTER_FILES)，fd以自身为下标经FILES_UPDATE请求放入，
+ * 之后的请求以固定文件提交，省去每次请求对fd的查找和引用计数。remove时按固定文件取消
+ * 全部未结束的请求并清空文件表中的位置，这两个请求同样只排队，与下一次wait一并提交。
+ */
+class UringPoller : public Poller {
+public:
+    const static unsigned Entries = 4096;
+    const static unsigned MaxFiles = 65536;             // 注册文件表的最大长度，另受RLIMIT_NOFILE限制
+    const static unsigned DefaultRecvBuffers = 1024;    // 默认接收缓存环的缓存数
+    const static unsigned DefaultRecvBufferSize = 4096;
+
+private:
+    const static uint64_t RemoveTag = ~(uint64_t)0;     // POLL_REMOVE等内部请求完成事件的user_data
+    const static uint64_t OpTag = (uint64_t)1 << 63;    // 完成模式请求的user_data标记
+    const static uint32_t GenMask = 0x7fffffff;         // poll的user_data中代数的位数，不与OpTag重叠
+    const static uint16_t BufferGroup = 0;
+
+    struct Slot {
+        void   * ptr;
+        uint32_t events;
+        uint32_t gen;
+        bool     active;   // 已注册
+        bool     armed;    // 内核中有未完成的poll请求
+        bool     fixed;    // 已放入注册文件表
+    };
+
+    /// wait收取的完成模式结果，complete时回调。
+    struct Done {
+        Completion * c;
+        int          res;
+        uint32_t     flags;
+    };
+
+    int                    m_ringfd;
+    void                 * m_ring;        // SQ和CQ共享的映射
+    size_t                 m_ringsz;
+    struct io_uring_sqe  * m_sqes;
+    size_t                 m_sqesz;
+
+    unsigned             * m_sq_head;
+    unsigned             * m_sq_tail;
+    unsigned             * m_sq_array;
+    unsigned               m_sq_mask;
+    unsigned               m_sq_entries;
+    unsigned               m_sq_local;    // 本地已填充的队尾
+    unsigned               m_to_submit;   // 已填充未提交的SQE数
+
+    unsigned             * m_cq_head;
+    unsigned             * m_cq_tail;
+    struct io_uring_cqe  * m_cqes;
+    unsigned               m_cq_mask;
+
+    std::vector<Slot>      m_slots;       // 以fd为下标
+    std::vector<int>       m_rearm;       // 单次poll已完成，等待重新提交的fd
+
+    std::vector<int>       m_files;       // 注册文件表的内容，以fd为下标，FILES_UPDATE提交时由内核读取
+    int                    m_nofile;      // -1，清空文件表位置时由内核读取
+    struct io_uring_buf_ring * m_bufring; // 接收缓存环
+    size_t                 m_bufringsz;
+    char                 * m_bufs;        // 接收缓存，m_bufcount个m_bufsize字节
+    unsigned               m_bufcount;
+    unsigned               m_bufsize;
+    uint16_t               m_buftail;     // 缓存环的本地队尾
+    std::vector<Done>      m_done;
+    std::unordered_set<Completion*> m_inflight;   // 内核中尚有请求的Completion，关闭时以-ECANCELED结束
+
+public:
+    UringPoller()
+        : m_ringfd(-1), m_ring(nullptr), m_ringsz(0), m_sqes(nullptr), m_sqesz(0)
+        , m_sq_head(nullptr), m_sq_tail(nullptr), m_sq_array(nullptr), m_sq_mask(0)
+        , m_sq_entries(0), m_sq_local(0), m_to_submit(0)
+        , m_cq_head(nullptr), m_cq_tail(nullptr), m_cqes(nullptr), m_cq_mask(0)
+        , m_nofile(-1), m_bufring(nullptr), m_bufringsz(0), m_bufs(nullptr)
+        , m_bufcount(0), m_bufsize(0), m_buftail(0) {}
+    virtual ~UringPoller() { RuntimeError e; this->close(e); }
+
+    virtual bool open(RuntimeError &e);
+    virtual bool close(RuntimeError &e);
+    virtual bool add(int fd, uint32_t events, void *ptr, RuntimeError &e);
+    virtual bool modify(int fd, uint32_t events, void *ptr, RuntimeError &e);
+    virtual bool remove(int fd, RuntimeError &e);
+    virtual int  wait(PollEvent *events, int n, long timeout, RuntimeError &e);
+
+    virtual bool accept_async(int fd, Completion *c, RuntimeError &e);
+    virtual bool recv_async(int fd, Completion *c, RuntimeError &e);
+    virtual bool send_async(int fd, const char *buf, size_t len, Completion *c, RuntimeError &e);
+    virtual bool recv_buffers(unsigned count, unsigned size, RuntimeError &e);
+    virtual size_t complete();
+
+private:
+    static uint64_t make_data(int fd, uint32_t gen) { return ((uint64_t)(gen & GenMask) << 32) | (uint32_t)fd; }
+
+    struct io_uring_sqe * next_sqe(RuntimeError &e);
+    bool arm(int fd, RuntimeError &e);
+    bool disarm(int fd, RuntimeError &e);
+    int  enter(unsigned submit, unsigned wait, unsigned flags, void *arg, size_t argsz);
+    int  reg(unsigned opcode, void *arg, unsigned nargs);
+    int  reap(PollEvent *events, int n);
+
+    bool setup_files(RuntimeError &e);
+    bool install(int fd, const char *where, RuntimeError &e);
+    bool uninstall(int fd, RuntimeError &e);
+    struct io_uring_sqe * prep_async(int fd, uint8_t opcode, Completion *c, const char *where, RuntimeError &e);
+    void recycle(uint16_t bid);
+    void release_buffers();
+}; // end class UringPoller
+
+inline bool UringPoller::open(RuntimeError &e) {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    p.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    p.cq_entries = Entries * 4;
+    int fd = (int)::syscall(__NR_io_uring_setup, Entries, &p);
+    if ( fd < 0 && errno == EINVAL ) {   // 旧内核不支持COOP_TASKRUN
+        memset(&p, 0, sizeof(p));
+        p.flags = IORING_SETUP_CQSIZE;
+        p.cq_entries = Entries * 4;
+        fd = (int)::syscall(__NR_io_uring_setup, Entries, &p);
+    }
+    if ( fd < 0 ) {
+        std::ostringstream oss;
+        oss<<"io_uring_setup() error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "UringPoller::open");
+        return false;
+    }
+    if ( !(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_EXT_ARG) ) {
+        ::close(fd);
+        e.set(-1, "io_uring SINGLE_MMAP/EXT_ARG not supported, linux 5.11+ required", "UringPoller::open");
+        return false;
+    }
+
+    size_t sqsz = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    size_t cqsz = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    m_ringsz = sqsz > cqsz ? sqsz : cqsz;
+    m_ring = ::mmap(nullptr, m_ringsz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if ( m_ring == MAP_FAILED ) {
+        std::ostringstream oss;
+        oss<<"mmap() io_uring ring error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "UringPoller::open");
+        m_ring = nullptr;
+        ::close(fd);
+        return false;
+    }
+    m_sqesz = p.sq_entries * sizeof(struct io_uring_sqe);
+    void * sqes = ::mmap(nullptr, m_sqesz, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if ( sqes == MAP_FAILED ) {
+        std::ostringstream oss;
+        oss<<"mmap() io_uring sqes error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "UringPoller::open");
+        ::munmap(m_ring, m_ringsz);
+        m_ring = nullptr;
+        ::close(fd);
+        return false;
+    }
+
+    char * base = (char *)m_ring;
+    m_ringfd     = fd;
+    m_sqes       = (struct io_uring_sqe *)sqes;
+    m_sq_head    = (unsigned *)(base + p.sq_off.head);
+    m_sq_tail    = (unsigned *)(base + p.sq_off.tail);
+    m_sq_array   = (unsigned *)(base + p.sq_off.array);
+    m_sq_mask    = *(unsigned *)(base + p.sq_off.ring_mask);
+    m_sq_entries = p.sq_entries;
+    m_sq_local   = *m_sq_tail;
+    m_to_submit  = 0;
+    m_cq_head    = (unsigned *)(base + p.cq_off.head);
+    m_cq_tail    = (unsigned *)(base + p.cq_off.tail);
+    m_cqes       = (struct io_uring_cqe *)(base + p.cq_off.cqes);
+    m_cq_mask    = *(unsigned *)(base + p.cq_off.ring_mask);
+    return true;
+}
+
+inline bool UringPoller::close(RuntimeError &e) {
+    if ( m_ringfd < 0 ) return true;
+    ::munmap(m_sqes, m_sqesz);
+    ::munmap(m_ring, m_ringsz);
+    m_sqes = nullptr;
+    m_ring = nullptr;
+    int r = ::close(m_ringfd);   // 关闭时内核取消全部未完成请求
+    m_ringfd = -1;
+    m_slots.clear();
+    m_rearm.clear();
+    m_files.clear();
+    m_done.clear();
+    this->release_buffers();
+
+    // 内核随io_uring关闭取消全部请求且不再产生完成事件，逐个以-ECANCELED结束，
+    // 使持有者可以释放Completion。回调中不能再提交请求。
+    std::unordered_set<Completion*> inflight;
+    inflight.swap(m_inflight);
+    for ( auto it = inflight.begin(); it != inflight.end(); ++it ) {
+        Completion * c = *it;
+        c->m_pending = 0;
+        c->m_data = nullptr;
+        c->on_complete(-ECANCELED, false);
+    }
+    if ( r == -1 ) {
+        std::ostringstream oss;
+        oss<<"close() io_uring fd error, "<<net::syserr;
+        e.set(-1, oss.str().c_str(), "UringPoller::close");
+        return false;
+    }
+    return true;
+}
+
+inline int UringPoller::enter(unsigned submit, unsigned wait, unsigned flags, void *arg, size_t argsz) {
+    int r = (int)::syscall(__NR_io_uring_enter, m_ringfd, submit, wait, flags, arg, argsz);
+    ++m_syscalls;
+    if ( r > 0 ) m_to_submit -= (unsigned)r;
+    return r;
+}
+
+inline int UringPoller::reg(unsigned opcode, void *arg, unsigned nargs) {
+    ++m_syscalls;
+    return (int)::syscall(__NR_io_uring_register, m_ringfd, opcode, arg, nargs);
+}
+
+inline struct io_uring_sqe * UringPoller::next_sqe(RuntimeError &e) {
+    unsigned head = __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE);
+    if ( m_sq_local - head >= m_sq_entries ) {
+        // 提交队列已满，先提交已填充的请求。
+        __atomic_store_n(m_sq_tail, m_sq_local, __ATOMIC_RELEASE);
+        if ( this->enter(m_to_submit, 0, 0, nullptr, 0) < 0 ) {
+            std::ostringstream oss;
+            oss<<"io_uring_enter() submit error, "<<net::syserr;
+            e.set(-1, oss.str().c_str(), "UringPoller::next_sqe");
+            return nullptr;
+        }
+        if ( m_sq_local - __atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE) >= m_sq_entries ) {
+            e.set(-1, "io_uring submission queue full", "UringPoller::next_sqe");
+            return nullptr;
+        }
+    }
+    unsigned idx = m_sq_local & m_sq_mask;
+    struct io_uring_sqe * sqe = &m_sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    m_sq_array[idx] = idx;
+    ++m_sq_local;
+    ++m_to_submit;
+    return sqe;
+}
+
+inline bool UringPoller::arm(int fd, RuntimeError &e) {
+    Slot &slot = m_slots[fd];
+    struct io_uring_sqe * sqe = this->next_sqe(e);
+    if ( sqe == nullptr ) return false;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = slot.events & ~(uint32_t)EPOLLET;
+    sqe->len = (slot.events & EPOLLET) ? IORING_POLL_ADD_MULTI : 0;
+    sqe->user_data = make_data(fd, slot.gen);
+    slot.armed = true;
+    return true;
+}
+
+inline bool UringPoller::disarm(int fd, RuntimeError &e) {
+    Slot &slot = m_slots[fd];
+    if ( slot.armed ) {
+        struct io_uring_sqe * sqe = this->next_sqe(e);
+        if ( sqe == nullptr ) return false;
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->fd = -1;
+        sqe->addr = make_data(fd, slot.gen);
+        sqe->user_data = RemoveTag;
+        slot.armed = false;
+    }
+    ++slot.gen;
+    return true;
+}
+
+inline bool UringPoller::add(int fd, uint32_t events, void *ptr, RuntimeError &e) {
+    if ( m_ringfd < 0 ) {
+        e.set(-1, "io_uring is closed", "UringPoller::add");
+        return false;
+    }
+    if ( fd < 0 ) {
+        e.set(-1, "bad file descriptor", "UringPoller::add");
+        return false;
+    }
+    if ( (size_t)fd >= m_slots.size() ) {
+        size_t n = m_slots.size() * 2;
+        if ( n <= (size_t)fd ) n = fd + 1;
+        Slot empty = { nullptr, 0, 0, false, false, false };
+        m_slots.resize(n, empty);
+    }
+    Slot &slot = m_slots[fd];
+    if ( slot.active ) {
+        std::ostringstream oss;
+        oss<<"fd already registered, fd: "<<fd;
+        e.set(-1, oss.str().c_str(), "UringPoller::add");
+        return false;
+    }
+    ++slot.gen;
+    slot.ptr = ptr;
+    slot.events = events;
+    slot.active = true;
+    return this->arm(fd, e);
+}
+
+inline bool UringPoller::modify(int fd, uint32_t events, void *ptr, RuntimeError &e) {
+    if ( fd < 0 || (size_t)fd >= m_slots.size() || !m_slots[fd].active ) {
+        std::ostringstream oss;
+        oss<<"fd not registered, fd: "<<fd;
+        e.set(-1, oss.str().c_str(), "UringPoller::modify");
+        return false;
+    }
+    if ( !this->disarm(fd, e) ) return false;
+    m_slots[fd].ptr = ptr;
+    m_slots[fd].events = events;
+    return this->arm(fd, e);
+}
+
+inline bool UringPoller::remove(int fd, RuntimeError &e) {
+    if ( fd < 0 || (size_t)fd >= m_slots.size() || !m_slots[fd].active ) return true;
+    m_slots[fd].active = false;
+    m_slots[fd].ptr = nullptr;
+    if ( !this->disarm(fd, e) ) return false;
+    return this->uninstall(fd, e);
+}
+
+inline int UringPoller::reap(PollEvent *events, int n) {
+    unsigned head = *m_cq_head;
+    unsigned tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+    int count = 0;
+    for ( ; head != tail && count < n; ++head ) {
+        const struct io_uring_cqe * cqe = &m_cqes[head & m_cq_mask];
+        uint64_t data = cqe->user_data;
+        if ( data == RemoveTag ) continue;
+        if ( data & OpTag ) {
+            Done done = { (Completion *)(uintptr_t)(data & ~OpTag), cqe->res, cqe->flags };
+            m_done.push_back(done);
+            continue;
+        }
+
+        int      fd  = (int)(uint32_t)data;
+        uint32_t gen = (uint32_t)(data >> 32);
+        if ( fd < 0 || (size_t)fd >= m_slots.size() ) continue;
+        Slot &slot = m_slots[fd];
+        if ( !slot.active || (slot.gen & GenMask) != gen ) continue;   // 已修改或注销的旧请求
+
+        if ( !(cqe->flags & IORING_CQE_F_MORE) ) {
+            slot.armed = false;
+            m_rearm.push_back(fd);
+        }
+        if ( cqe->res == -ECANCELED ) continue;
+
+        events[count].events = cqe->res < 0 ? (uint32_t)EPOLLERR : (uint32_t)cqe->res;
+        events[count].data.ptr = slot.ptr;
+        ++count;
+    }
+    __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+    return count;
+}
+
+inline int UringPoller::wait(PollEvent *events, int n, long timeout, RuntimeError &e) {
+    // 重新提交已完成的单次poll。
+    for ( size_t i = 0; i < m_rearm.size(); ++i ) {
+        int fd = m_rearm[i];
+        Slot &slot = m_slots[fd];
+        if ( slot.active && !slot.armed && !this->arm(fd, e) ) return -1;
+    }
+    m_rearm.clear();
+    __atomic_store_n(m_sq_tail, m_sq_local, __ATOMIC_RELEASE);
+
+    // 完成队列中已有事件时不等待，只提交。
+    unsigned ready = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE) - *m_cq_head;
+    int r = 0;
+    if ( ready > 0 || timeout == 0 ) {
+        if ( m_to_submit > 0 ) r = this->enter(m_to_submit, 0, 0, nullptr, 0);
+    } else if ( timeout < 0 ) {
+        r = this->enter(m_to_submit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    } else {
+        struct __kernel_timespec ts;
+        ts.tv_sec  = timeout / 1000;
+        ts.tv_nsec = (timeout % 1000) * 1000000;
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+        r = this->enter(m_to_submit, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+    }
+    if ( r < 0 && errno != ETIME && errno != EINTR && errno != EAGAIN && errno != EBUSY ) {
+        std::ostringstream oss;
+        oss<<"io_uring_enter() error, "<<net::syserr<<" ring fd: "<<m_ringfd;
+        e.set(-1, oss.str().c_str(), "UringPoller::wait");
+        return -1;
+    }
+    return this->reap(events, n);
+}
+
+inline bool UringPoller::setup_files(RuntimeError &e) {
+    // 内核要求文件表长度不超过RLIMIT_NOFILE，fd不会超出这个范围。
+    unsigned nr = MaxFiles;
+    struct rlimit lim;
+    if ( ::getrlimit(RLIMIT_NOFILE, &lim) == 0 && lim.rlim_cur < nr ) nr = (unsigned)lim.rlim_cur;
+
+    struct io_uring_rsrc_register rr;
+    memset(&rr, 0, sizeof(rr));
+    rr.nr = nr;
+    rr.flags = IORING_RSRC_REGISTER_SPARSE;
+    if ( this->reg(IORING_REGISTER_FILES2, &rr, sizeof(rr)) < 0 ) {
+        std::ostringstream oss;
+        oss<<"io_uring_register(FILES2) error, "<<net::syserr<<" nr: "<<nr<<", completion mode requires linux 6.0+";
+        e.set(-1, oss.str().c_str(), "UringPoller::setup_files");
+        return false;
+    }
+    m_files.assign(nr, -1);
+    return true;
+}
+
+inline bool UringPoller::install(int fd, const char *where, RuntimeError &e) {
+    if ( fd < 0 || (size_t)fd >= m_slots.size() || !m_slots[fd].active ) {
+        std::ostringstream oss;
+        oss<<"fd not registered, fd: "<<fd;
+        e.set(-1, oss.str().c_str(), where);
+        return false;
+    }
+    Slot &slot = m_slots[fd];
+    if ( slot.fixed ) return true;
+    if ( m_files.empty() && !this->setup_files(e) ) return false;
+    if ( (size_t)fd >= m_files.size() ) {
+        std::ostringstream oss;
+        oss<<"fd exceeds registered file table, fd: "<<fd<<", table size: "<<m_files.size();
+        e.set(-1, oss.str().c_str(), where);
+        return false;
+    }
+
+    struct io_uring_sqe * sqe = this->next_sqe(e);
+    if ( sqe == nullptr ) return false;
+    m_files[fd] = fd;
+    sqe->opcode = IORING_OP_FILES_UPDATE;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)&m_files[fd];
+    sqe->len = 1;
+    sqe->off = (uint64_t)fd;
+    sqe->user_data = RemoveTag;
+    slot.fixed = true;
+    return true;
+}
+
+inline bool UringPoller::uninstall(int fd, RuntimeError &e) {
+    Slot &slot = m_slots[fd];
+    if ( !slot.fixed ) return true;
+
+    // 先按固定文件取消全部请求，再清空文件表中的位置，释放内核对socket的引用。
+    struct io_uring_sqe * sqe = this->next_sqe(e);
+    if ( sqe == nullptr ) return false;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = fd;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_FD | IORING_ASYNC_CANCEL_FD_FIXED | IORING_ASYNC_CANCEL_ALL;
+    sqe->user_data = RemoveTag;
+
+    sqe = this->next_sqe(e);
+    if ( sqe == nullptr ) return false;
+    m_files[fd] = -1;
+    sqe->opcode = IORING_OP_FILES_UPDATE;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t)(uintptr_t)&m_nofile;
+    sqe->len = 1;
+    sqe->off = (uint64_t)fd;
+    sqe->user_data = RemoveTag;
+    slot.fixed = false;
+    return true;
+}
+
+inline struct io_uring_sqe * UringPoller::prep_async(int fd, uint8_t opcode, Completion *c, const char *where, RuntimeError &e) {
+    if ( m_ringfd < 0 ) {
+        e.set(-1, "io_uring is closed", where);
+        return nullptr;
+    }
+    if ( !this->install(fd, where, e) ) return nullptr;
+    struct io_uring_sqe * sqe = this->next_sqe(e);
+    if ( sqe == nullptr ) return nullptr;
+    sqe->opcode = opcode;
+    sqe->fd = fd;   // 文件表以fd为下标
+    sqe->flags = IOSQE_FIXED_FILE;
+    sqe->user_data = OpTag | (uint64_t)(uintptr_t)c;
+    if ( c->m_pending++ == 0 ) m_inflight.insert(c);
+    return sqe;
+}
+
+inline bool UringPoller::accept_async(int fd, Completion *c, RuntimeError &e) {
+    struct io_uring_sqe * sqe = this->prep_async(fd, IORING_OP_ACCEPT, c, "UringPoller::accept_async", e);
+    if ( sqe == nullptr ) return false;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    return true;
+}
+
+inline bool UringPoller::recv_async(int fd, Completion *c, RuntimeError &e) {
+    if ( m_bufring == nullptr && !this->recv_buffers(DefaultRecvBuffers, DefaultRecvBufferSize, e) ) return false;
+    struct io_uring_sqe * sqe = this->prep_async(fd, IORING_OP_RECV, c, "UringPoller::recv_async", e);
+    if ( sqe == nullptr ) return false;
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BufferGroup;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    return true;
+}
+
+inline bool UringPoller::send_async(int fd, const char *buf, size_t len, Completion *c, RuntimeError &e) {
+    struct io_uring_sqe * sqe = this->prep_async(fd, IORING_OP_SEND, c, "UringPoller::send_async", e);
+    if ( sqe == nullptr ) return false;
+    sqe->addr = (uint64_t)(uintptr_t)buf;
+    sqe->len = (uint32_t)len;
+    sqe->msg_flags = MSG_NOSIGNAL;
+    return true;
+}
+
+inline bool UringPoller::recv_buffers(unsigned count, unsigned size, RuntimeError &e) {
+    if ( m_bufring != nullptr ) {
+        e.set(-1, "receive buffers already registered", "UringPoller::recv_buffers");
+        return false;
+    }
+    if ( count == 0 || count > 32768 || (count & (count - 1)) != 0 || size == 0 ) {
+        std::ostringstream oss;
+        oss<<"invalid receive buffers, count must be a power of 2 not greater than 32768, count: "<<count<<", size: "<<size;
+        e.set(-1, oss.str().c_str(), "UringPoller::recv_buffers");
+        return false;
+    }
+
+    size_t ringsz = count * sizeof(struct io_uring_buf);
+    size_t bufsz = (size_t)count * size;
+    void * ring = ::mmap(nullptr, ringsz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    void * bufs = ring == MAP_FAILED ? MAP_FAILED
+                : ::mmap(nullptr, bufsz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ( bufs == MAP_FAILED ) {
+        std::ostringstream oss;
+        oss<<"mmap() receive buffers error, "<<net::syserr<<" count: "<<count<<", size: "<<size;
+        e.set(-1, oss.str().c_str(), "UringPoller::recv_buffers");
+        if ( ring != MAP_FAILED ) ::munmap(ring, ringsz);
+        return false;
+    }
+    m_bufring   = (struct io_uring_buf_ring *)ring;
+    m_bufringsz = ringsz;
+    m_bufs      = (char *)bufs;
+    m_bufcount  = count;
+    m_bufsize   = size;
+    m_buftail   = 0;
+
+    struct io_uring_buf_reg br;
+    memset(&br, 0, sizeof(br));
+    br.ring_addr = (uint64_t)(uintptr_t)ring;
+    br.ring_entries = count;
+    br.bgid = BufferGroup;
+    if ( this->reg(IORING_REGISTER_PBUF_RING, &br, 1) < 0 ) {
+        std::ostringstream oss;
+        oss<<"io_uring_register(PBUF_RING) error, "<<net::syserr<<" count: "<<count<<", completion mode requires linux 6.0+";
+        e.set(-1, oss.str().c_str(), "UringPoller::recv_buffers");
+        this->release_buffers();
+        return false;
+    }
+    for ( unsigned i = 0; i < count; ++i ) this->recycle((uint16_t)i);
+    return true;
+}
+
+inline void UringPoller::recycle(uint16_t bid) {
+    // 不能使用m_bufring->bufs：内核头文件的柔性数组在C++中前置一个空结构，偏移为8而不是0。
+    struct io_uring_buf * buf = (struct io_uring_buf *)m_bufring + (m_buftail & (m_bufcount - 1));
+    buf->addr = (uint64_t)(uintptr_t)(m_bufs + (size_t)bid * m_bufsize);
+    buf->len  = m_bufsize;
+    buf->bid  = bid;
+    ++m_buftail;
+    __atomic_store_n(&m_bufring->tail, m_buftail, __ATOMIC_RELEASE);
+}
+
+inline void UringPoller::release_buffers() {
+    // 缓存环注册后须在io_uring关闭之后释放，注册失败时可直接释放。
+    if ( m_bufs ) ::munmap(m_bufs, (size_t)m_bufcount * m_bufsize);
+    if ( m_bufring ) ::munmap(m_bufring, m_bufringsz);
+    m_bufs = nullptr;
+    m_bufring = nullptr;
+    m_bufcount = m_bufsize = 0;
+}
+
+inline size_t UringPoller::complete() {
+    // 回调中可能提交新的请求，但不会收取完成事件，m_done在遍历期间不变。
+    size_t n = m_done.size();
+    for ( size_t i = 0; i < n; ++i ) {
+        const Done done = m_done[i];
+        Completion * c = done.c;
+        bool more = (done.flags & IORING_CQE_F_MORE) != 0;
+        if ( !more && --c->m_pending == 0 ) m_inflight.erase(c);
+        bool hasbuf = (done.flags & IORING_CQE_F_BUFFER) != 0;
+        uint16_t bid = (uint16_t)(done.flags >> IORING_CQE_BUFFER_SHIFT);
+        c->m_data = hasbuf ? m_bufs + (size_t)bid * m_bufsize : nullptr;
+        c->on_complete(done.res, more);   // 回调后c可能已被释放
+        if ( hasbuf ) this->recycle(bid);
+    }
+    m_done.clear();
+    return n;
+}
+
+}} // end namespace mercury::nio
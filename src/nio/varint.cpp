@@ -0,0 +1,108 @@
+#include "varint.h"
+#include <mercury/nio/buffer.h>
+#include <string.h>
+
+namespace mercury {
+namespace nio {
+
+size_t varint_encode(char *p, uint64_t value) {
+    if ( value < 0x80 ) {
+        p[0] = (char)value;
+        return 1;
+    }
+    size_t n = 0;
+    while ( value >= 0x80 ) {
+        p[n++] = (char)(value | 0x80);
+        value >>= 7;
+    }
+    p[n++] = (char)value;
+    return n;
+}
+
+/// 逐字节解码，用于缓存尾部不足8字节或编码超过8字节的情况。
+static size_t varint_decode_slow(const unsigned char *p, size_t avail, uint64_t *value) {
+    uint64_t result = 0;
+    size_t limit = avail < MaxVarintBytes ? avail : MaxVarintBytes;
+    for ( size_t i = 0; i < limit; ++i ) {
+        uint64_t b = p[i];
+        if ( i == MaxVarintBytes - 1 && b > 1 ) return 0;   // 超出64位
+        result |= (b & 0x7f) << (7 * i);
+        if ( b < 0x80 ) {
+            *value = result;
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+size_t varint_decode(const char *src, size_t avail, uint64_t *value) {
+    const unsigned char *p = (const unsigned char *)src;
+    if ( avail > 0 && p[0] < 0x80 ) {
+        *value = p[0];
+        return 1;
+    }
+    if ( avail < 8 ) return varint_decode_slow(p, avail, value);
+
+    // 一次读入8字节，最低位字节在前。结束字节是第一个最高位为0的字节。
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    if ( ByteOrder::NativeEndian == ByteOrder::BigEndian ) word = __builtin_bswap64(word);
+    uint64_t stops = ~word & 0x8080808080808080ULL;
+    if ( stops == 0 ) return varint_decode_slow(p, avail, value);
+    size_t len = (__builtin_ctzll(stops) >> 3) + 1;
+
+    // 截去结束字节之后的内容和各字节的延续位，再把7位一组逐级合并
+    uint64_t x = word & (0x7f7f7f7f7f7f7f7fULL >> (64 - 8 * len));
+    x = ((x & 0x7f007f007f007f00ULL) >> 1) | (x & 0x007f007f007f007fULL);
+    x = ((x & 0x3fff00003fff0000ULL) >> 2) | (x & 0x00003fff00003fffULL);
+    x = ((x & 0x0fffffff00000000ULL) >> 4) | (x & 0x000000000fffffffULL);
+    *value = x;
+    return len;
+}
+
+size_t varint_encode_n(char *p, size_t avail, const uint64_t *array, size_t n, size_t *used) {
+    size_t pos = 0, i = 0;
+    // 剩余空间足够容纳最长编码时不必逐个计算编码长度
+    for ( ; i < n && avail - pos >= MaxVarintBytes; ++i ) pos += varint_encode(p + pos, array[i]);
+    for ( ; i < n && avail - pos >= varint_size(array[i]); ++i ) pos += varint_encode(p + pos, array[i]);
+    *used = pos;
+    return i;
+}
+
+size_t svarint_encode_n(char *p, size_t avail, const int64_t *array, size_t n, size_t *used) {
+    size_t pos = 0, i = 0;
+    for ( ; i < n && avail - pos >= MaxVarintBytes; ++i ) pos += varint_encode(p + pos, zigzag_encode(array[i]));
+    for ( ; i < n; ++i ) {
+        uint64_t v = zigzag_encode(array[i]);
+        if ( avail - pos < varint_size(v) ) break;
+        pos += varint_encode(p + pos, v);
+    }
+    *used = pos;
+    return i;
+}
+
+size_t varint_decode_n(const char *p, size_t avail, uint64_t *array, size_t n, size_t *used) {
+    size_t pos = 0, i = 0;
+    for ( ; i < n; ++i ) {
+        size_t len = varint_decode(p + pos, avail - pos, array + i);
+        if ( len == 0 ) break;
+        pos += len;
+    }
+    *used = pos;
+    return i;
+}
+
+size_t svarint_decode_n(const char *p, size_t avail, int64_t *array, size_t n, size_t *used) {
+    size_t pos = 0, i = 0;
+    for ( ; i < n; ++i ) {
+        uint64_t v;
+        size_t len = varint_decode(p + pos, avail - pos, &v);
+        if ( len == 0 ) break;
+        array[i] = zigzag_decode(v);
+        pos += len;
+    }
+    *used = pos;
+    return i;
+}
+
+}} // end namespace mercury::nio
@@ -0,0 +1,44 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace mercury {
+namespace nio {
+
+/// 64位无符号LEB128编码的最大字节数。
+const size_t MaxVarintBytes = 10;
+
+/// value的LEB128编码字节数。
+inline size_t varint_size(uint64_t value) {
+    // 有效位数按每字节7位向上取整，value为0时仍占1字节
+    size_t bits = 64 - __builtin_clzll(value | 1);
+    return (bits + 6) / 7;
+}
+
+inline uint64_t zigzag_encode(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+inline int64_t  zigzag_decode(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+/// 把value编码写入p，p至少有varint_size(value)字节空间，返回写入的字节数。
+size_t varint_encode(char *p, uint64_t value);
+
+/**
+ * @brief 从p开始的avail字节中解码一个varint。
+ * @return 编码的字节数，数据不完整或编码超过10字节、超出64位时返回0。
+ */
+size_t varint_decode(const char *p, size_t avail, uint64_t *value);
+
+/**
+ * @brief 批量编码，在p开始的avail字节中依次写入array的元素，直到全部写入或空间不足。
+ * @return 写入的元素数，写入的字节数存入*used。
+ */
+size_t varint_encode_n(char *p, size_t avail, const uint64_t *array, size_t n, size_t *used);
+size_t svarint_encode_n(char *p, size_t avail, const int64_t *array, size_t n, size_t *used);
+
+/**
+ * @brief 批量解码，直到解出n个元素或剩余数据不能构成完整编码。
+ * @return 解出的元素数，消耗的字节数存入*used。
+ */
+size_t varint_decode_n(const char *p, size_t avail, uint64_t *array, size_t n, size_t *used);
+size_t svarint_decode_n(const char *p, size_t avail, int64_t *array, size_t n, size_t *used);
+
+}} // end namespace mercury::nio
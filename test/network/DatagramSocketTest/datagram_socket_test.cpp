@@ -0,0 +1,128 @@
+#include <mercury/net/network.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <string.h>
+
+#include <iostream>
+
+using namespace mercury;
+using namespace mercury::net;
+using namespace std;
+
+class DatagramSocketTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE( DatagramSocketTest );
+    CPPUNIT_TEST( testBatch );
+    CPPUNIT_TEST( testSegmentOffload );
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    DatagramSocket m_sender;
+    DatagramSocket m_receiver;
+
+public:
+    void setUp () {
+        RuntimeError e;
+        CPPUNIT_ASSERT( m_sender.create(AF_INET, e) );
+        CPPUNIT_ASSERT( m_sender.bind("127.0.0.1", 0, e) );
+        CPPUNIT_ASSERT( m_receiver.create(AF_INET, e) );
+        CPPUNIT_ASSERT( m_receiver.bind("127.0.0.1", 0, e) );
+    }
+
+    void tearDown() {
+        RuntimeError e;
+        CPPUNIT_ASSERT( m_sender.close(e) );
+        CPPUNIT_ASSERT( m_receiver.close(e) );
+    }
+
+    // 批量发送到同一地址，批量接收后各报文长度、内容和来源地址正确
+    void testBatch() {
+        RuntimeError e;
+        const size_t N = 10;
+        Inet4Address loopback("127.0.0.1", e);
+        InetSocketAddress dest(loopback, m_receiver.local_port(e));
+
+        char sendbuf[N][16];
+        DatagramPacket out[N];
+        for ( size_t i = 0; i < N; ++i ) {
+            int len = snprintf(sendbuf[i], sizeof(sendbuf[i]), "packet-%d", (int)i);
+            out[i] = DatagramPacket(sendbuf[i], len, &dest);
+        }
+        CPPUNIT_ASSERT( m_sender.send_batch(out, N, e) == (ssize_t)N );
+
+        char recvbuf[16][32];
+        InetSocketAddress from[16];
+        DatagramPacket in[16];
+        for ( size_t i = 0; i < 16; ++i ) {
+            from[i].assign(dest.caddr(), dest.caddrsize());
+            in[i] = DatagramPacket(recvbuf[i], 0, sizeof(recvbuf[i]), &from[i]);
+        }
+
+        size_t total = 0;
+        while ( total < N ) {
+            ssize_t r = m_receiver.receive_batch(in + total, 16 - total, e);
+            CPPUNIT_ASSERT( r > 0 );
+            total += r;
+        }
+        CPPUNIT_ASSERT( total == N );
+        for ( size_t i = 0; i < N; ++i ) {
+            CPPUNIT_ASSERT( in[i].length() == out[i].length() );
+            CPPUNIT_ASSERT( memcmp(recvbuf[i], sendbuf[i], in[i].length()) == 0 );
+            CPPUNIT_ASSERT( from[i].port() == m_sender.local_port(e) );
+            CPPUNIT_ASSERT( from[i].address()->is_loopback() );
+        }
+        CPPUNIT_ASSERT( in[N].length() == 0 );
+    }
+
+    // 一个大缓存按分段长度由内核切分发送，开启GRO的接收端得到合并报文时按分段长度切分
+    void testSegmentOffload() {
+        RuntimeError e;
+        const size_t SEG = 100, TOTAL = 1050;
+        CPPUNIT_ASSERT( m_receiver.set_udp_gro(1, e) );
+        CPPUNIT_ASSERT( m_receiver.get_udp_gro(e) == 1 );
+
+        Inet4Address loopback("127.0.0.1", e);
+        InetSocketAddress dest(loopback, m_receiver.local_port(e));
+        char sendbuf[TOTAL];
+        for ( size_t i = 0; i < TOTAL; ++i ) sendbuf[i] = (char)(i / SEG);
+        DatagramPacket out(sendbuf, TOTAL, &dest);
+        out.setSegmentSize(SEG);
+        ssize_t r = m_sender.send(out, e);
+        if ( r < 0 ) {
+            cout<<"UDP GSO not supported, skipped: "<<e.message()<<endl;
+            return;
+        }
+        CPPUNIT_ASSERT( r == (ssize_t)TOTAL );
+
+        // 逐个报文按分段长度切分，依次拼接后应与发送的缓存一致
+        char recvbuf[65536];
+        size_t received = 0, segments = 0;
+        while ( received < TOTAL ) {
+            DatagramPacket in(recvbuf, 0, sizeof(recvbuf));
+            CPPUNIT_ASSERT( m_receiver.receive(&in, e) > 0 );
+            size_t segsize = in.segmentSize() ? in.segmentSize() : in.length();
+            CPPUNIT_ASSERT( segsize == SEG || received + in.length() == TOTAL );
+            for ( size_t off = 0; off < in.length(); off += segsize ) {
+                size_t len = in.length() - off < segsize ? in.length() - off : segsize;
+                CPPUNIT_ASSERT( memcmp(in.buffer() + off, sendbuf + received, len) == 0 );
+                received += len;
+                ++segments;
+            }
+        }
+        CPPUNIT_ASSERT( received == TOTAL );
+        CPPUNIT_ASSERT( segments == (TOTAL + SEG - 1) / SEG );
+    }
+}; // end class DatagramSocketTest
+
+CPPUNIT_TEST_SUITE_REGISTRATION( DatagramSocketTest );
+
+int main(int argc, char **argv)
+{
+    CppUnit::TextUi::TestRunner runner;
+    CppUnit::Test *suite = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+    runner.addTest(suite);
+    runner.run();
+    return 0;
+}
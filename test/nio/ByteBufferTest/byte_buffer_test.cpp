@@ -0,0 +1,809 @@
+#include <mercury/nio/buffer.h>
+#include <mercury/nio/buffer_cursor.h>
+#include <mercury/nio/composite_buffer.h>
+#include <mercury/nio/frame_codec.h>
+#include <mercury/nio/mapped_buffer.h>
+#include <mercury/nio/ring_buffer.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace mercury;
+using namespace mercury::nio;
+using namespace std;
+
+class ByteBufferTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE( ByteBufferTest );
+    CPPUNIT_TEST( testSizeClass );
+    CPPUNIT_TEST( testAllocate );
+    CPPUNIT_TEST( testReuse );
+    CPPUNIT_TEST( testCopyShares );
+    CPPUNIT_TEST( testCrossThreadRelease );
+    CPPUNIT_TEST( testSlice );
+    CPPUNIT_TEST( testDuplicateReadOnly );
+    CPPUNIT_TEST( testViewOutlivesOwner );
+    CPPUNIT_TEST( testComposite );
+    CPPUNIT_TEST( testCompositeIovecs );
+    CPPUNIT_TEST( testByteOrder );
+    CPPUNIT_TEST( testStaticOrder );
+    CPPUNIT_TEST( testBulkArrays );
+    CPPUNIT_TEST( testVarint );
+    CPPUNIT_TEST( testVarintBatch );
+    CPPUNIT_TEST( testMappedRead );
+    CPPUNIT_TEST( testMappedSlide );
+    CPPUNIT_TEST( testMappedWrite );
+    CPPUNIT_TEST( testCompact );
+    CPPUNIT_TEST( testRing );
+    CPPUNIT_TEST( testUncheckedCursor );
+    CPPUNIT_TEST( testCheckedCursor );
+    CPPUNIT_TEST( testFrameCodec );
+    CPPUNIT_TEST( testFrameDecoderHeld );
+    CPPUNIT_TEST( testFrameErrors );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp () {}
+    void tearDown() {}
+
+    void testSizeClass() {
+        CPPUNIT_ASSERT( BufferPool::size_class(0) == 0 );
+        CPPUNIT_ASSERT( BufferPool::size_class(64) == 0 );
+        CPPUNIT_ASSERT( BufferPool::size_class(65) == 1 );
+        CPPUNIT_ASSERT( BufferPool::size_class(4096) == 6 );
+        CPPUNIT_ASSERT( BufferPool::class_size(BufferPool::size_class(4097)) == 8192 );
+        CPPUNIT_ASSERT( BufferPool::size_class(1 << 20) == BufferPool::Classes - 1 );
+        CPPUNIT_ASSERT( BufferPool::size_class((1 << 20) + 1) == BufferPool::LargeClass );
+    }
+
+    void testAllocate() {
+        ByteBuffer buf = ByteBuffer::allocate(100);
+        CPPUNIT_ASSERT( buf.is_pooled() );
+        CPPUNIT_ASSERT( buf.capacity() == 100 && buf.limit() == 100 && buf.position() == 0 );
+        CPPUNIT_ASSERT( ((uintptr_t)buf.ptr(0) & 15) == 0 );
+        buf.put_int32(7);
+        buf.put("abc", 3);
+        buf.flip();
+        CPPUNIT_ASSERT( buf.get_int32() == 7 );
+        char s[3];
+        CPPUNIT_ASSERT( buf.get(s, 3) == 3 && memcmp(s, "abc", 3) == 0 );
+
+        // 超过最大尺寸类直接分配
+        ByteBuffer large = ByteBuffer::allocate((1 << 20) + 1);
+        CPPUNIT_ASSERT( large.capacity() == (1 << 20) + 1 );
+        large.put((1 << 20), 'x');
+        CPPUNIT_ASSERT( large.get(1 << 20) == 'x' );
+
+        ByteBuffer raw(s, sizeof(s));
+        CPPUNIT_ASSERT( !raw.is_pooled() );
+    }
+
+    // 同一线程释放后再分配同一尺寸类，重用刚释放的内存，不再向系统分配
+    void testReuse() {
+        const char *first;
+        {
+            ByteBuffer buf = ByteBuffer::allocate(1000);
+            first = buf.ptr(0);
+        }
+        BufferPool::Stats before = BufferPool::stats();
+        for ( int i = 0; i < 1000; ++i ) {
+            ByteBuffer buf = ByteBuffer::allocate(600 + i % 400);
+            CPPUNIT_ASSERT( buf.ptr(0) == first );
+        }
+        BufferPool::Stats after = BufferPool::stats();
+        CPPUNIT_ASSERT( after.system_allocs == before.system_allocs );
+    }
+
+    // 复制和移动共享同一块内存，最后一个引用析构时才归还
+    void testCopyShares() {
+        ByteBuffer a = ByteBuffer::allocate(64);
+        a.put_int64(42);
+        ByteBuffer b(a);
+        CPPUNIT_ASSERT( b.ptr(0) == a.ptr(0) && b.position() == 8 );
+        b.flip();
+        CPPUNIT_ASSERT( b.get_int64() == 42 );
+        CPPUNIT_ASSERT( a.position() == 8 );
+
+        ByteBuffer c = std::move(a);
+        CPPUNIT_ASSERT( !a.is_pooled() && a.capacity() == 0 );
+        CPPUNIT_ASSERT( c.ptr(0) == b.ptr(0) );
+
+        const char *p = c.ptr(0);
+        b = ByteBuffer();
+        CPPUNIT_ASSERT( c.get_int64(0) == 42 );
+        c = ByteBuffer();
+        ByteBuffer d = ByteBuffer::allocate(64);
+        CPPUNIT_ASSERT( d.ptr(0) == p );
+    }
+
+    // 在其它线程释放的块经由全局仓库回到分配方
+    void testCrossThreadRelease() {
+        const size_t N = 200, Size = 3000;
+        vector<ByteBuffer> bufs;
+        set<const char *> addrs;
+        for ( size_t i = 0; i < N; ++i ) {
+            bufs.push_back(ByteBuffer::allocate(Size));
+            addrs.insert(bufs.back().ptr(0));
+        }
+
+        thread releaser([&bufs]() { bufs.clear(); });
+        releaser.join();
+
+        BufferPool::Stats before = BufferPool::stats();
+        size_t reused = 0;
+        for ( size_t i = 0; i < N; ++i ) {
+            bufs.push_back(ByteBuffer::allocate(Size));
+            if ( addrs.count(bufs.back().ptr(0)) ) ++reused;
+        }
+        BufferPool::Stats after = BufferPool::stats();
+        CPPUNIT_ASSERT( reused == N );
+        CPPUNIT_ASSERT( after.system_allocs == before.system_allocs );
+    }
+
+    // 切片共享内存，各自的position和limit互不影响
+    void testSlice() {
+        ByteBuffer buf = ByteBuffer::allocate(64);
+        buf.put_int32(4);
+        buf.put("body", 4);
+        buf.put_int32(99);
+        buf.flip();
+        CPPUNIT_ASSERT( buf.get_int32() == 4 );
+
+        ByteBuffer body = buf.slice();
+        CPPUNIT_ASSERT( body.position() == 0 && body.capacity() == 8 && body.limit() == 8 );
+        CPPUNIT_ASSERT( body.ptr(0) == buf.ptr() );
+        CPPUNIT_ASSERT( buf.position() == 4 );
+
+        ByteBuffer name = buf.slice(4, 4);
+        CPPUNIT_ASSERT( name.remaining() == 4 && memcmp(name.ptr(), "body", 4) == 0 );
+        name.put(0, 'B');
+        CPPUNIT_ASSERT( buf.get(4) == 'B' );
+
+        body.position(4);
+        CPPUNIT_ASSERT( body.get_int32() == 99 );
+        CPPUNIT_ASSERT( buf.position() == 4 );
+
+        // 包装外部内存的缓存同样可以切片
+        char raw[8] = "abcdefg";
+        ByteBuffer ext(raw, sizeof(raw));
+        ByteBuffer tail = ext.slice(5, 3);
+        CPPUNIT_ASSERT( !tail.is_pooled() && tail.get() == 'f' );
+    }
+
+    void testDuplicateReadOnly() {
+        ByteBuffer buf = ByteBuffer::allocate(16);
+        buf.put_int64(1234);
+        ByteBuffer dup = buf.duplicate();
+        CPPUNIT_ASSERT( dup.position() == 8 && dup.ptr(0) == buf.ptr(0) );
+        dup.flip();
+        CPPUNIT_ASSERT( dup.get_int64() == 1234 && buf.position() == 8 );
+
+        ByteBuffer ro = buf.as_read_only();
+        CPPUNIT_ASSERT( ro.is_read_only() && !buf.is_read_only() );
+        CPPUNIT_ASSERT( ro.get_int64(0) == 1234 );
+        buf.put_int64(0, 5678);
+        CPPUNIT_ASSERT( ro.get_int64(0) == 5678 );
+        CPPUNIT_ASSERT( ro.slice(0, 8).is_read_only() );
+        CPPUNIT_ASSERT( ro.duplicate().is_read_only() );
+    }
+
+    // 视图交给其它线程，原缓存先析构，最后一个视图析构时内存才归还
+    void testViewOutlivesOwner() {
+        ByteBuffer payload;
+        const char *p;
+        {
+            ByteBuffer frame = ByteBuffer::allocate(200);
+            p = frame.ptr(0);
+            frame.put_int32(5);
+            frame.put("hello", 5);
+            frame.flip();
+            frame.get_int32();
+            payload = frame.slice().as_read_only();
+        }
+        ByteBuffer other = ByteBuffer::allocate(200);
+        CPPUNIT_ASSERT( other.ptr(0) != p );
+
+        bool ok = false;
+        thread consumer([&ok](ByteBuffer view) {
+            char s[5];
+            ok = view.get(s, 5) == 5 && memcmp(s, "hello", 5) == 0;
+        }, std::move(payload));
+        consumer.join();
+        CPPUNIT_ASSERT( ok );
+        CPPUNIT_ASSERT( !payload.is_pooled() );
+    }
+
+    // 类型化读写跨越分段边界，字节序按组合缓存设置
+    void testComposite() {
+        char b1[3], b2[1], b3[20];
+        ByteBuffer s1(b1, sizeof(b1)), s2(b2, sizeof(b2)), s3(b3, sizeof(b3));
+        CompositeByteBuffer buf(ByteOrder(ByteOrder::BigEndian));
+        buf.append(s2);
+        buf.append(s3);
+        buf.prepend(s1);
+        CPPUNIT_ASSERT( buf.segments() == 3 );
+        CPPUNIT_ASSERT( buf.capacity() == 24 && buf.limit() == 24 && buf.position() == 0 );
+
+        buf.put_int16(0x0102);
+        buf.put_int32(0x03040506);
+        buf.put_int64(0x0708090a0b0c0d0eLL);
+        buf.put_double(2.5);
+        CPPUNIT_ASSERT( buf.remaining() == 2 );
+        CPPUNIT_ASSERT( b1[0] == 1 && b1[1] == 2 && b1[2] == 3 && b2[0] == 4 && b3[0] == 5 );
+
+        buf.flip();
+        CPPUNIT_ASSERT( buf.get_int16() == 0x0102 );
+        CPPUNIT_ASSERT( buf.get_int32() == 0x03040506 );
+        CPPUNIT_ASSERT( buf.get_int64() == 0x0708090a0b0c0d0eLL );
+        CPPUNIT_ASSERT( buf.get_double() == 2.5 );
+        CPPUNIT_ASSERT( buf.get_int32(1) == 0x02030405 );
+        CPPUNIT_ASSERT( buf.get(3) == 4 );
+
+        char out[6];
+        CPPUNIT_ASSERT( buf.get(1, out, sizeof(out)) == 6 );
+        CPPUNIT_ASSERT( memcmp(out, "\x02\x03\x04\x05\x06\x07", 6) == 0 );
+        buf.put(2, 'z');
+        CPPUNIT_ASSERT( b1[2] == 'z' );
+
+        buf.remove_all();
+        CPPUNIT_ASSERT( buf.segments() == 0 && buf.capacity() == 0 );
+    }
+
+    // 在消息体前后加入消息头和尾，导出的iovec直接指向各分段内存
+    void testCompositeIovecs() {
+        ByteBuffer body = ByteBuffer::allocate(32);
+        body.put("payload", 7);
+        body.flip();
+        ByteBuffer head = ByteBuffer::allocate(4);
+        head.put_int32(7);
+        head.flip();
+        char tailbuf[2] = { '\r', '\n' };
+        ByteBuffer tail(tailbuf, sizeof(tailbuf));
+
+        CompositeByteBuffer msg;
+        msg.append(body);
+        msg.prepend(head);
+        msg.append(tail);
+        msg.append(ByteBuffer());
+        CPPUNIT_ASSERT( msg.segments() == 3 && msg.remaining() == 13 );
+
+        struct iovec iov[4];
+        CPPUNIT_ASSERT( msg.iovecs(iov, 4) == 3 );
+        CPPUNIT_ASSERT( iov[0].iov_base == head.ptr(0) && iov[0].iov_len == 4 );
+        CPPUNIT_ASSERT( iov[1].iov_base == body.ptr(0) && iov[1].iov_len == 7 );
+        CPPUNIT_ASSERT( iov[2].iov_base == tailbuf && iov[2].iov_len == 2 );
+
+        // 部分写出后从position所在分段的中间开始
+        msg.position(6);
+        msg.limit(12);
+        CPPUNIT_ASSERT( msg.iovecs(iov, 4) == 2 );
+        CPPUNIT_ASSERT( iov[0].iov_base == body.ptr(2) && iov[0].iov_len == 5 );
+        CPPUNIT_ASSERT( iov[1].iov_base == tailbuf && iov[1].iov_len == 1 );
+        CPPUNIT_ASSERT( msg.iovecs(iov, 1) == 1 );
+    }
+
+    void testByteOrder() {
+        ByteOrder big(ByteOrder::BigEndian), little(ByteOrder::LittleEndian);
+        CPPUNIT_ASSERT( big.need_swap() != little.need_swap() );
+        CPPUNIT_ASSERT( !ByteOrder::native_order().need_swap() );
+        CPPUNIT_ASSERT( ByteOrder::swap((int16_t)0x0102) == 0x0201 );
+        CPPUNIT_ASSERT( ByteOrder::swap((int32_t)0x01020304) == 0x04030201 );
+        CPPUNIT_ASSERT( ByteOrder::swap((int64_t)0x0102030405060708LL) == 0x0807060504030201LL );
+        CPPUNIT_ASSERT( ByteOrder::swap(ByteOrder::swap(1.25)) == 1.25 );
+        CPPUNIT_ASSERT( ByteOrder::swap(ByteOrder::swap(-3.5f)) == -3.5f );
+
+        // 写入位置不对齐
+        char mem[32];
+        ByteBuffer buf(mem, sizeof(mem), big);
+        buf.put('x');
+        buf.put_int32(0x01020304);
+        buf.put_double(0.5);
+        CPPUNIT_ASSERT( memcmp(mem + 1, "\x01\x02\x03\x04", 4) == 0 );
+        buf.flip();
+        CPPUNIT_ASSERT( buf.get() == 'x' );
+        CPPUNIT_ASSERT( buf.get_int32() == 0x01020304 );
+        CPPUNIT_ASSERT( buf.get_double() == 0.5 );
+        buf.order(little);
+        CPPUNIT_ASSERT( buf.get_int32(1) == 0x04030201 );
+    }
+
+    // 编译期字节序与运行时字节序的结果一致
+    void testStaticOrder() {
+        char m1[64], m2[64];
+        ByteBuffer b1(m1, sizeof(m1), ByteOrder(ByteOrder::BigEndian));
+        ByteBuffer b2(m2, sizeof(m2));
+        b1.put_int16(-2);
+        b1.put_int32(0x7f000001);
+        b1.put_int64(-0x0102030405060708LL);
+        b1.put_float(1.5f);
+        b1.put_double(-2.75);
+        b2.put_int16<BigEndianOrder>(-2);
+        b2.put_int32<BigEndianOrder>(0x7f000001);
+        b2.put_int64<BigEndianOrder>(-0x0102030405060708LL);
+        b2.put_float<BigEndianOrder>(1.5f);
+        b2.put_double<BigEndianOrder>(-2.75);
+        CPPUNIT_ASSERT( b1.position() == 26 && b2.position() == 26 );
+        CPPUNIT_ASSERT( memcmp(m1, m2, 26) == 0 );
+
+        b2.flip();
+        CPPUNIT_ASSERT( b2.get_int16<BigEndianOrder>() == -2 );
+        CPPUNIT_ASSERT( b2.get_int32<BigEndianOrder>() == 0x7f000001 );
+        CPPUNIT_ASSERT( b2.get_int64<BigEndianOrder>() == -0x0102030405060708LL );
+        CPPUNIT_ASSERT( b2.get_float<BigEndianOrder>() == 1.5f );
+        CPPUNIT_ASSERT( b2.get_double<BigEndianOrder>() == -2.75 );
+        CPPUNIT_ASSERT( b2.remaining() == 0 );
+
+        b2.put_int32<LittleEndianOrder>(2, 0x01020304);
+        CPPUNIT_ASSERT( memcmp(m2 + 2, "\x04\x03\x02\x01", 4) == 0 );
+        CPPUNIT_ASSERT( b2.get_int32<LittleEndianOrder>(2) == 0x01020304 );
+        CPPUNIT_ASSERT( !NativeOrder::Swap && BigEndianOrder::Swap != LittleEndianOrder::Swap );
+
+        // 同一位置先后以不同类型读写，后一次读取须看到另一类型的写入
+        ByteBuffer b3(m2, sizeof(m2));
+        int64_t before = b3.get_int64<NativeOrder>(0);
+        b3.put_double<NativeOrder>(0, 1.0);
+        int64_t after = b3.get_int64<NativeOrder>(0);
+        CPPUNIT_ASSERT( before != after && after == 0x3ff0000000000000LL );
+        b3.put_int32<NativeOrder>(8, 0);
+        b3.put_float<NativeOrder>(8, 1.0f);
+        CPPUNIT_ASSERT( b3.get_int32<NativeOrder>(8) == 0x3f800000 );
+        b3.put_int64<BigEndianOrder>(16, 0);
+        b3.put_int16<BigEndianOrder>(16, 0x0102);
+        CPPUNIT_ASSERT( b3.get_int64<BigEndianOrder>(16) == 0x0102000000000000LL );
+    }
+
+    // 批量读写与逐个读写的结果一致，覆盖SIMD分组之后的尾部和不对齐的起始位置
+    void testBulkArrays() {
+        int16_t i16[70], o16[70];
+        int32_t i32[70], o32[70];
+        int64_t i64[70], o64[70];
+        double  f64[70], d64[70];
+        for ( int i = 0; i < 70; ++i ) {
+            i16[i] = (int16_t)(i * 0x0101 + 1);
+            i32[i] = i * 0x01020304 + 7;
+            i64[i] = i * 0x0102030405060708LL - 3;
+            f64[i] = i * 1.5 - 20;
+        }
+        const size_t cap = 2 + 70 * (2 + 4 + 8 + 8);
+        vector<char> m1(cap), m2(cap);
+        for ( int order = ByteOrder::LittleEndian; order <= ByteOrder::BigEndian; ++order ) {
+            for ( size_t n = 0; n <= 70; n += (n < 20 ? 1 : 7) ) {
+                ByteBuffer b1(m1.data(), cap, ByteOrder(order));
+                ByteBuffer b2(m2.data(), cap, ByteOrder(order));
+                b1.put('x');
+                b2.put('x');
+                for ( size_t i = 0; i < n; ++i ) b1.put_int16(i16[i]);
+                for ( size_t i = 0; i < n; ++i ) b1.put_int32(i32[i]);
+                for ( size_t i = 0; i < n; ++i ) b1.put_int64(i64[i]);
+                for ( size_t i = 0; i < n; ++i ) b1.put_double(f64[i]);
+                b2.put_int16s(i16, n);
+                b2.put_int32s(i32, n);
+                b2.put_int64s(i64, n);
+                b2.put_doubles(f64, n);
+                CPPUNIT_ASSERT( b1.position() == b2.position() );
+                CPPUNIT_ASSERT( memcmp(m1.data(), m2.data(), b1.position()) == 0 );
+
+                b2.flip();
+                b2.get();
+                b2.get_int16s(o16, n);
+                b2.get_int32s(o32, n);
+                b2.get_int64s(o64, n);
+                b2.get_doubles(d64, n);
+                CPPUNIT_ASSERT( b2.remaining() == 0 );
+                CPPUNIT_ASSERT( memcmp(o16, i16, n * 2) == 0 && memcmp(o32, i32, n * 4) == 0 );
+                CPPUNIT_ASSERT( memcmp(o64, i64, n * 8) == 0 && memcmp(d64, f64, n * 8) == 0 );
+            }
+        }
+
+        char mem[64];
+        float fin[3] = { 1.0f, -2.5f, 3.25f }, fout[3];
+        ByteBuffer buf(mem, sizeof(mem), ByteOrder(ByteOrder::BigEndian));
+        buf.put_floats(5, fin, 3);
+        CPPUNIT_ASSERT( buf.position() == 0 && buf.get_float(9) == -2.5f );
+        buf.get_floats(5, fout, 3);
+        CPPUNIT_ASSERT( memcmp(fin, fout, sizeof(fin)) == 0 );
+        CPPUNIT_ASSERT( strlen(ByteOrder::swap_kernel()) > 0 );
+    }
+
+    void testVarint() {
+        char mem[32];
+        ByteBuffer buf(mem, sizeof(mem));
+        buf.put_varint(300);
+        buf.put_svarint(-1);
+        buf.put_svarint(1);
+        CPPUNIT_ASSERT( buf.position() == 4 );
+        CPPUNIT_ASSERT( memcmp(mem, "\xac\x02\x01\x02", 4) == 0 );
+
+        // 各长度边界上的值，分别放在缓存中间和末尾，覆盖8字节读取和逐字节解码
+        vector<uint64_t> values(1, 0);
+        for ( int bits = 7; bits <= 63; bits += 7 ) {
+            values.push_back(((uint64_t)1 << bits) - 1);
+            values.push_back((uint64_t)1 << bits);
+        }
+        values.push_back(~(uint64_t)0);
+        for ( size_t i = 0; i < values.size(); ++i ) {
+            uint64_t v = values[i];
+            size_t size = ByteBuffer::varint_size(v);
+            CPPUNIT_ASSERT( size >= 1 && size <= 10 );
+            for ( size_t tail = 0; tail <= 12; tail += 12 ) {
+                buf.clear();
+                buf.limit(size + tail);
+                buf.put_varint(v);
+                CPPUNIT_ASSERT( buf.position() == size );
+                buf.rewind();
+                uint64_t out = 0;
+                CPPUNIT_ASSERT( buf.get_varint(out) && out == v && buf.position() == size );
+
+                buf.rewind();
+                buf.limit(size - 1);
+                CPPUNIT_ASSERT( !buf.get_varint(out) && buf.position() == 0 );
+            }
+        }
+
+        const int64_t svalues[] = { 0, -1, 63, -64, 64, -65, INT64_MAX, INT64_MIN };
+        for ( size_t i = 0; i < sizeof(svalues) / sizeof(svalues[0]); ++i ) {
+            buf.clear();
+            buf.put_svarint(svalues[i]);
+            buf.flip();
+            int64_t out = 0;
+            CPPUNIT_ASSERT( buf.get_svarint(out) && out == svalues[i] );
+        }
+        CPPUNIT_ASSERT( ByteBuffer::varint_size(63 << 1) == 1 );
+
+        // 超过10字节或第10字节超出64位的编码
+        memset(mem, 0x80, sizeof(mem));
+        buf.clear();
+        uint64_t out;
+        CPPUNIT_ASSERT( !buf.get_varint(out) && buf.position() == 0 );
+        mem[9] = 0x02;
+        CPPUNIT_ASSERT( !buf.get_varint(out) );
+        mem[9] = 0x01;
+        CPPUNIT_ASSERT( buf.get_varint(out) && out == (uint64_t)1 << 63 );
+    }
+
+    void testVarintBatch() {
+        vector<uint64_t> in(1000), out(1000);
+        vector<int64_t> sin(1000), sout(1000);
+        size_t total = 0;
+        for ( size_t i = 0; i < in.size(); ++i ) {
+            in[i] = (uint64_t)i * i * i * i * i * i * 31 >> (i % 50);
+            sin[i] = (i & 1) ? -(int64_t)(in[i] >> 1) : (int64_t)(in[i] >> 1);
+            total += ByteBuffer::varint_size(in[i]);
+        }
+
+        ByteBuffer buf = ByteBuffer::allocate(total);
+        CPPUNIT_ASSERT( buf.put_varints(in.data(), in.size()) == in.size() );
+        CPPUNIT_ASSERT( buf.remaining() == 0 );
+        CPPUNIT_ASSERT( buf.put_varints(in.data(), 1) == 0 );
+        buf.flip();
+        CPPUNIT_ASSERT( buf.get_varints(out.data(), out.size() + 1) == out.size() );
+        CPPUNIT_ASSERT( out == in );
+
+        // 空间不足时停在最后一个能完整写入的元素
+        ByteBuffer small = ByteBuffer::allocate(total / 2);
+        size_t n = small.put_svarints(sin.data(), sin.size());
+        CPPUNIT_ASSERT( n > 0 && n < sin.size() );
+        small.flip();
+        CPPUNIT_ASSERT( small.get_svarints(sout.data(), sout.size()) == n );
+        CPPUNIT_ASSERT( equal(sin.begin(), sin.begin() + n, sout.begin()) );
+        CPPUNIT_ASSERT( small.remaining() == 0 );
+    }
+
+    /// 创建临时文件，内容为count个大端int32，第i个值为i。
+    static string make_int_file(size_t count) {
+        char path[] = "/tmp/mapped_buffer_test.XXXXXX";
+        int fd = mkstemp(path);
+        CPPUNIT_ASSERT( fd >= 0 );
+        vector<char> data(count * 4);
+        ByteBuffer buf(data.data(), data.size(), ByteOrder(ByteOrder::BigEndian));
+        for ( size_t i = 0; i < count; ++i ) buf.put_int32((int32_t)i);
+        CPPUNIT_ASSERT( write(fd, data.data(), data.size()) == (ssize_t)data.size() );
+        close(fd);
+        return path;
+    }
+
+    void testMappedRead() {
+        RuntimeError e;
+        MappedByteBuffer buf;
+        CPPUNIT_ASSERT( !buf.open("/tmp/no/such/mapped/file", MappedByteBuffer::ReadOnly, e) && e );
+        e.clear();
+
+        const size_t count = 3000;
+        string path = make_int_file(count);
+        CPPUNIT_ASSERT( buf.open(path.c_str(), MappedByteBuffer::ReadOnly, e) );
+        CPPUNIT_ASSERT( buf.file_size() == count * 4 && buf.capacity() == 0 );
+        CPPUNIT_ASSERT( buf.advise(MappedByteBuffer::AccessSequential, e) );
+        CPPUNIT_ASSERT( buf.map(0, 0, MappedByteBuffer::MapPopulate, e) );
+        CPPUNIT_ASSERT( buf.capacity() == count * 4 && buf.remaining() == count * 4 );
+        CPPUNIT_ASSERT( buf.is_read_only() );
+        buf.order(ByteOrder(ByteOrder::BigEndian));
+        for ( size_t i = 0; i < count; ++i ) CPPUNIT_ASSERT( buf.get_int32() == (int32_t)i );
+
+        // 窗口起始位置不按页对齐
+        CPPUNIT_ASSERT( buf.map(4100, 400, MappedByteBuffer::MapHugePages, e) );
+        CPPUNIT_ASSERT( buf.offset() == 4100 && buf.capacity() == 400 );
+        CPPUNIT_ASSERT( ((uintptr_t)buf.ptr(0) - 4100) % MappedByteBuffer::HugePageSize == 0 );
+        CPPUNIT_ASSERT( buf.get_int32<BigEndianOrder>(0) == 1025 );
+        CPPUNIT_ASSERT( buf.advise(MappedByteBuffer::AccessWillNeed, e) );
+
+        // 超出文件末尾的部分被截去
+        CPPUNIT_ASSERT( buf.map(count * 4 - 8, 100, 0, e) );
+        CPPUNIT_ASSERT( buf.capacity() == 8 );
+        CPPUNIT_ASSERT( buf.map(count * 4 + 100, 100, 0, e) );
+        CPPUNIT_ASSERT( buf.capacity() == 0 && buf.offset() == count * 4 );
+
+        CPPUNIT_ASSERT( buf.close(e) && !buf.is_open() );
+        unlink(path.c_str());
+    }
+
+    // 以小窗口分段解析，记录跨越窗口边界时由slide把未处理的数据移到新窗口开头
+    void testMappedSlide() {
+        RuntimeError e;
+        const size_t count = 10000;
+        string path = make_int_file(count);
+        MappedByteBuffer buf;
+        CPPUNIT_ASSERT( buf.open(path.c_str(), MappedByteBuffer::ReadOnly, e) );
+        CPPUNIT_ASSERT( buf.map(2, 4099, 0, e) );
+        buf.order(ByteOrder(ByteOrder::BigEndian));
+        buf.get();
+        buf.get();
+        size_t next = 1, slides = 0;
+        while ( buf.offset() + buf.position() < buf.file_size() ) {
+            if ( buf.remaining() < 4 ) {
+                CPPUNIT_ASSERT( buf.slide(e) );
+                CPPUNIT_ASSERT( buf.position() == 0 && buf.remaining() >= 4 );
+                ++slides;
+            }
+            CPPUNIT_ASSERT( buf.get_int32() == (int32_t)next++ );
+        }
+        CPPUNIT_ASSERT( next == count && slides == count * 4 / 4096 );
+        unlink(path.c_str());
+    }
+
+    void testMappedWrite() {
+        RuntimeError e;
+        string path = make_int_file(2048);
+        {
+            MappedByteBuffer buf;
+            CPPUNIT_ASSERT( buf.open(path.c_str(), MappedByteBuffer::ReadWrite, e) );
+            CPPUNIT_ASSERT( buf.map(4096, 8, 0, e) && !buf.is_read_only() );
+            buf.put_int64<BigEndianOrder>(0x0102030405060708LL);
+            CPPUNIT_ASSERT( buf.sync(e) );
+        }
+        MappedByteBuffer buf;
+        CPPUNIT_ASSERT( buf.open(path.c_str(), MappedByteBuffer::ReadOnly, e) );
+        CPPUNIT_ASSERT( buf.map(0, 0, 0, e) );
+        CPPUNIT_ASSERT( buf.get_int64<BigEndianOrder>(4096) == 0x0102030405060708LL );
+        CPPUNIT_ASSERT( buf.get_int32<BigEndianOrder>(4092) == 1023 );
+        CPPUNIT_ASSERT( buf.get_int32<BigEndianOrder>(4104) == 1026 );
+        unlink(path.c_str());
+    }
+
+    void testCompact() {
+        char mem[16];
+        ByteBuffer buf(mem, sizeof(mem));
+        buf.put("0123456789", 10);
+        buf.flip();
+        buf.get();
+        buf.get();
+        buf.get();
+        buf.mark();
+        buf.compact();
+        CPPUNIT_ASSERT( buf.position() == 7 && buf.limit() == 16 );
+        CPPUNIT_ASSERT( memcmp(mem, "3456789", 7) == 0 );
+        buf.put("ab", 2);
+        buf.flip();
+        CPPUNIT_ASSERT( buf.remaining() == 9 );
+
+        // 全部读完时compact等同于clear
+        char out[9];
+        buf.get(out, 9);
+        buf.compact();
+        CPPUNIT_ASSERT( buf.position() == 0 && buf.limit() == 16 );
+    }
+
+    // 可读数据跨越环末尾时，读取指针之后仍是连续内存
+    void testRing() {
+        RuntimeError e;
+        RingByteBuffer ring;
+        CPPUNIT_ASSERT( ring.open(100, e) );
+        size_t cap = ring.capacity();
+        CPPUNIT_ASSERT( cap >= 100 && cap % 4096 == 0 );
+        CPPUNIT_ASSERT( ring.writable() == cap && ring.readable() == 0 );
+
+        ring.commit(cap - 6);
+        ring.consume(cap - 6);
+        ByteBuffer out = ring.write_buffer(ByteOrder(ByteOrder::BigEndian));
+        CPPUNIT_ASSERT( out.capacity() == cap );
+        out.put_int32(0x01020304);
+        out.put_int64(-5);
+        out.put("tail", 4);
+        ring.commit(out.position());
+        CPPUNIT_ASSERT( ring.readable() == 16 && ring.writable() == cap - 16 );
+        CPPUNIT_ASSERT( ring.write_ptr() == ring.read_ptr() + 16 - cap );
+
+        ByteBuffer in = ring.read_buffer(ByteOrder(ByteOrder::BigEndian));
+        CPPUNIT_ASSERT( in.is_read_only() && in.remaining() == 16 );
+        CPPUNIT_ASSERT( in.get_int32() == 0x01020304 );
+        CPPUNIT_ASSERT( in.get_int64() == -5 );
+        ring.consume(in.position());
+        CPPUNIT_ASSERT( ring.readable() == 4 && memcmp(ring.read_ptr(), "tail", 4) == 0 );
+        CPPUNIT_ASSERT( ring.read_ptr() < ring.write_ptr() );
+
+        ring.clear();
+        CPPUNIT_ASSERT( ring.readable() == 0 && ring.writable() == cap );
+        CPPUNIT_ASSERT( ring.close(e) && !ring.is_open() );
+    }
+
+    void testUncheckedCursor() {
+        char mem[64];
+        ByteBuffer buf(mem, sizeof(mem), ByteOrder(ByteOrder::BigEndian));
+        buf.put('h');
+        {
+            ByteBufferCursor<UncheckedAccess, BigEndianOrder> cur(buf);
+            CPPUNIT_ASSERT( cur.ensure(2 + 4 + 8 + 4 + 8 + 3) );
+            cur.put_int16(-2);
+            cur.put_int32(0x01020304);
+            cur.put_int64(1LL << 40);
+            cur.put_float(0.5f);
+            cur.put_double(-8.25);
+            cur.put("end", 3);
+            CPPUNIT_ASSERT( cur.position() == 30 && buf.position() == 1 );
+            CPPUNIT_ASSERT( !cur.ensure(64) && cur.ok() );
+        }
+        CPPUNIT_ASSERT( buf.position() == 30 );
+
+        // 与运行时字节序的读取结果一致
+        buf.flip();
+        CPPUNIT_ASSERT( buf.get() == 'h' && buf.get_int16() == -2 && buf.get_int32() == 0x01020304 );
+        buf.rewind();
+        UncheckedCursor raw(buf);
+        raw.skip(3);
+        CPPUNIT_ASSERT( raw.get_int32() == ByteOrder::swap((int32_t)0x01020304) );
+        raw.commit();
+        CPPUNIT_ASSERT( buf.position() == 7 );
+    }
+
+    void testCheckedCursor() {
+        char mem[10];
+        ByteBuffer buf(mem, sizeof(mem));
+        buf.put_int64(42);
+        buf.put_int16(7);
+        buf.flip();
+
+        RuntimeError e;
+        {
+            CheckedCursor cur(buf, e);
+            CPPUNIT_ASSERT( cur.get_int64() == 42 && cur.ok() && !e );
+            CPPUNIT_ASSERT( cur.get_int32() == 0 );
+            CPPUNIT_ASSERT( !cur.ok() && e );
+            CPPUNIT_ASSERT( strstr(e.message(), "need: 4, remaining: 2") != nullptr );
+            // 失败后不再读取，错误保持第一次的内容
+            CPPUNIT_ASSERT( cur.get() == 0 && !cur.get(mem, 1) );
+            CPPUNIT_ASSERT( strstr(e.message(), "need: 4") != nullptr );
+            CPPUNIT_ASSERT( cur.remaining() == 2 );
+        }
+        CPPUNIT_ASSERT( buf.position() == 8 );
+
+        e.clear();
+        buf.clear();
+        CheckedCursor out(buf, e);
+        CPPUNIT_ASSERT( !out.ensure(11) && e );
+        CPPUNIT_ASSERT( out.position() == 0 );
+
+        // 写只读缓存记录错误，不修改数据，读取不受影响
+        e.clear();
+        ByteBuffer view = buf.as_read_only();
+        CheckedCursor ro(view, e);
+        CPPUNIT_ASSERT( ro.get_int64() == 42 && ro.ok() && !e );
+        ro.put_int16(1);
+        CPPUNIT_ASSERT( !ro.ok() && e );
+        CPPUNIT_ASSERT( strstr(e.message(), "read only") != nullptr );
+        CPPUNIT_ASSERT( !ro.put("x", 1) && ro.position() == 8 );
+        CPPUNIT_ASSERT( buf.get_int16(8) == 7 );
+    }
+
+    /// 把组合缓存的剩余数据复制为字符串。
+    static string gather(CompositeByteBuffer &buf) {
+        string data(buf.remaining(), 0);
+        buf.get(buf.position(), &data[0], data.size());
+        return data;
+    }
+
+    // 编码后按不同的分块方式交给解码器，解出的帧与原负载一致
+    void testFrameCodec() {
+        vector<string> payloads;
+        for ( size_t i = 0; i < 40; ++i ) payloads.push_back(string(i * 3 % 100, (char)('a' + i % 26)));
+        payloads.push_back(string(1000, 'L'));
+        payloads.push_back(string());
+
+        const size_t widths[] = { 2, 4, 8 };
+        for ( size_t w = 0; w < 3; ++w ) {
+            for ( int order = ByteOrder::LittleEndian; order <= ByteOrder::BigEndian; ++order ) {
+                RuntimeError e;
+                FrameEncoder enc(widths[w], ByteOrder(order));
+                vector<ByteBuffer> held;
+                for ( size_t i = 0; i < payloads.size(); ++i ) {
+                    ByteBuffer p = ByteBuffer::allocate(payloads[i].size());
+                    if ( !payloads[i].empty() ) p.put(payloads[i].data(), payloads[i].size());
+                    p.flip();
+                    CPPUNIT_ASSERT( enc.encode(p, e) );
+                    held.push_back(p);
+                }
+                CompositeByteBuffer &out = enc.output();
+                // 小帧合并在暂存区中，只有大负载单独成段且不复制
+                CPPUNIT_ASSERT( out.segments() == 3 );
+                CPPUNIT_ASSERT( out.segment(1).ptr(0) == held[40].ptr(0) );
+                string stream = gather(out);
+                CPPUNIT_ASSERT( enc.pending() == stream.size() );
+
+                for ( size_t chunk = 1; chunk <= stream.size(); chunk = chunk * 3 + 1 ) {
+                    FrameDecoder dec(widths[w], ByteOrder(order), 1 << 20, 256);
+                    vector<ByteBuffer> frames;
+                    for ( size_t off = 0; off < stream.size(); off += chunk ) {
+                        dec.append(stream.data() + off, min(chunk, stream.size() - off));
+                        dec.next_all(frames, e);
+                    }
+                    CPPUNIT_ASSERT( !e && dec.buffered() == 0 );
+                    CPPUNIT_ASSERT( frames.size() == payloads.size() );
+                    for ( size_t i = 0; i < frames.size(); ++i ) {
+                        CPPUNIT_ASSERT( frames[i].is_read_only() && frames[i].remaining() == payloads[i].size() );
+                        CPPUNIT_ASSERT( payloads[i].empty() || memcmp(frames[i].ptr(0), payloads[i].data(), payloads[i].size()) == 0 );
+                    }
+                }
+            }
+        }
+    }
+
+    // 使用方持有的帧在解码器继续接收数据后保持不变
+    void testFrameDecoderHeld() {
+        RuntimeError e;
+        FrameDecoder dec(1, ByteOrder(), 1024, 64);
+        ByteBuffer first;
+        dec.append("\x03" "abc" "\x05" "de", 7);
+        CPPUNIT_ASSERT( dec.next(first, e) && first.remaining() == 3 );
+        CPPUNIT_ASSERT( first.is_pooled() );
+        ByteBuffer second;
+        CPPUNIT_ASSERT( !dec.next(second, e) && !e && dec.buffered() == 3 );
+        for ( int i = 0; i < 20; ++i ) dec.append("fghij" "\x04" "wxyz", 10);
+        CPPUNIT_ASSERT( memcmp(first.ptr(0), "abc", 3) == 0 );
+        CPPUNIT_ASSERT( dec.next(second, e) && memcmp(second.ptr(0), "defgh", 5) == 0 );
+        CPPUNIT_ASSERT( memcmp(first.ptr(0), "abc", 3) == 0 );
+    }
+
+    void testFrameErrors() {
+        RuntimeError e;
+        FrameDecoder dec(4, ByteOrder(ByteOrder::BigEndian), 100);
+        dec.append("\x00\x00\x01\x00", 4);
+        ByteBuffer frame;
+        CPPUNIT_ASSERT( !dec.next(frame, e) && e );
+        CPPUNIT_ASSERT( strstr(e.message(), "frame too long") != nullptr );
+
+        e.clear();
+        FrameEncoder enc(1);
+        ByteBuffer big = ByteBuffer::allocate(256);
+        CPPUNIT_ASSERT( !enc.encode(big, e) && e );
+        CPPUNIT_ASSERT( enc.pending() == 0 );
+    }
+}; // end class ByteBufferTest
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ByteBufferTest );
+
+int main(int argc, char **argv)
+{
+    CppUnit::TextUi::TestRunner runner;
+    CppUnit::Test *suite = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+    runner.addTest(suite);
+    runner.run();
+    return 0;
+}
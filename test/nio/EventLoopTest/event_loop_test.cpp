@@ -0,0 +1,97 @@
+#include <mercury/nio/event_loop.h>
+#include <mercury/net/network.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+using namespace mercury;
+using namespace mercury::nio;
+using namespace std;
+
+class CountingHandler : public EventHandler {
+public:
+    atomic<int> accepted;
+    atomic<int> errors;
+
+    CountingHandler() : accepted(0), errors(0) {}
+
+    void on_accept(EventLoop &, StreamSocketChannel *ch) override {
+        ++accepted;
+        delete ch;
+    }
+    void on_select(EventLoop &, SelectionKey *) override {}
+    void on_accept_error(EventLoop &, const RuntimeError &) override { ++errors; }
+}; // end class CountingHandler
+
+class EventLoopTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE( EventLoopTest );
+    CPPUNIT_TEST( testAcceptBackoff );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {}
+    void tearDown() {}
+
+    // 文件描述符耗尽时accept4以EMFILE失败，EventLoop报告错误并暂停接受，而不是反复就绪空转
+    void testAcceptBackoff() {
+        RuntimeError e;
+        CountingHandler handler;
+        EventLoop loop(0, &handler);
+        CPPUNIT_ASSERT( loop.open(Selector::EngineEpoll, AF_INET, "127.0.0.1", 0, 128, e) );
+        int port = loop.listen_port();
+
+        const int nclients = 3;
+        net::StreamSocket clients[nclients];
+        for ( int i = 0; i < nclients; ++i ) CPPUNIT_ASSERT( clients[i].create(AF_INET, e) );
+
+        // 把上限设为最小的空闲描述符，之后无法再创建新的描述符
+        struct rlimit old, lim;
+        CPPUNIT_ASSERT( getrlimit(RLIMIT_NOFILE, &old) == 0 );
+        int lowest = dup(0);
+        CPPUNIT_ASSERT( lowest >= 0 );
+        close(lowest);
+        CPPUNIT_ASSERT( loop.start(e) );
+        this_thread::sleep_for(chrono::milliseconds(20));
+        lim = old;
+        lim.rlim_cur = lowest;
+        CPPUNIT_ASSERT( setrlimit(RLIMIT_NOFILE, &lim) == 0 );
+
+        for ( int i = 0; i < nclients; ++i ) CPPUNIT_ASSERT( clients[i].connect("127.0.0.1", port, e) );
+        this_thread::sleep_for(chrono::milliseconds(350));
+        int errors = handler.errors.load();
+        CPPUNIT_ASSERT( setrlimit(RLIMIT_NOFILE, &old) == 0 );
+
+        CPPUNIT_ASSERT( errors >= 1 && errors <= 6 );
+        CPPUNIT_ASSERT( handler.accepted == 0 );
+
+        // 恢复上限后，下一次重新关注OpAccept时接受全部等待的连接
+        for ( int retry = 0; handler.accepted < nclients && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( handler.accepted == nclients );
+
+        loop.stop();
+        loop.join();
+        CPPUNIT_ASSERT( loop.close(e) );
+    }
+}; // end class EventLoopTest
+
+CPPUNIT_TEST_SUITE_REGISTRATION( EventLoopTest );
+
+int main(int argc, char **argv)
+{
+    CppUnit::TextUi::TestRunner runner;
+    CppUnit::Test *suite = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+    runner.addTest(suite);
+    runner.run();
+    return 0;
+}
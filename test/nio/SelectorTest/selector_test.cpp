@@ -0,0 +1,992 @@
+#include <mercury/nio/channel.h>
+#include <mercury/nio/frame_codec.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+using namespace mercury;
+using namespace mercury::nio;
+using namespace std;
+
+class SelectorTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE( SelectorTest );
+    CPPUNIT_TEST( testOpenClose );
+    CPPUNIT_TEST( testAccept );
+    CPPUNIT_TEST( testAcceptBatch );
+    CPPUNIT_TEST( testUnreg );
+    CPPUNIT_TEST( testEdgeTriggered );
+    CPPUNIT_TEST( testEdgeTriggeredPeerClose );
+    CPPUNIT_TEST( testWakeup );
+    CPPUNIT_TEST( testScatterGather );
+    CPPUNIT_TEST( testSendToClosedPeer );
+    CPPUNIT_TEST( testZeroCopy );
+    CPPUNIT_TEST( testTransferFrom );
+    CPPUNIT_TEST( testConnect );
+    CPPUNIT_TEST( testDeadline );
+    CPPUNIT_TEST( testTimer );
+    CPPUNIT_TEST( testSubmit );
+    CPPUNIT_TEST( testCrossThreadInterest );
+    CPPUNIT_TEST( testInterestBeforeSelect );
+    CPPUNIT_TEST( testChannelReadWrite );
+    CPPUNIT_TEST( testDatagramChannel );
+    CPPUNIT_TEST( testFrameCodec );
+    CPPUNIT_TEST_SUITE_END();
+
+protected:
+    ServerSocketChannel m_server;
+    Selector            m_selector;
+    int                 m_port;
+
+public:
+    virtual int engine() const { return Selector::EngineEpoll; }
+
+    void setUp () {
+        RuntimeError e;
+        CPPUNIT_ASSERT( m_server.create(AF_INET, e) );
+        CPPUNIT_ASSERT( m_server.bind("127.0.0.1", 0, e) );
+        CPPUNIT_ASSERT( m_server.listen(SOMAXCONN, e) );
+        m_port = m_server.socket()->local_port(e);
+        CPPUNIT_ASSERT( m_port > 0 );
+        CPPUNIT_ASSERT( m_selector.open(this->engine(), e) );
+        CPPUNIT_ASSERT( m_selector.engine() == this->engine() );
+    }
+
+    void tearDown() {
+        RuntimeError e;
+        CPPUNIT_ASSERT( m_selector.close(e) );
+        CPPUNIT_ASSERT( m_server.close(e) );
+    }
+
+    void testOpenClose() {
+        RuntimeError e;
+        Selector selector;
+        CPPUNIT_ASSERT( !selector.is_open() );
+        CPPUNIT_ASSERT( selector.open(this->engine(), e) );
+        CPPUNIT_ASSERT( selector.is_open() );
+        CPPUNIT_ASSERT( selector.select(0, e) == 0 );
+        CPPUNIT_ASSERT( selector.close(e) );
+        CPPUNIT_ASSERT( !selector.is_open() );
+    }
+
+    // 注册监听通道，客户端连接后select返回可接受的键
+    void testAccept() {
+        RuntimeError e;
+        SelectionKey *key = m_server.reg(&m_selector, SelectionKey::OpAccept, &m_port, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        CPPUNIT_ASSERT( key->is_valid() );
+        CPPUNIT_ASSERT( key->attachment() == &m_port );
+        CPPUNIT_ASSERT( m_server.key_for(&m_selector) == key );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        vector<SelectionKey*> keys;
+        CPPUNIT_ASSERT( m_selector.selected_keys(keys) == 1 );
+        CPPUNIT_ASSERT( keys[0] == key );
+        CPPUNIT_ASSERT( key->is_acceptable() );
+        CPPUNIT_ASSERT( !key->is_readable() );
+
+        net::StreamSocket sock;
+        CPPUNIT_ASSERT( m_server.accept(sock, e) );
+        CPPUNIT_ASSERT( sock.get_block_mode() == 0 );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+    }
+
+    // 一次就绪后批量接受全部等待的连接，队列为空时返回0且不设置错误
+    void testAcceptBatch() {
+        RuntimeError e;
+        SelectionKey *key = m_server.reg(&m_selector, SelectionKey::OpAccept, e);
+        CPPUNIT_ASSERT( key != nullptr );
+
+        const size_t N = 5;
+        net::StreamSocket clients[N];
+        for ( size_t i = 0; i < N; ++i ) {
+            CPPUNIT_ASSERT( clients[i].create(AF_INET, e) );
+            CPPUNIT_ASSERT( clients[i].connect("127.0.0.1", m_port, e) );
+        }
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+
+        StreamSocketChannel chs[8];
+        StreamSocketChannel *pchs[8];
+        for ( size_t i = 0; i < 8; ++i ) pchs[i] = &chs[i];
+
+        size_t total = 0;
+        for ( int retry = 0; total < N && retry < 100; ++retry ) {
+            ssize_t n = m_server.accept_batch(pchs + total, 8 - total, e);
+            CPPUNIT_ASSERT( n >= 0 );
+            total += n;
+            if ( total < N ) this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( total == N );
+        for ( size_t i = 0; i < N; ++i ) {
+            CPPUNIT_ASSERT( !chs[i].is_closed() );
+            CPPUNIT_ASSERT( chs[i].socket()->get_block_mode() == 0 );
+        }
+        CPPUNIT_ASSERT( chs[N].is_closed() );
+
+        e.clear();
+        CPPUNIT_ASSERT( m_server.accept_batch(pchs + N, 8 - N, e) == 0 );
+        CPPUNIT_ASSERT( e.code() == 0 );
+    }
+
+    // 注销后的键不再被选中，通道可重新注册
+    void testUnreg() {
+        RuntimeError e;
+        CPPUNIT_ASSERT( m_server.reg(&m_selector, SelectionKey::OpRead, e) == nullptr );
+        CPPUNIT_ASSERT( e.code() != 0 );
+
+        e.clear();
+        SelectionKey *key = m_server.reg(&m_selector, SelectionKey::OpAccept, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        CPPUNIT_ASSERT( m_selector.unreg(key, e) );
+        CPPUNIT_ASSERT( !key->is_valid() );
+        CPPUNIT_ASSERT( !m_server.is_registered() );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        CPPUNIT_ASSERT( m_selector.select(100, e) == 0 );
+
+        key = m_server.reg(&m_selector, SelectionKey::OpAccept, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        vector<SelectionKey*> keys;
+        CPPUNIT_ASSERT( m_selector.keys(keys) == 1 );
+    }
+
+    // 边沿触发时未处理的事件不会被重复选中，收发循环直到EAGAIN
+    void testEdgeTriggered() {
+        RuntimeError e;
+        SelectionKey *key = m_server.reg(&m_selector, SelectionKey::OpAccept, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        key->edge_triggered(true);
+        CPPUNIT_ASSERT( key->edge_triggered() );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+
+        net::StreamSocket sock;
+        CPPUNIT_ASSERT( m_server.accept(sock, e) );
+        CPPUNIT_ASSERT( client.set_block_mode(false, e) );
+
+        const size_t n = 256 * 1024;
+        std::vector<char> out(n, 'x'), in(n);
+        size_t sent = 0, received = 0;
+        while ( received < n ) {
+            if ( sent < n ) {
+                ssize_t r = client.send_all(out.data() + sent, n - sent, e);
+                CPPUNIT_ASSERT( r >= 0 );
+                sent += r;
+            }
+            size_t got = 0;
+            ssize_t r = sock.receive_all(in.data() + received, n - received, &got, e);
+            CPPUNIT_ASSERT( r >= 0 && (size_t)r == got );
+            received += got;
+        }
+        CPPUNIT_ASSERT( in == out );
+
+        size_t got = 0;
+        CPPUNIT_ASSERT( sock.receive_all(in.data(), n, &got, e) == 0 );
+        CPPUNIT_ASSERT( client.close(e) );
+        CPPUNIT_ASSERT( sock.receive_all(in.data(), n, &got, e) == -1 );
+    }
+
+    // 数据和FIN同时到达时边沿触发只通知一次，receive_all须读到0才能发现对端关闭
+    void testEdgeTriggeredPeerClose() {
+        RuntimeError e;
+        StreamSocketChannel client, server;
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        for ( int retry = 0; !m_server.accept(server, e) && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( !server.is_closed() );
+        while ( client.finish_connect(e) == 0 ) this_thread::sleep_for(chrono::milliseconds(1));
+
+        const char msg[] = "last words";
+        CPPUNIT_ASSERT( client.socket()->send_all(msg, sizeof(msg), e) == (ssize_t)sizeof(msg) );
+        CPPUNIT_ASSERT( client.close(e) );
+        this_thread::sleep_for(chrono::milliseconds(20));
+
+        SelectionKey *key = server.reg(&m_selector, SelectionKey::OpRead, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        key->edge_triggered(true);
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( key->is_readable() );
+
+        char buf[4096];
+        size_t got = 0;
+        CPPUNIT_ASSERT( server.socket()->receive_all(buf, sizeof(buf), &got, e) == -1 );
+        CPPUNIT_ASSERT( got == sizeof(msg) && memcmp(buf, msg, sizeof(msg)) == 0 );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+    }
+
+    // 跨线程唤醒阻塞的select，未消费的唤醒被合并
+    void testWakeup() {
+        RuntimeError e;
+        std::thread waker([this]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            m_selector.wakeup();
+        });
+        CPPUNIT_ASSERT( m_selector.select(e) == 0 );
+        waker.join();
+        CPPUNIT_ASSERT( m_selector.wakeup_coalesced() == 0 );
+
+        m_selector.wakeup();
+        m_selector.wakeup();
+        m_selector.wakeup();
+        CPPUNIT_ASSERT( m_selector.wakeup_coalesced() == 2 );
+
+        auto t0 = std::chrono::steady_clock::now();
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 0 );
+        CPPUNIT_ASSERT( std::chrono::steady_clock::now() - t0 < std::chrono::milliseconds(500) );
+
+        // 唤醒已被消费，下一次select按超时返回
+        t0 = std::chrono::steady_clock::now();
+        CPPUNIT_ASSERT( m_selector.select(50, e) == 0 );
+        CPPUNIT_ASSERT( std::chrono::steady_clock::now() - t0 >= std::chrono::milliseconds(40) );
+    }
+
+    // 消息头和消息体分两段缓存，一次writev写出，readv读入后各缓存position前移
+    void testScatterGather() {
+        RuntimeError e;
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        StreamSocketChannel ch;
+        for ( int retry = 0; !m_server.accept(ch, e) && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( !ch.is_closed() );
+
+        char hdrbuf[4], bodybuf[16];
+        ByteBuffer hdr(hdrbuf, sizeof(hdrbuf)), body(bodybuf, sizeof(bodybuf)), empty;
+        hdr.put_int32(11);
+        hdr.flip();
+        body.put("hello world", 11);
+        body.flip();
+        ByteBuffer *out[] = { &hdr, &empty, &body };
+        CPPUNIT_ASSERT( ch.write(out, 3, e) == 15 );
+        CPPUNIT_ASSERT( hdr.remaining() == 0 && body.remaining() == 0 );
+
+        // 客户端分散读取，每次重试从上次读到的位置继续
+        char wire1[2], wire2[32];
+        struct iovec iov[2] = { { wire1, sizeof(wire1) }, { wire2, sizeof(wire2) } };
+        size_t total = 0;
+        for ( int retry = 0; total < 15 && retry < 100; ++retry ) {
+            int first = total < sizeof(wire1) ? 0 : 1;
+            size_t skip = total - (first == 0 ? 0 : sizeof(wire1));
+            struct iovec rest[2] = { iov[0], iov[1] };
+            rest[first].iov_base = (char *)rest[first].iov_base + skip;
+            rest[first].iov_len -= skip;
+            ssize_t r = client.receivev(rest + first, 2 - first, e);
+            CPPUNIT_ASSERT( r > 0 );
+            total += r;
+        }
+        CPPUNIT_ASSERT( total == 15 );
+        CPPUNIT_ASSERT( memcmp(wire2 + 2, "hello world", 11) == 0 );
+
+        // 回送后由通道分散读入另外的缓存
+        CPPUNIT_ASSERT( client.send(wire1, 2, e) == 2 );
+        CPPUNIT_ASSERT( client.send(wire2, 13, e) == 13 );
+        char rbuf1[2] = { 0 }, rbuf2[32] = { 0 };
+        ByteBuffer in1(rbuf1, sizeof(rbuf1)), in2(rbuf2, sizeof(rbuf2));
+        ByteBuffer *inbufs[] = { &in1, &in2 };
+        total = 0;
+        for ( int retry = 0; total < 15 && retry < 100; ++retry ) {
+            ssize_t r = ch.read(inbufs, 2, e);
+            CPPUNIT_ASSERT( r >= 0 );
+            total += r;
+            if ( total < 15 ) this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( in1.position() == 2 && in2.position() == 13 );
+        CPPUNIT_ASSERT( memcmp(rbuf1, wire1, 2) == 0 );
+        CPPUNIT_ASSERT( memcmp(rbuf2, wire2, 2) == 0 );
+        CPPUNIT_ASSERT( memcmp(rbuf2 + 2, "hello world", 11) == 0 );
+    }
+
+    // 对端关闭后发送返回-1，不产生SIGPIPE，测试进程未忽略该信号
+    void testSendToClosedPeer() {
+        RuntimeError e;
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        StreamSocketChannel ch;
+        for ( int retry = 0; !m_server.accept(ch, e) && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( ch.close(e) );
+
+        // 第一次发送触发对端RST，之后的发送以EPIPE失败
+        char data[64] = { 0 };
+        ssize_t r = 0;
+        for ( int retry = 0; r >= 0 && retry < 100; ++retry ) {
+            r = client.send(data, sizeof(data), e);
+            if ( r >= 0 ) this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( r == -1 );
+        struct iovec iov[1] = { { data, sizeof(data) } };
+        CPPUNIT_ASSERT( client.sendv(iov, 1, e) == -1 );
+        CPPUNIT_ASSERT( client.send_all(data, sizeof(data), e) == -1 );
+    }
+
+    // 大报文零拷贝发送，完成通知通过OpError报告后取回tag；小报文走复制路径
+    void testZeroCopy() {
+        RuntimeError e;
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        StreamSocketChannel ch;
+        for ( int retry = 0; !m_server.accept(ch, e) && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        e.clear();
+        if ( !ch.zerocopy(4096, e) ) {
+            cout<<"SO_ZEROCOPY not supported, skipped: "<<e.message()<<endl;
+            return;
+        }
+        CPPUNIT_ASSERT( ch.is_zerocopy(4096) && !ch.is_zerocopy(100) );
+        SelectionKey *key = ch.reg(&m_selector, SelectionKey::OpError, e);
+        CPPUNIT_ASSERT( key != nullptr );
+
+        static char big[65536], small[100];
+        ByteBuffer bigbuf(big, sizeof(big)), smallbuf(small, sizeof(small));
+        CPPUNIT_ASSERT( ch.write_zerocopy(smallbuf, small, e) == (ssize_t)sizeof(small) );
+        CPPUNIT_ASSERT( ch.zerocopy_pending() == 0 );
+
+        size_t sent = 0;
+        while ( bigbuf.remaining() > 0 ) {
+            ssize_t r = ch.write_zerocopy(bigbuf, big, e);
+            CPPUNIT_ASSERT( r >= 0 );
+            sent += r;
+            char rbuf[65536];
+            CPPUNIT_ASSERT( client.receive(rbuf, sizeof(rbuf), e) > 0 );
+        }
+        CPPUNIT_ASSERT( ch.zerocopy_pending() > 0 );
+
+        void * tags[4];
+        ssize_t ntags = 0;
+        for ( int retry = 0; ntags == 0 && retry < 100; ++retry ) {
+            CPPUNIT_ASSERT( m_selector.select(100, e) >= 0 );
+            if ( !key->is_error() ) continue;
+            CPPUNIT_ASSERT( !key->is_readable() && !key->is_writable() );
+            ntags = ch.reap_zerocopy(tags, 4, e);
+            CPPUNIT_ASSERT( ntags >= 0 );
+        }
+        CPPUNIT_ASSERT( ntags == 1 );
+        CPPUNIT_ASSERT( tags[0] == big );
+        CPPUNIT_ASSERT( ch.zerocopy_pending() == 0 );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+    }
+
+    // 文件经sendfile、管道经splice发送到非阻塞通道，写满时等待可写后继续
+    void testTransferFrom() {
+        RuntimeError e;
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        StreamSocketChannel ch;
+        for ( int retry = 0; !m_server.accept(ch, e) && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        SelectionKey *key = ch.reg(&m_selector, SelectionKey::OpWrite, e);
+        CPPUNIT_ASSERT( key != nullptr );
+
+        const size_t FILESIZE = 4 * 1024 * 1024, OFFSET = 1000;
+        static char content[FILESIZE];
+        for ( size_t i = 0; i < FILESIZE; ++i ) content[i] = (char)(i * 7);
+        char path[] = "/tmp/transfer_testXXXXXX";
+        int fd = mkstemp(path);
+        CPPUNIT_ASSERT( fd >= 0 );
+        unlink(path);
+        CPPUNIT_ASSERT( write(fd, content, FILESIZE) == (ssize_t)FILESIZE );
+
+        // 客户端在另一线程接收，主线程按可写事件推进发送
+        static char received[FILESIZE];
+        size_t total = FILESIZE - OFFSET;
+        thread reader([&]() {
+            RuntimeError e2;
+            size_t got = 0;
+            while ( got < total ) {
+                ssize_t r = client.receive(received + got, total - got, e2);
+                if ( r < 0 ) break;
+                got += r;
+            }
+        });
+
+        size_t sent = 0;
+        while ( sent < total ) {
+            ssize_t r = ch.transfer_from(fd, OFFSET + sent, total - sent, e);
+            CPPUNIT_ASSERT( r >= 0 );
+            sent += r;
+            if ( sent < total ) CPPUNIT_ASSERT( m_selector.select(1000, e) >= 0 );
+        }
+        reader.join();
+        CPPUNIT_ASSERT( memcmp(received, content + OFFSET, total) == 0 );
+        CPPUNIT_ASSERT( ch.transfer_from(fd, FILESIZE, 1, e) == -1 );   // 超出文件末尾
+        close(fd);
+
+        // 管道不支持sendfile，经由splice发送
+        int pfd[2];
+        CPPUNIT_ASSERT( pipe(pfd) == 0 );
+        CPPUNIT_ASSERT( write(pfd[1], "spliced data", 12) == 12 );
+        e.clear();
+        sent = 0;
+        for ( int retry = 0; sent < 12 && retry < 100; ++retry ) {
+            ssize_t r = ch.transfer_from(pfd[0], 0, 12 - sent, e);
+            CPPUNIT_ASSERT( r >= 0 );
+            sent += r;
+        }
+        CPPUNIT_ASSERT( sent == 12 );
+        char buf[16];
+        size_t got = 0;
+        while ( got < 12 ) {
+            ssize_t r = client.receive(buf + got, 12 - got, e);
+            CPPUNIT_ASSERT( r > 0 );
+            got += r;
+        }
+        CPPUNIT_ASSERT( memcmp(buf, "spliced data", 12) == 0 );
+        close(pfd[0]);
+        close(pfd[1]);
+    }
+
+    // 非阻塞连接在OpConnect就绪后由finish_connect完成；连接被拒绝时finish_connect失败
+    void testConnect() {
+        RuntimeError e;
+        const size_t N = 8;
+        StreamSocketChannel chs[N];
+        size_t pending = 0;
+        for ( size_t i = 0; i < N; ++i ) {
+            CPPUNIT_ASSERT( chs[i].connect("127.0.0.1", m_port, e) );
+            CPPUNIT_ASSERT( e.code() == 0 );
+            if ( chs[i].is_connected() ) continue;
+            CPPUNIT_ASSERT( chs[i].is_connection_pending() );
+            CPPUNIT_ASSERT( chs[i].reg(&m_selector, SelectionKey::OpConnect, &chs[i], e) != nullptr );
+            ++pending;
+        }
+
+        vector<SelectionKey*> keys;
+        for ( int retry = 0; pending > 0 && retry < 100; ++retry ) {
+            CPPUNIT_ASSERT( m_selector.select(100, e) >= 0 );
+            m_selector.selected_keys(keys);
+            for ( size_t k = 0; k < keys.size(); ++k ) {
+                CPPUNIT_ASSERT( keys[k]->is_connectable() );
+                StreamSocketChannel *ch = (StreamSocketChannel *)keys[k]->attachment();
+                CPPUNIT_ASSERT( ch->finish_connect(e) == 1 );
+                keys[k]->interest_ops(SelectionKey::OpRead);
+                --pending;
+            }
+        }
+        CPPUNIT_ASSERT( pending == 0 );
+        for ( size_t i = 0; i < N; ++i ) CPPUNIT_ASSERT( chs[i].is_connected() );
+
+        // 绑定但未监听的端口，连接被拒绝
+        net::StreamSocket closed;
+        CPPUNIT_ASSERT( closed.create(AF_INET, e) );
+        CPPUNIT_ASSERT( closed.bind("127.0.0.1", 0, e) );
+        int port = closed.local_port(e);
+
+        StreamSocketChannel refused;
+        if ( !refused.connect("127.0.0.1", port, e) ) return;   // 立即失败
+        SelectionKey *key = refused.reg(&m_selector, SelectionKey::OpConnect, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( key->is_connectable() );
+        CPPUNIT_ASSERT( refused.finish_connect(e) == -1 );
+        CPPUNIT_ASSERT( !refused.is_connection_pending() );
+    }
+
+    // 键的期限到达时以OpTimeout就绪一次，清除期限后不再就绪
+    void testDeadline() {
+        RuntimeError e;
+        SelectionKey *key = m_server.reg(&m_selector, SelectionKey::OpAccept, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        key->deadline(50);
+        CPPUNIT_ASSERT( key->has_deadline() );
+
+        auto start = chrono::steady_clock::now();
+        CPPUNIT_ASSERT( m_selector.select(5000, e) == 1 );
+        long elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        CPPUNIT_ASSERT( elapsed >= 45 && elapsed < 1000 );
+        CPPUNIT_ASSERT( key->is_timeout() );
+        CPPUNIT_ASSERT( !key->is_acceptable() );
+        CPPUNIT_ASSERT( !key->has_deadline() );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+
+        key->deadline(20);
+        key->deadline(-1);
+        CPPUNIT_ASSERT( m_selector.select(60, e) == 0 );
+
+        // 注销后期限随之清除
+        key->deadline(10);
+        CPPUNIT_ASSERT( m_selector.unreg(key, e) );
+        CPPUNIT_ASSERT( m_selector.select(40, e) == 0 );
+    }
+
+    struct CountTimer : public Timer {
+        int fired;
+        CountTimer() : fired(0) {}
+        void on_timeout() override { ++fired; }
+    };
+
+    // select等待不超过最近定时器的到期时间，到期后回调，取消的定时器不回调
+    void testTimer() {
+        RuntimeError e;
+        CountTimer t1, t2;
+        CPPUNIT_ASSERT( m_selector.schedule(&t1, 30, e) );
+        CPPUNIT_ASSERT( m_selector.schedule(&t2, 60, e) );
+        CPPUNIT_ASSERT( m_selector.timers() == 2 );
+        t2.cancel();
+        CPPUNIT_ASSERT( m_selector.timers() == 1 );
+
+        auto start = chrono::steady_clock::now();
+        while ( t1.fired == 0 ) CPPUNIT_ASSERT( m_selector.select(5000, e) == 0 );
+        long elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        CPPUNIT_ASSERT( elapsed >= 25 && elapsed < 1000 );
+        CPPUNIT_ASSERT( !t1.is_pending() );
+        CPPUNIT_ASSERT( m_selector.timers() == 0 );
+
+        CPPUNIT_ASSERT( m_selector.select(80, e) == 0 );
+        CPPUNIT_ASSERT( t1.fired == 1 && t2.fired == 0 );
+
+        // 没有定时器时空闲等待后再调度，时间轮已跟上时钟，一次select即到期
+        CPPUNIT_ASSERT( m_selector.select(300, e) == 0 );
+        CPPUNIT_ASSERT( m_selector.schedule(&t1, 30, e) );
+        CPPUNIT_ASSERT( m_selector.select(5000, e) == 0 );
+        CPPUNIT_ASSERT( t1.fired == 2 );
+
+        // 关闭Selector时等待中的定时器被取消
+        CPPUNIT_ASSERT( m_selector.schedule(&t2, 10, e) );
+        CPPUNIT_ASSERT( m_selector.close(e) );
+        CPPUNIT_ASSERT( !t2.is_pending() );
+        CPPUNIT_ASSERT( !m_selector.schedule(&t2, 10, e) );
+    }
+
+    // 多个线程并发提交，任务在Selector线程中执行，同一线程提交的任务保持顺序
+    void testSubmit() {
+        RuntimeError e;
+        const int Producers = 4, PerProducer = 10000;
+        vector<int> last(Producers, -1);
+        atomic<int> executed(0);
+        bool ordered = true, in_thread = true;
+
+        vector<thread> producers;
+        for ( int p = 0; p < Producers; ++p ) {
+            producers.push_back(thread([&, p]() {
+                RuntimeError err;
+                for ( int i = 0; i < PerProducer; ++i ) {
+                    m_selector.submit([&, p, i]() {
+                        if ( last[p] + 1 != i ) ordered = false;
+                        last[p] = i;
+                        if ( !m_selector.in_selector_thread() ) in_thread = false;
+                        executed.fetch_add(1, memory_order_relaxed);
+                    }, err);
+                }
+            }));
+        }
+
+        // select无限等待，只靠提交唤醒
+        auto start = chrono::steady_clock::now();
+        while ( executed.load() < Producers * PerProducer ) {
+            CPPUNIT_ASSERT( m_selector.select(e) == 0 );
+            CPPUNIT_ASSERT( chrono::steady_clock::now() - start < chrono::seconds(10) );
+        }
+        for ( size_t i = 0; i < producers.size(); ++i ) producers[i].join();
+        CPPUNIT_ASSERT( ordered && in_thread );
+
+        // Selector线程自身提交的任务在下一次select中执行，不等待
+        bool ran = false;
+        CPPUNIT_ASSERT( m_selector.submit([&ran]() { ran = true; }, e) );
+        CPPUNIT_ASSERT( m_selector.select(5000, e) == 0 );
+        CPPUNIT_ASSERT( ran );
+    }
+
+    // 其它线程修改关注事件，提交到Selector线程后生效
+    void testCrossThreadInterest() {
+        RuntimeError e;
+        SelectionKey *key = m_server.reg(&m_selector, 0, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+
+        thread other([key]() {
+            this_thread::sleep_for(chrono::milliseconds(20));
+            key->interest_ops(SelectionKey::OpRead);
+            key->interest_ops(SelectionKey::OpAccept);   // 合并为一次提交，以最后的设置为准
+        });
+        CPPUNIT_ASSERT( m_selector.select(5000, e) == 0 );   // 被提交唤醒
+        other.join();
+        CPPUNIT_ASSERT( key->interest_ops() == SelectionKey::OpAccept );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( key->is_acceptable() );
+
+        // 提交后注销，键在任务执行时才释放
+        thread other2([key]() { key->interest_ops(0); });
+        other2.join();
+        CPPUNIT_ASSERT( m_selector.unreg(key, e) );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );
+        CPPUNIT_ASSERT( client.close(e) );
+    }
+
+    // 尚未select时没有Selector线程，修改以任务提交，在首次select等待之前生效
+    void testInterestBeforeSelect() {
+        RuntimeError e;
+        SelectionKey *key = m_server.reg(&m_selector, 0, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        CPPUNIT_ASSERT( !m_selector.in_selector_thread() );
+
+        thread other([key]() { key->interest_ops(SelectionKey::OpAccept); });
+        other.join();
+        CPPUNIT_ASSERT( key->interest_ops() == 0 );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( key->is_acceptable() && m_selector.in_selector_thread() );
+        CPPUNIT_ASSERT( client.close(e) );
+    }
+
+    // 通道之间经由Selector以单个ByteBuffer读写，position随读写前移
+    void testChannelReadWrite() {
+        RuntimeError e;
+        StreamSocketChannel client, server;
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        for ( int retry = 0; !m_server.accept(server, e) && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( !server.is_closed() );
+        SelectionKey *key = server.reg(&m_selector, SelectionKey::OpRead, e);
+        CPPUNIT_ASSERT( key != nullptr );
+
+        char obuf[64], ibuf[64];
+        ByteBuffer out(obuf, sizeof(obuf)), in(ibuf, sizeof(ibuf));
+        out.put("ping", 4);
+        out.flip();
+        while ( client.finish_connect(e) == 0 ) this_thread::sleep_for(chrono::milliseconds(1));
+        CPPUNIT_ASSERT( client.write(out, e) == 4 );
+        CPPUNIT_ASSERT( out.remaining() == 0 );
+        CPPUNIT_ASSERT( client.write(out, e) == 0 );
+
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( key->is_readable() );
+        CPPUNIT_ASSERT( server.read(in, e) == 4 );
+        CPPUNIT_ASSERT( in.position() == 4 );
+        CPPUNIT_ASSERT( server.read(in, e) == 0 );
+        in.flip();
+        CPPUNIT_ASSERT( server.write(in, e) == 4 );
+
+        ByteBuffer back(obuf, sizeof(obuf));
+        for ( int retry = 0; back.position() < 4 && retry < 100; ++retry ) {
+            CPPUNIT_ASSERT( client.read(back, e) >= 0 );
+        }
+        CPPUNIT_ASSERT( back.position() == 4 && memcmp(obuf, "ping", 4) == 0 );
+
+        // 组合缓存的各分段由一次writev写出
+        char hdr[4], body[5] = { 'h', 'e', 'l', 'l', 'o' };
+        ByteBuffer head(hdr, sizeof(hdr));
+        head.put_int32(5);
+        head.flip();
+        CompositeByteBuffer msg;
+        msg.append(ByteBuffer(body, sizeof(body)));
+        msg.prepend(head);
+        CPPUNIT_ASSERT( client.write(msg, e) == 9 );
+        CPPUNIT_ASSERT( msg.remaining() == 0 );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        in.clear();
+        CPPUNIT_ASSERT( server.read(in, e) == 9 );
+        CPPUNIT_ASSERT( memcmp(ibuf, hdr, 4) == 0 && memcmp(ibuf + 4, "hello", 5) == 0 );
+
+        // 环形缓存接收，可写空间跨越环末尾时数据仍然连续
+        RingByteBuffer ring;
+        CPPUNIT_ASSERT( ring.open(1, e) );
+        ring.commit(ring.capacity() - 3);
+        ring.consume(ring.capacity() - 3);
+        msg.position(0);
+        CPPUNIT_ASSERT( client.write(msg, e) == 9 );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( server.read(ring, e) == 9 );
+        CPPUNIT_ASSERT( ring.readable() == 9 );
+        ByteBuffer frame = ring.read_buffer();
+        CPPUNIT_ASSERT( frame.get_int32() == 5 && memcmp(frame.ptr(), "hello", 5) == 0 );
+
+        // 对端关闭后读取返回-1
+        CPPUNIT_ASSERT( client.close(e) );
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        in.clear();
+        CPPUNIT_ASSERT( server.read(in, e) == -1 );
+    }
+
+    // 编码器以writev批量写出大量小帧和一个大帧，解码器每次读取后解出全部完整的帧
+    void testFrameCodec() {
+        RuntimeError e;
+        StreamSocketChannel client, server;
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        for ( int retry = 0; !m_server.accept(server, e) && retry < 100; ++retry ) {
+            this_thread::sleep_for(chrono::milliseconds(10));
+        }
+        CPPUNIT_ASSERT( !server.is_closed() );
+        while ( client.finish_connect(e) == 0 ) this_thread::sleep_for(chrono::milliseconds(1));
+
+        const size_t count = 1000;
+        FrameEncoder enc;
+        char small[8];
+        for ( size_t i = 0; i < count; ++i ) {
+            ByteBuffer p(small, sizeof(small));
+            p.put_int64<BigEndianOrder>((int64_t)i);
+            p.flip();
+            CPPUNIT_ASSERT( enc.encode(p, e) );
+        }
+        ByteBuffer large = ByteBuffer::allocate(1 << 20);
+        memset(large.ptr(0), 'L', large.capacity());
+        CPPUNIT_ASSERT( enc.encode(large, e) );
+
+        FrameDecoder dec;
+        vector<ByteBuffer> frames;
+        for ( int retry = 0; frames.size() < count + 1 && retry < 1000; ++retry ) {
+            CPPUNIT_ASSERT( enc.flush(client, e) >= 0 );
+            ssize_t r = dec.read(server, e);
+            CPPUNIT_ASSERT( r >= 0 );
+            dec.next_all(frames, e);
+            CPPUNIT_ASSERT( !e );
+            if ( r == 0 ) this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        CPPUNIT_ASSERT( enc.pending() == 0 && dec.buffered() == 0 );
+        CPPUNIT_ASSERT( frames.size() == count + 1 );
+        for ( size_t i = 0; i < count; ++i ) {
+            CPPUNIT_ASSERT( frames[i].remaining() == 8 && frames[i].get_int64() == (int64_t)i );
+        }
+        CPPUNIT_ASSERT( frames[count].remaining() == large.capacity() );
+        CPPUNIT_ASSERT( frames[count].get(large.capacity() - 1) == 'L' );
+    }
+
+    // 数据报通道以OpRead就绪，接收得到报文内容和来源地址；连接后可以read/write
+    void testDatagramChannel() {
+        RuntimeError e;
+        DatagramSocketChannel a, b;
+        CPPUNIT_ASSERT( a.create(AF_INET, e) && a.bind("127.0.0.1", 0, e) );
+        CPPUNIT_ASSERT( b.create(AF_INET, e) && b.bind("127.0.0.1", 0, e) );
+        SelectionKey *key = b.reg(&m_selector, SelectionKey::OpRead, e);
+        CPPUNIT_ASSERT( key != nullptr );
+
+        char obuf[32], ibuf[32];
+        ByteBuffer out(obuf, sizeof(obuf)), in(ibuf, sizeof(ibuf));
+        net::Inet4Address loopback("127.0.0.1", e);
+        net::InetSocketAddress to(loopback, b.socket()->local_port(e));
+        CPPUNIT_ASSERT( b.read(in, e) == 0 );
+        out.put("datagram", 8);
+        out.flip();
+        CPPUNIT_ASSERT( a.send(out, to, e) == 8 );
+        CPPUNIT_ASSERT( out.remaining() == 0 );
+
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( key->is_readable() );
+        net::InetSocketAddress from(to);
+        CPPUNIT_ASSERT( b.receive(in, &from, e) == 8 );
+        CPPUNIT_ASSERT( in.position() == 8 && memcmp(ibuf, "datagram", 8) == 0 );
+        CPPUNIT_ASSERT( from.port() == a.socket()->local_port(e) );
+
+        // 连接后回复，position移到limit
+        CPPUNIT_ASSERT( b.connect("127.0.0.1", from.port(), e) );
+        CPPUNIT_ASSERT( b.is_connected() );
+        in.flip();
+        CPPUNIT_ASSERT( b.write(in, e) == 8 );
+        CPPUNIT_ASSERT( in.position() == 8 );
+        out.clear();
+        for ( int retry = 0; out.position() == 0 && retry < 100; ++retry ) {
+            CPPUNIT_ASSERT( a.read(out, e) >= 0 );
+        }
+        CPPUNIT_ASSERT( out.position() == 8 && memcmp(obuf, "datagram", 8) == 0 );
+        CPPUNIT_ASSERT( a.close(e) && b.close(e) );
+        CPPUNIT_ASSERT( !key->is_valid() );
+    }
+}; // end class SelectorTest
+
+/**
+ * 以io_uring引擎运行同样的测试。
+ */
+/// 记录完成模式的每次结果。
+class RecordingCompletion : public Completion {
+public:
+    vector<int>    results;
+    vector<bool>   mores;
+    vector<string> datas;
+
+    void on_complete(int res, bool more) override {
+        results.push_back(res);
+        mores.push_back(more);
+        datas.push_back(this->data() && res > 0 ? string(this->data(), res) : string());
+    }
+}; // end class RecordingCompletion
+
+/// 请求结束时尝试重新提交并关闭通道，检查Selector关闭过程中的回调。
+class ResubmitCompletion : public RecordingCompletion {
+public:
+    Selector            * selector;
+    StreamSocketChannel * ch;
+    bool                  resubmitted;
+
+    ResubmitCompletion(Selector *s, StreamSocketChannel *c) : selector(s), ch(c), resubmitted(false) {}
+
+    void on_complete(int res, bool more) override {
+        RecordingCompletion::on_complete(res, more);
+        if ( more ) return;
+        RuntimeError e;
+        resubmitted = ch->read_async(selector, this, e);
+        ch->close(e);
+    }
+}; // end class ResubmitCompletion
+
+class UringSelectorTest : public SelectorTest {
+    CPPUNIT_TEST_SUB_SUITE( UringSelectorTest, SelectorTest );
+    CPPUNIT_TEST( testInterestChange );
+    CPPUNIT_TEST( testCompletion );
+    CPPUNIT_TEST( testCompletionSelectorClose );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    virtual int engine() const { return Selector::EngineUring; }
+
+    // 修改关注事件后旧的poll请求不再产生事件
+    void testInterestChange() {
+        RuntimeError e;
+        SelectionKey *key = m_server.reg(&m_selector, SelectionKey::OpAccept, e);
+        CPPUNIT_ASSERT( key != nullptr );
+        CPPUNIT_ASSERT( m_selector.select(0, e) == 0 );   // 成为Selector线程，修改立即生效
+        key->interest_ops(0);
+        CPPUNIT_ASSERT( key->interest_ops() == 0 );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        CPPUNIT_ASSERT( m_selector.select(100, e) == 0 );
+
+        key->interest_ops(SelectionKey::OpAccept);
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+        CPPUNIT_ASSERT( key->is_acceptable() );
+        // 水平触发：未accept时仍然就绪
+        CPPUNIT_ASSERT( m_selector.select(1000, e) == 1 );
+    }
+
+    /// select直到c收到n个结果。
+    bool wait_results(RecordingCompletion &c, size_t n) {
+        RuntimeError e;
+        for ( int retry = 0; c.results.size() < n && retry < 100; ++retry ) {
+            if ( m_selector.select(10, e) < 0 ) return false;
+        }
+        return c.results.size() == n;
+    }
+
+    // 完成模式：多次触发的accept和recv持续产生结果，send完成后请求结束，关闭通道时取消请求
+    void testCompletion() {
+        RuntimeError e;
+        CPPUNIT_ASSERT( m_selector.recv_buffers(16, 256, e) );
+        CPPUNIT_ASSERT( !m_selector.recv_buffers(16, 256, e) );
+
+        RecordingCompletion acc, rd, wr;
+        CPPUNIT_ASSERT( m_server.accept_async(&m_selector, &acc, e) );
+        CPPUNIT_ASSERT( acc.is_pending() );
+        CPPUNIT_ASSERT( m_server.is_registered() );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        CPPUNIT_ASSERT( wait_results(acc, 1) );
+        CPPUNIT_ASSERT( acc.results[0] >= 0 && acc.mores[0] && acc.is_pending() );
+
+        StreamSocketChannel ch;
+        CPPUNIT_ASSERT( m_server.adopt(acc.results[0], ch, e) );
+        CPPUNIT_ASSERT( !ch.is_closed() );
+        CPPUNIT_ASSERT( ch.read_async(&m_selector, &rd, e) );
+
+        CPPUNIT_ASSERT( client.send("hello", 5, e) == 5 );
+        CPPUNIT_ASSERT( wait_results(rd, 1) );
+        CPPUNIT_ASSERT( rd.results[0] == 5 && rd.mores[0] && rd.datas[0] == "hello" );
+        CPPUNIT_ASSERT( client.send("again", 5, e) == 5 );
+        CPPUNIT_ASSERT( wait_results(rd, 2) );
+        CPPUNIT_ASSERT( rd.datas[1] == "again" );
+
+        char obuf[8] = { 'w', 'o', 'r', 'l', 'd' };
+        ByteBuffer out(obuf, 5);
+        CPPUNIT_ASSERT( ch.write_async(&m_selector, out, &wr, e) );
+        CPPUNIT_ASSERT( wait_results(wr, 1) );
+        CPPUNIT_ASSERT( wr.results[0] == 5 && !wr.mores[0] && !wr.is_pending() );
+        CPPUNIT_ASSERT( out.position() == 0 );
+        char ibuf[8];
+        CPPUNIT_ASSERT( client.receive(ibuf, sizeof(ibuf), e) == 5 && memcmp(ibuf, "world", 5) == 0 );
+
+        // 对端关闭时读到0，请求结束
+        CPPUNIT_ASSERT( client.close(e) );
+        CPPUNIT_ASSERT( wait_results(rd, 3) );
+        CPPUNIT_ASSERT( rd.results[2] == 0 && !rd.mores[2] && !rd.is_pending() );
+        CPPUNIT_ASSERT( ch.close(e) );
+
+        // 关闭监听通道时取消多次触发的accept
+        CPPUNIT_ASSERT( m_server.close(e) );
+        CPPUNIT_ASSERT( wait_results(acc, 2) );
+        CPPUNIT_ASSERT( acc.results[1] == -ECANCELED && !acc.mores[1] && !acc.is_pending() );
+        CPPUNIT_ASSERT( m_selector.syscalls() > 0 );
+
+        // epoll引擎不支持完成模式，通道不因此被注册
+        Selector epoll;
+        CPPUNIT_ASSERT( epoll.open(Selector::EngineEpoll, e) );
+        StreamSocketChannel other;
+        CPPUNIT_ASSERT( other.socket()->create(AF_INET, e) );
+        CPPUNIT_ASSERT( !other.read_async(&epoll, &rd, e) );
+        CPPUNIT_ASSERT( !other.is_registered() );
+    }
+
+    // 关闭Selector时未结束的请求以-ECANCELED结束，之后不再是pending，回调中不能再提交
+    void testCompletionSelectorClose() {
+        RuntimeError e;
+        RecordingCompletion acc;
+        CPPUNIT_ASSERT( m_server.accept_async(&m_selector, &acc, e) );
+
+        net::StreamSocket client;
+        CPPUNIT_ASSERT( client.create(AF_INET, e) );
+        CPPUNIT_ASSERT( client.connect("127.0.0.1", m_port, e) );
+        CPPUNIT_ASSERT( wait_results(acc, 1) );
+
+        StreamSocketChannel ch;
+        CPPUNIT_ASSERT( m_server.adopt(acc.results[0], ch, e) );
+        ResubmitCompletion rd(&m_selector, &ch);
+        CPPUNIT_ASSERT( ch.read_async(&m_selector, &rd, e) );
+        CPPUNIT_ASSERT( m_selector.select(10, e) == 0 );
+        CPPUNIT_ASSERT( acc.is_pending() && rd.is_pending() );
+
+        CPPUNIT_ASSERT( m_selector.close(e) );
+        CPPUNIT_ASSERT( !acc.is_pending() && !rd.is_pending() );
+        CPPUNIT_ASSERT( acc.results.size() == 2 && acc.results[1] == -ECANCELED && !acc.mores[1] );
+        CPPUNIT_ASSERT( rd.results.size() == 1 && rd.results[0] == -ECANCELED && !rd.mores[0] );
+        CPPUNIT_ASSERT( !rd.resubmitted && ch.is_closed() );
+    }
+}; // end class UringSelectorTest
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SelectorTest );
+CPPUNIT_TEST_SUITE_REGISTRATION( UringSelectorTest );
+
+int main(int argc, char **argv)
+{
+    CppUnit::TextUi::TestRunner runner;
+    CppUnit::Test *suite = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+    runner.addTest(suite);
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,188 @@
+#include <mercury/nio/timer.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/ui/text/TestRunner.h>
+#include <cppunit/TestCaller.h>
+#include <cppunit/TestSuite.h>
+#include <cppunit/extensions/HelperMacros.h>
+#include <stdlib.h>
+
+#include <iostream>
+#include <vector>
+
+using namespace mercury;
+using namespace mercury::nio;
+using namespace std;
+
+/**
+ * 记录到期时时间轮的刻度。
+ */
+struct RecordTimer : public Timer {
+    TimerWheel * wheel;
+    int64_t      fired_at;
+    int          fired;
+    Timer      * victim;    // 回调中取消的定时器
+    int64_t      period;    // >0时回调中重新调度自身
+
+    RecordTimer() : wheel(nullptr), fired_at(-1), fired(0), victim(nullptr), period(0) {}
+
+    void on_timeout() override {
+        fired_at = wheel->now();
+        ++fired;
+        if ( victim ) victim->cancel();
+        if ( period > 0 ) wheel->schedule(this, period);
+    }
+};
+
+class TimerWheelTest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE( TimerWheelTest );
+    CPPUNIT_TEST( testExpireAcrossLevels );
+    CPPUNIT_TEST( testNextTimeout );
+    CPPUNIT_TEST( testCancel );
+    CPPUNIT_TEST( testPeriodic );
+    CPPUNIT_TEST( testRandom );
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp () {}
+    void tearDown() {}
+
+    // 各层的定时器都在到期刻度准确触发，逐步推进和按next_timeout跳跃推进结果相同
+    void testExpireAcrossLevels() {
+        const int64_t delays[] = { 0, 1, 255, 256, 300, 16383, 16384, 20000,
+                                   ((int64_t)1 << 20) + 5, TimerWheel::MaxSpan + 100 };
+        const size_t N = sizeof(delays) / sizeof(delays[0]);
+        for ( int jump = 0; jump < 2; ++jump ) {
+            TimerWheel wheel(1000);
+            RecordTimer timers[N];
+            for ( size_t i = 0; i < N; ++i ) {
+                timers[i].wheel = &wheel;
+                wheel.schedule(&timers[i], delays[i]);
+            }
+            CPPUNIT_ASSERT( wheel.size() == N );
+
+            if ( jump ) {
+                // 每次推进到next_timeout给出的时刻
+                while ( !wheel.empty() ) {
+                    int64_t wait = wheel.next_timeout(wheel.now());
+                    CPPUNIT_ASSERT( wait >= 0 );
+                    wheel.advance(wheel.now() + (wait > 0 ? wait : 1));
+                }
+            } else {
+                // 前面逐刻度推进，之后以不对齐的步长推进
+                for ( int64_t now = 1001; !wheel.empty(); now += (now < 100000 ? 1 : 997) )
+                    wheel.advance(now);
+            }
+            for ( size_t i = 0; i < N; ++i ) {
+                int64_t expect = 1000 + (delays[i] > 0 ? delays[i] : 1);
+                CPPUNIT_ASSERT( timers[i].fired == 1 );
+                CPPUNIT_ASSERT( timers[i].fired_at == expect );
+            }
+        }
+    }
+
+    void testNextTimeout() {
+        TimerWheel wheel(0);
+        CPPUNIT_ASSERT( wheel.next_timeout(0) == -1 );
+
+        RecordTimer t1, t2;
+        t1.wheel = t2.wheel = &wheel;
+        wheel.schedule(&t1, 100);
+        CPPUNIT_ASSERT( wheel.next_timeout(0) == 100 );
+        CPPUNIT_ASSERT( wheel.next_timeout(40) == 60 );
+        CPPUNIT_ASSERT( wheel.next_timeout(200) == 0 );
+
+        // 高层的定时器返回其所在槽的下移时刻
+        t1.cancel();
+        wheel.schedule(&t2, 1000);
+        CPPUNIT_ASSERT( wheel.next_timeout(0) == 768 );
+        CPPUNIT_ASSERT( wheel.advance(768) == 0 );
+        CPPUNIT_ASSERT( wheel.next_timeout(768) == 232 );
+        CPPUNIT_ASSERT( wheel.advance(5000) == 1 );
+        CPPUNIT_ASSERT( t2.fired_at == 1000 );
+        CPPUNIT_ASSERT( wheel.now() == 5000 );
+    }
+
+    void testCancel() {
+        TimerWheel wheel(0);
+        RecordTimer t1, t2, t3;
+        t1.wheel = t2.wheel = t3.wheel = &wheel;
+        wheel.schedule(&t1, 10);
+        wheel.schedule(&t2, 10);
+        wheel.schedule(&t3, 5000);
+        CPPUNIT_ASSERT( t1.is_pending() && t2.is_pending() && t3.is_pending() );
+
+        // 同一刻度到期的定时器在回调中互相取消，只有先回调的一个触发
+        t1.victim = &t2;
+        t2.victim = &t1;
+        t3.cancel();
+        CPPUNIT_ASSERT( !t3.is_pending() );
+        CPPUNIT_ASSERT( wheel.advance(10000) == 1 );
+        CPPUNIT_ASSERT( t1.fired + t2.fired == 1 );
+        CPPUNIT_ASSERT( t3.fired == 0 );
+        CPPUNIT_ASSERT( wheel.empty() );
+
+        // 析构时自动取消
+        {
+            RecordTimer t4;
+            wheel.schedule(&t4, 10);
+            CPPUNIT_ASSERT( wheel.size() == 1 );
+        }
+        CPPUNIT_ASSERT( wheel.empty() );
+        CPPUNIT_ASSERT( wheel.next_timeout(wheel.now()) == -1 );
+    }
+
+    // 回调中重新调度自身，一次推进中不会重复触发
+    void testPeriodic() {
+        TimerWheel wheel(0);
+        RecordTimer t;
+        t.wheel = &wheel;
+        t.period = 100;
+        wheel.schedule(&t, 100);
+        CPPUNIT_ASSERT( wheel.advance(1050) == 10 );
+        CPPUNIT_ASSERT( t.fired == 10 && t.fired_at == 1000 );
+
+        t.period = 0;
+        t.victim = nullptr;
+        wheel.schedule(&t, 0);
+        CPPUNIT_ASSERT( wheel.advance(1050) == 0 );
+        CPPUNIT_ASSERT( wheel.advance(1051) == 1 );
+    }
+
+    // 大量随机定时器，随机步长推进，每个都在到期刻度触发
+    void testRandom() {
+        const size_t N = 100000;
+        TimerWheel wheel(12345);
+        vector<RecordTimer> timers(N);
+        vector<int64_t> expires(N);
+        srand(7);
+        for ( size_t i = 0; i < N; ++i ) {
+            timers[i].wheel = &wheel;
+            int64_t delay = 1 + rand() % (1 << (rand() % 24 + 1));
+            expires[i] = wheel.now() + delay;
+            wheel.schedule(&timers[i], delay);
+        }
+        // 取消其中的一半
+        for ( size_t i = 0; i < N; i += 2 ) timers[i].cancel();
+        CPPUNIT_ASSERT( wheel.size() == N / 2 );
+
+        size_t fired = 0;
+        while ( !wheel.empty() ) fired += wheel.advance(wheel.now() + 1 + rand() % 5000);
+        CPPUNIT_ASSERT( fired == N / 2 );
+        for ( size_t i = 0; i < N; ++i ) {
+            if ( i % 2 == 0 ) { CPPUNIT_ASSERT( timers[i].fired == 0 ); continue; }
+            CPPUNIT_ASSERT( timers[i].fired == 1 );
+            CPPUNIT_ASSERT( timers[i].fired_at == expires[i] );
+        }
+    }
+}; // end class TimerWheelTest
+
+CPPUNIT_TEST_SUITE_REGISTRATION( TimerWheelTest );
+
+int main(int argc, char **argv)
+{
+    CppUnit::TextUi::TestRunner runner;
+    CppUnit::Test *suite = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
+    runner.addTest(suite);
+    runner.run();
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include <mercury/nio/buffer.h>
+#include <mercury/nio/buffer_cursor.h>
+
+#include <chrono>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace mercury;
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+static void print_help(const char * program) {
+    printf("usage: %s [-s size] [-r rounds] [-h]\n", program);
+    printf("  比较ByteBuffer类型化读写与memcpy的速度，分别测试运行时字节序和编译期字节序。\n");
+    printf("  -s size     buffer size in bytes, default 65536\n");
+    printf("  -r rounds   passes over the buffer, default 20000\n");
+}
+
+/// 执行rounds遍fn，返回每秒处理的字节数。
+template<class Fn>
+static double measure(size_t size, size_t rounds, Fn fn) {
+    Clock::time_point start = Clock::now();
+    for ( size_t i = 0; i < rounds; ++i ) fn();
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+    return (double)size * rounds / seconds;
+}
+
+static void report(const char *name, double rate, double base) {
+    printf("%-28s %10.2f %8.2f\n", name, rate / (1024.0 * 1024.0 * 1024.0), rate / base);
+}
+
+int main(int argc, char **argv)
+{
+    size_t size = 65536;
+    size_t rounds = 20000;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:r:h")) != -1) {
+        switch (opt) {
+            case 's': size = (size_t)atol(optarg); break;
+            case 'r': rounds = (size_t)atol(optarg); break;
+            default:  print_help(argv[0]); return 0;
+        }
+    }
+    size = size / 8 * 8;
+    if ( size == 0 ) size = 65536;
+
+    nio::ByteBuffer src = nio::ByteBuffer::allocate(size);
+    nio::ByteBuffer dst = nio::ByteBuffer::allocate(size);
+    for ( size_t i = 0; i < size; ++i ) src.put(i, (char)i);
+    vector<int64_t> values(size / 8);
+    const size_t n = values.size();
+    volatile int64_t sink = 0;
+
+    nio::ByteBuffer native(src);
+    nio::ByteBuffer big(src);
+    big.order(nio::ByteOrder(nio::ByteOrder::BigEndian));
+    nio::ByteBuffer native_out(dst);
+    nio::ByteBuffer big_out(dst);
+    big_out.order(nio::ByteOrder(nio::ByteOrder::BigEndian));
+
+    printf("buffer: %zu bytes, rounds: %zu, swap kernel: %s\n", size, rounds, nio::ByteOrder::swap_kernel());
+    printf("%-28s %10s %8s\n", "case", "GB/s", "ratio");
+
+    double base = measure(size, rounds, [&]() {
+        memcpy(values.data(), src.ptr(0), size);
+        sink = sink + values[0];
+    });
+    report("memcpy", base, base);
+
+    report("get_int64 runtime native", measure(size, rounds, [&]() {
+        native.clear();
+        int64_t sum = 0;
+        for ( size_t i = 0; i < n; ++i ) sum += native.get_int64();
+        sink = sink + sum;
+    }), base);
+    report("get_int64 runtime big", measure(size, rounds, [&]() {
+        big.clear();
+        int64_t sum = 0;
+        for ( size_t i = 0; i < n; ++i ) sum += big.get_int64();
+        sink = sink + sum;
+    }), base);
+    report("get_int64<NativeOrder>", measure(size, rounds, [&]() {
+        native.clear();
+        int64_t sum = 0;
+        for ( size_t i = 0; i < n; ++i ) sum += native.get_int64<nio::NativeOrder>();
+        sink = sink + sum;
+    }), base);
+    report("get_int64<BigEndianOrder>", measure(size, rounds, [&]() {
+        native.clear();
+        int64_t sum = 0;
+        for ( size_t i = 0; i < n; ++i ) sum += native.get_int64<nio::BigEndianOrder>();
+        sink = sink + sum;
+    }), base);
+
+    report("put_int64 runtime native", measure(size, rounds, [&]() {
+        native_out.clear();
+        for ( size_t i = 0; i < n; ++i ) native_out.put_int64(values[i]);
+        sink = sink + native_out.ptr(0)[0];
+    }), base);
+    report("put_int64 runtime big", measure(size, rounds, [&]() {
+        big_out.clear();
+        for ( size_t i = 0; i < n; ++i ) big_out.put_int64(values[i]);
+        sink = sink + big_out.ptr(0)[0];
+    }), base);
+    report("put_int64<NativeOrder>", measure(size, rounds, [&]() {
+        native_out.clear();
+        for ( size_t i = 0; i < n; ++i ) native_out.put_int64<nio::NativeOrder>(values[i]);
+        sink = sink + native_out.ptr(0)[0];
+    }), base);
+    report("put_int64<BigEndianOrder>", measure(size, rounds, [&]() {
+        native_out.clear();
+        for ( size_t i = 0; i < n; ++i ) native_out.put_int64<nio::BigEndianOrder>(values[i]);
+        sink = sink + native_out.ptr(0)[0];
+    }), base);
+
+    // 游标：不检查的游标在一批读写前ensure一次，检查的游标每次访问都检查
+    report("UncheckedCursor get big", measure(size, rounds, [&]() {
+        native.clear();
+        nio::ByteBufferCursor<nio::UncheckedAccess, nio::BigEndianOrder> cur(native);
+        int64_t sum = 0;
+        if ( cur.ensure(n * 8) ) {
+            for ( size_t i = 0; i < n; ++i ) sum += cur.get_int64();
+        }
+        sink = sink + sum;
+    }), base);
+    report("CheckedCursor get big", measure(size, rounds, [&]() {
+        native.clear();
+        RuntimeError e;
+        nio::ByteBufferCursor<nio::CheckedAccess, nio::BigEndianOrder> cur(native, e);
+        int64_t sum = 0;
+        for ( size_t i = 0; i < n; ++i ) sum += cur.get_int64();
+        sink = sink + (cur.ok() ? sum : 0);
+    }), base);
+    report("UncheckedCursor put big", measure(size, rounds, [&]() {
+        native_out.clear();
+        nio::ByteBufferCursor<nio::UncheckedAccess, nio::BigEndianOrder> cur(native_out);
+        if ( cur.ensure(n * 8) ) {
+            for ( size_t i = 0; i < n; ++i ) cur.put_int64(values[i]);
+        }
+        sink = sink + cur.position();
+    }), base);
+    report("CheckedCursor put big", measure(size, rounds, [&]() {
+        native_out.clear();
+        RuntimeError e;
+        nio::ByteBufferCursor<nio::CheckedAccess, nio::BigEndianOrder> cur(native_out, e);
+        for ( size_t i = 0; i < n; ++i ) cur.put_int64(values[i]);
+        sink = sink + cur.position();
+    }), base);
+
+    report("get_int64s native", measure(size, rounds, [&]() {
+        native.clear();
+        native.get_int64s(values.data(), n);
+        sink = sink + values[0];
+    }), base);
+    report("get_int64s big", measure(size, rounds, [&]() {
+        big.clear();
+        big.get_int64s(values.data(), n);
+        sink = sink + values[0];
+    }), base);
+    report("put_int64s native", measure(size, rounds, [&]() {
+        native_out.clear();
+        native_out.put_int64s(values.data(), n);
+        sink = sink + native_out.ptr(0)[0];
+    }), base);
+    report("put_int64s big", measure(size, rounds, [&]() {
+        big_out.clear();
+        big_out.put_int64s(values.data(), n);
+        sink = sink + big_out.ptr(0)[0];
+    }), base);
+
+    // 变长编码按原始int64数组的字节数计算吞吐，数值集中在1至3字节
+    vector<uint64_t> small(n);
+    for ( size_t i = 0; i < n; ++i ) small[i] = (i * 2654435761u) % (i % 4 == 0 ? 1000000 : 200);
+    vector<uint64_t> decoded(n);
+    report("put_varints", measure(size, rounds, [&]() {
+        native_out.clear();
+        native_out.put_varints(small.data(), n);
+        sink = sink + native_out.position();
+    }), base);
+    report("get_varints", measure(size, rounds, [&]() {
+        native_out.rewind();
+        native_out.get_varints(decoded.data(), n);
+        sink = sink + decoded[0];
+    }), base);
+    return 0;
+}
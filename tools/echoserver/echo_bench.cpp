@@ -0,0 +1,309 @@
+#include <mercury/net/network.h>
+#include <mercury/nio/event_loop.h>
+#include "echo_completion.h"
+#include "echo_handler.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+using namespace mercury;
+using namespace std;
+
+/**
+ * @brief 客户端连接状态，一问一答地发送固定长度的消息。
+ */
+struct BenchConnection {
+    nio::StreamSocketChannel ch;
+    size_t received;   // 当前消息已收到的回显字节数
+};
+
+/**
+ * @brief 完成模式的客户端连接，保持一个read_async，回显收齐后以write_async再次发送。
+ */
+class BenchCompletion {
+private:
+    class ReadOp : public nio::Completion {
+    public:
+        BenchCompletion * m_conn;
+        void on_complete(int res, bool more) override { m_conn->on_read(res, more); }
+    };
+
+    class WriteOp : public nio::Completion {
+    public:
+        BenchCompletion * m_conn;
+        void on_complete(int res, bool /*more*/) override { m_conn->on_write(res); }
+    };
+
+    nio::Selector * m_selector;
+    char          * m_msg;
+    size_t          m_size;
+    size_t          m_received;   // 当前消息已收到的回显字节数
+    size_t          m_sent;       // 当前消息已发送的字节数
+    uint64_t      * m_roundtrips;
+    ReadOp          m_read;
+    WriteOp         m_write;
+
+public:
+    nio::StreamSocketChannel ch;
+    bool failed;
+
+    BenchCompletion(nio::Selector *selector, char *msg, size_t size, uint64_t *roundtrips)
+        : m_selector(selector), m_msg(msg), m_size(size), m_received(0), m_sent(0)
+        , m_roundtrips(roundtrips), failed(false)
+    {
+        m_read.m_conn = this;
+        m_write.m_conn = this;
+    }
+
+    bool start(RuntimeError &e) {
+        return ch.read_async(m_selector, &m_read, e) && this->send(e);
+    }
+
+private:
+    bool send(RuntimeError &e) {
+        nio::ByteBuffer out(m_msg + m_sent, m_size - m_sent);
+        return ch.write_async(m_selector, out, &m_write, e);
+    }
+
+    void on_read(int res, bool more) {
+        RuntimeError e;
+        if ( res <= 0 && res != -ENOBUFS ) { failed = true; return; }
+        if ( res > 0 ) m_received += res;
+        if ( m_received == m_size ) {
+            ++*m_roundtrips;
+            m_received = m_sent = 0;
+            if ( !this->send(e) ) failed = true;
+        }
+        if ( !more && !ch.read_async(m_selector, &m_read, e) ) failed = true;
+    }
+
+    void on_write(int res) {
+        RuntimeError e;
+        if ( res < 0 ) { failed = true; return; }
+        m_sent += res;
+        if ( m_sent < m_size && !this->send(e) ) failed = true;
+    }
+}; // end class BenchCompletion
+
+struct BenchResult {
+    double   seconds;
+    uint64_t roundtrips;
+    uint64_t syscalls;   // 客户端和服务端事件接口及receive/send的系统调用次数
+};
+
+/// 压测方式：就绪模式使用EventLoopGroup和EchoHandler，完成模式使用EchoCompletionServer。
+struct BenchMode {
+    const char * name;
+    int          engine;
+    bool         async;
+};
+
+static void print_help(const char * program) {
+    printf("usage: %s [-n threads] [-c conns] [-s size] [-d seconds] [-h]\n", program);
+    printf("  在本进程内分别以epoll、io_uring就绪模式和io_uring完成模式启动回显服务并压测，\n");
+    printf("  比较吞吐和每次往返的系统调用次数。\n");
+    printf("  -n threads  server event loops, default 1\n");
+    printf("  -c conns    client connections, default 64\n");
+    printf("  -s size     message size in bytes, default 64\n");
+    printf("  -d seconds  duration of each run, default 5\n");
+}
+
+static bool run_clients(int engine, int port, size_t nconns, const vector<char> &msg,
+                        int seconds, BenchResult &result, RuntimeError &e)
+{
+    nio::Selector selector;
+    if ( !selector.open(engine, e) ) return false;
+
+    vector<BenchConnection*> conns;
+    bool isok = true;
+    for ( size_t i = 0; isok && i < nconns; ++i ) {
+        BenchConnection * conn = new BenchConnection();
+        conn->received = 0;
+        conns.push_back(conn);
+        net::StreamSocket * sock = conn->ch.socket();
+        isok = sock->create(AF_INET, e) && sock->connect("127.0.0.1", port, e)
+            && sock->set_block_mode(false, e) && conn->ch.reg(&selector, nio::SelectionKey::OpRead, conn, e) != nullptr;
+    }
+
+    vector<char> buf(msg.size());
+    for ( size_t i = 0; isok && i < conns.size(); ++i ) {
+        isok = conns[i]->ch.socket()->send_all(msg.data(), msg.size(), e) == (ssize_t)msg.size();
+    }
+
+    uint64_t roundtrips = 0;
+    uint64_t iocalls = 0;
+    vector<nio::SelectionKey*> keys;
+    auto start = chrono::steady_clock::now();
+    auto deadline = start + chrono::seconds(seconds);
+    while ( isok && chrono::steady_clock::now() < deadline ) {
+        if ( selector.select(100, e) < 0 ) {
+            isok = false;
+            break;
+        }
+        selector.selected_keys(keys);
+        for ( size_t i = 0; isok && i < keys.size(); ++i ) {
+            BenchConnection * conn = (BenchConnection *)keys[i]->attachment();
+            net::StreamSocket * sock = conn->ch.socket();
+            ssize_t r = sock->receive(buf.data(), msg.size() - conn->received, e);
+            ++iocalls;
+            if ( r < 0 ) {
+                isok = false;
+                break;
+            }
+            conn->received += r;
+            if ( conn->received == msg.size() ) {
+                ++roundtrips;
+                ++iocalls;
+                conn->received = 0;
+                isok = sock->send_all(msg.data(), msg.size(), e) == (ssize_t)msg.size();
+            }
+        }
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.roundtrips = roundtrips;
+    result.syscalls = selector.syscalls() + iocalls;
+
+    for ( size_t i = 0; i < conns.size(); ++i ) delete conns[i];
+    RuntimeError ce;
+    if ( !selector.close(ce) && isok ) {
+        e = ce;
+        isok = false;
+    }
+    return isok;
+}
+
+static bool run_async_clients(int port, size_t nconns, const vector<char> &msg,
+                              int seconds, BenchResult &result, RuntimeError &e)
+{
+    nio::Selector selector;
+    if ( !selector.open(nio::Selector::EngineUring, e) ) return false;
+
+    vector<char> out(msg);
+    uint64_t roundtrips = 0;
+    vector<BenchCompletion*> conns;
+    bool isok = true;
+    for ( size_t i = 0; isok && i < nconns; ++i ) {
+        BenchCompletion * conn = new BenchCompletion(&selector, out.data(), out.size(), &roundtrips);
+        conns.push_back(conn);
+        net::StreamSocket * sock = conn->ch.socket();
+        isok = sock->create(AF_INET, e) && sock->connect("127.0.0.1", port, e)
+            && sock->set_block_mode(false, e) && conn->start(e);
+    }
+
+    auto start = chrono::steady_clock::now();
+    auto deadline = start + chrono::seconds(seconds);
+    while ( isok && chrono::steady_clock::now() < deadline ) {
+        if ( selector.select(100, e) < 0 ) isok = false;
+        for ( size_t i = 0; isok && i < conns.size(); ++i ) {
+            if ( conns[i]->failed ) {
+                e.set(-1, "echo connection failed", "run_async_clients");
+                isok = false;
+            }
+        }
+    }
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    result.roundtrips = roundtrips;
+    result.syscalls = selector.syscalls();
+
+    // 先关闭Selector结束未完成的请求，再释放连接。
+    RuntimeError ce;
+    if ( !selector.close(ce) && isok ) {
+        e = ce;
+        isok = false;
+    }
+    for ( size_t i = 0; i < conns.size(); ++i ) delete conns[i];
+    return isok;
+}
+
+static bool run_async(size_t nthreads, size_t nconns, const vector<char> &msg,
+                      int seconds, BenchResult &result, RuntimeError &e)
+{
+    vector<EchoCompletionServer*> servers;
+    bool isok = true;
+    int port = 0;
+    for ( size_t i = 0; isok && i < nthreads; ++i ) {
+        EchoCompletionServer * server = new EchoCompletionServer();
+        servers.push_back(server);
+        isok = server->open("127.0.0.1", port, e) && server->start(e);
+        if ( i == 0 ) port = server->listen_port();
+    }
+
+    if ( isok ) isok = run_async_clients(port, nconns, msg, seconds, result, e);
+
+    for ( size_t i = 0; i < servers.size(); ++i ) servers[i]->stop();
+    for ( size_t i = 0; i < servers.size(); ++i ) {
+        servers[i]->join();
+        result.syscalls += servers[i]->syscalls();
+        delete servers[i];
+    }
+    return isok;
+}
+
+static bool run_engine(int engine, size_t nthreads, size_t nconns, const vector<char> &msg,
+                       int seconds, BenchResult &result, RuntimeError &e)
+{
+    EchoHandler handler;
+    nio::EventLoopGroup group;
+    group.engine(engine);
+    if ( !group.open(nthreads, AF_INET, "127.0.0.1", 0, &handler, e) || !group.start(e) ) return false;
+
+    bool isok = run_clients(engine, group.loop(0)->listen_port(), nconns, msg, seconds, result, e);
+
+    group.stop();
+    group.join();
+    result.syscalls += handler.io_calls();
+    for ( size_t i = 0; i < group.size(); ++i ) result.syscalls += group.loop(i)->selector().syscalls();
+    EchoHandler::release(group);
+    group.close(e);
+    return isok;
+}
+
+int main(int argc, char **argv)
+{
+    size_t nthreads = 1;
+    size_t nconns = 64;
+    size_t size = 64;
+    int    seconds = 5;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:c:s:d:h")) != -1) {
+        switch (opt) {
+            case 'n': nthreads = (size_t)atoi(optarg); break;
+            case 'c': nconns = (size_t)atoi(optarg); break;
+            case 's': size = (size_t)atoi(optarg); break;
+            case 'd': seconds = atoi(optarg); break;
+            default:  print_help(argv[0]); return 0;
+        }
+    }
+    if ( size == 0 || size > sizeof(((EchoConnection*)0)->buf) ) size = 64;
+    signal(SIGPIPE, SIG_IGN);
+
+    vector<char> msg(size, 'm');
+    const BenchMode modes[] = {
+        { "epoll",    nio::Selector::EngineEpoll, false },
+        { "uring",    nio::Selector::EngineUring, false },
+        { "uring-cq", nio::Selector::EngineUring, true  },
+    };
+
+    printf("threads: %zu, connections: %zu, message: %zu bytes, duration: %d s\n", nthreads, nconns, size, seconds);
+    printf("%-10s %14s %12s %12s\n", "engine", "roundtrips/s", "MB/s", "syscalls/rt");
+    for ( size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i ) {
+        RuntimeError e;
+        BenchResult result = {};
+        bool isok = modes[i].async ? run_async(nthreads, nconns, msg, seconds, result, e)
+                                   : run_engine(modes[i].engine, nthreads, nconns, msg, seconds, result, e);
+        if ( !isok ) {
+            printf("%-10s failed\n", modes[i].name);
+            cerr<<e.str()<<endl;
+            continue;
+        }
+        double rate = result.roundtrips / result.seconds;
+        double calls = result.roundtrips ? (double)result.syscalls / result.roundtrips : 0;
+        printf("%-10s %14.0f %12.2f %12.2f\n", modes[i].name, rate, rate * size * 2 / (1024.0 * 1024.0), calls);
+    }
+    return 0;
+}
@@ -0,0 +1,199 @@
+#pragma once
+#include <mercury/nio/channel.h>
+#include <mercury/nio/selector.h>
+
+#include <atomic>
+#include <iostream>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <string.h>
+#include <unistd.h>
+
+class EchoCompletionServer;
+
+/**
+ * @brief 完成模式的一个回显连接，读到的数据追加到buf，没有未完成的写出时提交write_async。
+ * 出错或对端关闭时关闭通道，读写请求都结束后释放自身，之后不能再访问。
+ */
+class EchoCompletionConnection {
+private:
+    class ReadOp : public mercury::nio::Completion {
+    public:
+        EchoCompletionConnection * m_conn;
+        void on_complete(int res, bool more) override { m_conn->on_read(res, more); }
+    };
+
+    class WriteOp : public mercury::nio::Completion {
+    public:
+        EchoCompletionConnection * m_conn;
+        void on_complete(int res, bool /*more*/) override { m_conn->on_write(res); }
+    };
+
+    EchoCompletionServer           * m_server;
+    mercury::nio::StreamSocketChannel m_ch;
+    ReadOp   m_read;
+    WriteOp  m_write;
+    char     m_buf[4096];
+    size_t   m_len;    // 待回写的数据长度
+    size_t   m_off;    // 已回写的数据长度
+
+public:
+    EchoCompletionConnection(EchoCompletionServer *server) : m_server(server), m_len(0), m_off(0) {
+        m_read.m_conn = this;
+        m_write.m_conn = this;
+    }
+    ~EchoCompletionConnection();
+
+    bool start(int fd, mercury::RuntimeError &e);
+
+private:
+    void on_read(int res, bool more);
+    void on_write(int res);
+    bool flush();
+    void shutdown();
+}; // end class EchoCompletionConnection
+
+/**
+ * @brief 完成模式的回显服务，单线程，一个Selector和一个SO_REUSEPORT监听通道，
+ * 连接的接受、读取和回写都以异步请求提交，select之外没有accept/recv/send系统调用。
+ */
+class EchoCompletionServer : public mercury::nio::Completion {
+private:
+    mercury::nio::Selector           m_selector;
+    mercury::nio::ServerSocketChannel m_server;
+    std::set<EchoCompletionConnection*> m_conns;
+    std::thread       m_thread;
+    std::atomic<bool> m_running;
+
+    friend class EchoCompletionConnection;
+
+public:
+    EchoCompletionServer() : m_running(false) {}
+    ~EchoCompletionServer() { mercury::RuntimeError e; this->close(e); }
+
+    bool open(const char *addr, int port, mercury::RuntimeError &e) {
+        if ( !m_selector.open(mercury::nio::Selector::EngineUring, e) ) return false;
+        if ( !m_server.create(AF_INET, e) ) return false;
+        mercury::net::ServerSocket * sock = m_server.socket();
+        if ( !sock->set_reuse_addr(1, e) || !sock->set_reuse_port(1, e) ) return false;
+        if ( !m_server.bind(addr, port, e) || !m_server.listen(1024, e) ) return false;
+        return m_server.accept_async(&m_selector, this, e);
+    }
+
+    bool start(mercury::RuntimeError &e) {
+        m_running = true;
+        try {
+            m_thread = std::thread(&EchoCompletionServer::run, this);
+        } catch ( std::system_error &ex ) {
+            m_running = false;
+            std::string msg = std::string("start server thread error, ") + ex.what();
+            e.set(-1, msg.c_str(), "EchoCompletionServer::start");
+            return false;
+        }
+        return true;
+    }
+
+    void stop() {
+        if ( m_running.exchange(false) ) m_selector.wakeup();
+    }
+
+    void join() {
+        if ( m_thread.joinable() ) m_thread.join();
+    }
+
+    /// 关闭Selector时未结束的请求以-ECANCELED结束，连接随之自行释放，余下的连接在之后释放。
+    bool close(mercury::RuntimeError &e) {
+        bool isok = m_server.close(e);
+        isok = m_selector.close(e) && isok;
+        std::set<EchoCompletionConnection*> conns;
+        conns.swap(m_conns);
+        for ( auto it = conns.begin(); it != conns.end(); ++it ) delete *it;
+        return isok;
+    }
+
+    int      listen_port() { mercury::RuntimeError e; return m_server.socket()->local_port(e); }
+    uint64_t syscalls() const { return m_selector.syscalls(); }
+
+    /// 新连接，res为连接的fd。
+    void on_complete(int res, bool /*more*/) override {
+        mercury::RuntimeError e;
+        if ( res >= 0 ) {
+            EchoCompletionConnection * conn = new EchoCompletionConnection(this);
+            m_conns.insert(conn);
+            if ( !conn->start(res, e) ) {
+                std::cerr<<e.str()<<std::endl;
+                delete conn;
+            }
+        } else if ( res != -ECANCELED ) {
+            std::cerr<<"accept error: "<<strerror(-res)<<std::endl;
+        }
+        // 出错结束时不立即重新提交，以免资源耗尽时空转，只在下一次select前恢复。
+    }
+
+private:
+    void run() {
+        mercury::RuntimeError e;
+        while ( m_running ) {
+            if ( !this->is_pending() && !m_server.socket()->is_closed() && !m_server.accept_async(&m_selector, this, e) ) break;
+            if ( m_selector.select(100, e) < 0 ) break;
+        }
+        if ( m_running ) std::cerr<<e.str()<<std::endl;
+    }
+}; // end class EchoCompletionServer
+
+inline EchoCompletionConnection::~EchoCompletionConnection() {
+    m_server->m_conns.erase(this);
+}
+
+inline bool EchoCompletionConnection::start(int fd, mercury::RuntimeError &e) {
+    if ( !m_server->m_server.adopt(fd, m_ch, e) ) {
+        ::close(fd);
+        return false;
+    }
+    return m_ch.read_async(&m_server->m_selector, &m_read, e);
+}
+
+inline void EchoCompletionConnection::on_read(int res, bool more) {
+    bool isok = true;
+    if ( res > 0 ) {
+        if ( m_len + res > sizeof(m_buf) ) {   // 对端不等回显持续发送
+            isok = false;
+        } else {
+            memcpy(m_buf + m_len, m_read.data(), res);
+            m_len += res;
+            if ( !m_write.is_pending() ) isok = this->flush();
+        }
+    }
+    if ( isok && more ) return;
+    // 缓存环暂时耗尽时重新提交，对端关闭或异常时关闭连接。
+    mercury::RuntimeError e;
+    if ( isok && (res > 0 || res == -ENOBUFS) && m_ch.read_async(&m_server->m_selector, &m_read, e) ) return;
+    this->shutdown();
+}
+
+inline void EchoCompletionConnection::on_write(int res) {
+    if ( res >= 0 && !m_ch.is_closed() ) {
+        m_off += res;
+        if ( m_off == m_len ) {
+            m_len = m_off = 0;
+            return;
+        }
+        if ( this->flush() ) return;
+    }
+    this->shutdown();
+}
+
+inline bool EchoCompletionConnection::flush() {
+    mercury::RuntimeError e;
+    mercury::nio::ByteBuffer out(m_buf + m_off, m_len - m_off);
+    return m_ch.write_async(&m_server->m_selector, out, &m_write, e);
+}
+
+/// 关闭通道取消未结束的请求，被取消的请求回调后再释放。
+inline void EchoCompletionConnection::shutdown() {
+    mercury::RuntimeError e;
+    if ( !m_ch.is_closed() ) m_ch.close(e);
+    if ( !m_read.is_pending() && !m_write.is_pending() ) delete this;
+}
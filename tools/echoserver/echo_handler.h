@@ -0,0 +1,81 @@
+#pragma once
+#include <mercury/nio/event_loop.h>
+
+#include <atomic>
+#include <iostream>
+
+/**
+ * @brief 一个连接的回显状态，作为SelectionKey的附件。
+ */
+struct EchoConnection {
+    mercury::nio::StreamSocketChannel * ch;
+    char   buf[4096];
+    size_t len;    // 待回写的数据长度
+    size_t off;    // 已回写的数据长度
+
+    EchoConnection(mercury::nio::StreamSocketChannel *c) : ch(c), len(0), off(0) {}
+    ~EchoConnection() { mercury::RuntimeError e; ch->close(e); delete ch; }
+};
+
+/**
+ * @brief 回显处理，读到的数据原样写回，未写完时暂停读取等待可写。
+ */
+class EchoHandler : public mercury::nio::EventHandler {
+private:
+    std::atomic<uint64_t> m_iocalls;   // receive/send的调用次数
+
+public:
+    EchoHandler() : m_iocalls(0) {}
+
+    uint64_t io_calls() const { return m_iocalls.load(std::memory_order_relaxed); }
+
+    virtual void on_accept(mercury::nio::EventLoop &loop, mercury::nio::StreamSocketChannel *ch) {
+        mercury::RuntimeError e;
+        EchoConnection * conn = new EchoConnection(ch);
+        if ( ch->reg(&loop.selector(), mercury::nio::SelectionKey::OpRead, conn, e) == nullptr ) {
+            std::cerr<<e.str()<<std::endl;
+            delete conn;
+        }
+    }
+
+    virtual void on_select(mercury::nio::EventLoop &/*loop*/, mercury::nio::SelectionKey *key) {
+        using mercury::nio::SelectionKey;
+        EchoConnection * conn = (EchoConnection *)key->attachment();
+        mercury::net::StreamSocket * sock = conn->ch->socket();
+        mercury::RuntimeError e;
+
+        if ( key->is_readable() && conn->len == 0 ) {
+            m_iocalls.fetch_add(1, std::memory_order_relaxed);
+            ssize_t r = sock->receive(conn->buf, sizeof(conn->buf), e);
+            if ( r < 0 ) { delete conn; return; }     // 对端关闭或异常
+            conn->len = r;
+            conn->off = 0;
+        }
+
+        if ( conn->off < conn->len ) {
+            m_iocalls.fetch_add(1, std::memory_order_relaxed);
+            ssize_t r = sock->send(conn->buf + conn->off, conn->len - conn->off, e);
+            if ( r < 0 ) { delete conn; return; }
+            conn->off += r;
+        }
+
+        // 未写完时等待可写，写完后恢复读取。
+        if ( conn->off < conn->len ) {
+            key->interest_ops(SelectionKey::OpWrite);
+        } else {
+            conn->len = conn->off = 0;
+            key->interest_ops(SelectionKey::OpRead);
+        }
+    }
+
+    /// 释放EventLoop停止后仍存活的连接。
+    static void release(mercury::nio::EventLoopGroup &group) {
+        for ( size_t i = 0; i < group.size(); ++i ) {
+            std::vector<mercury::nio::SelectionKey*> keys;
+            group.loop(i)->selector().keys(keys);
+            for ( size_t k = 0; k < keys.size(); ++k ) {
+                if ( keys[k]->attachment() ) delete (EchoConnection *)keys[k]->attachment();
+            }
+        }
+    }
+}; // end class EchoHandler
@@ -1,35 +1,66 @@
 #include <mercury/net/network.h>
-#include <mercury/nio/channel.h>
-#include <mercury/core/integer.h>
+#include <mercury/nio/event_loop.h>
+#include "echo_handler.h"
 
 #include <cassert>
 #include <iostream>
+#include <signal.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 using namespace mercury;
 using namespace std;
 
+static void print_help(const char * program) {
+    printf("usage: %s [-p port] [-n threads] [-e epoll|uring] [-h]\n", program);
+    printf("  -p port     listen port, default 10024\n");
+    printf("  -n threads  number of event loops, default cpu cores\n");
+    printf("  -e engine   selector engine, epoll(default) or uring\n");
+}
+
 int main(int argc, char **argv) 
 {
-    RuntimeError e;
-    
-    // 创建监听channel。
-    nio::ServerSocketChannel server;
-    bool isok = server.create(AF_INET, e);
-    if ( !isok ) {
-        cerr<<e.str()<<endl;
-        return -1;
+    int    port = 10024;
+    size_t nthreads = 0;
+    int    engine = nio::Selector::EngineEpoll;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:n:e:h")) != -1) {
+        switch (opt) {
+            case 'p': port = atoi(optarg); break;
+            case 'n': nthreads = (size_t)atoi(optarg); break;
+            case 'e': engine = strcmp(optarg, "uring") == 0 ? nio::Selector::EngineUring : nio::Selector::EngineEpoll; break;
+            default:  print_help(argv[0]); return 0;
+        }
     }
 
-    // 创建选择器
-    nio::Selector selector;
-    isok = selector.open(e);
-    if ( !isok ) {
+    // 工作线程继承信号屏蔽，退出信号只由主线程等待。
+    sigset_t sigs;
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigs, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+
+    RuntimeError e;
+    EchoHandler handler;
+    nio::EventLoopGroup group;
+    group.engine(engine);
+    if ( !group.open(nthreads, AF_INET, "0.0.0.0", port, &handler, e) || !group.start(e) ) {
         cerr<<e.str()<<endl;
         return -1;
     }
+    cout<<"echo server listening on port "<<port<<" with "<<group.size()<<" event loops, engine: "
+        <<(engine == nio::Selector::EngineUring ? "uring" : "epoll")<<endl;
+
+    int sig;
+    sigwait(&sigs, &sig);
+
+    group.stop();
+    group.join();
 
-    selector.close(e);
-    server.close(e);
+    EchoHandler::release(group);
+    group.close(e);
     return 0;
 }